@@ -0,0 +1,64 @@
+#! /bin/bash
+
+# Benchmark of allocators of the tape (see --tape-allocator) on scan-heavy
+# and stride-heavy programs. Build the program with build.sh first.
+#
+# scan   - sweeps over SCAN_CELLS contiguous cells
+# stride - sweeps over STRIDE_HOPS cells, one per STRIDE_STEP cells (one page
+#          and one cache line), so every access is in its own page
+
+export BIN_FILENAME="${BIN_FILENAME:-./brainloller}"
+export WORK_DIR="${WORK_DIR:-/tmp/brainloller-bench}"
+export ENGINE="${ENGINE:-compiled}"
+export ALLOCATORS="${ALLOCATORS:-default aligned hugepages hugetlb}"
+export TAPE_SIZE="${TAPE_SIZE:-67108864}"
+export SCAN_CELLS="${SCAN_CELLS:-1048576}"
+export STRIDE_STEP="${STRIDE_STEP:-4160}"
+export STRIDE_HOPS="${STRIDE_HOPS:-2048}"
+export OUTER="${OUTER:-16}"
+export INNER="${INNER:-16}"
+
+if [ ! -x "${BIN_FILENAME}" ]; then
+    echo "ERROR! ${BIN_FILENAME} not found (run build.sh)"
+    exit 1
+fi
+
+mkdir -p "${WORK_DIR}/cache"
+
+# repeat STRING COUNT
+repeat() {
+    yes "$1" | head -n "$2" | tr -d '\n'
+}
+
+# program NAME UNIT COUNT BACK: OUTER * INNER sweeps of COUNT units and BACK steps back
+program() {
+    {
+        repeat "+" "${OUTER}"
+        echo -n "[>"
+        repeat "+" "${INNER}"
+        echo -n "[>"
+        repeat "$2" "$3"
+        repeat "<" "$4"
+        echo -n "<-]<-]"
+    } > "${WORK_DIR}/$1.b"
+
+    ${BIN_FILENAME} -f "${WORK_DIR}/$1.b" --encode="${WORK_DIR}/$1.png" --cell-size=1 || exit 1
+}
+
+program scan "+>" "${SCAN_CELLS}" "${SCAN_CELLS}"
+program stride "+$(repeat ">" "${STRIDE_STEP}")" "${STRIDE_HOPS}" $((STRIDE_STEP * STRIDE_HOPS))
+
+TIMEFORMAT="%R"
+printf "%-8s %-10s %s\n" "PROGRAM" "ALLOCATOR" "SECONDS"
+for p in scan stride; do
+    # RU: Первый запуск только заполняет кэш программ, чтобы не мерить декодирование
+    ${BIN_FILENAME} -e "${ENGINE}" -f "${WORK_DIR}/${p}.png" --cell-size=1 --cache-dir="${WORK_DIR}/cache" \
+                    --tape-size="${TAPE_SIZE}" --max-instructions=1 > /dev/null 2>&1
+
+    for a in ${ALLOCATORS}; do
+        t=$( { time ${BIN_FILENAME} -e "${ENGINE}" -f "${WORK_DIR}/${p}.png" --cell-size=1 \
+                    --cache-dir="${WORK_DIR}/cache" --tape-size="${TAPE_SIZE}" \
+                    --tape-allocator="${a}" ${NUMA:+--numa} > /dev/null; } 2>&1 )
+        printf "%-8s %-10s %s\n" "${p}" "${a}" "${t}"
+    done
+done
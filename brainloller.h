@@ -0,0 +1,138 @@
+// *****************************************************************************
+// Program: Brainloller - interpretator of Brainfuck/Brainloller
+// Filename: brainloller.h
+// Description: The library of the interpretator (libbrainloller, see build.sh):
+//              programs are compiled from memory and run with callbacks or buffers
+//              in the process of the caller
+// Programmers: Vasiliy V. Bodrov aka Bodro and Denis Evgrafov
+// Date: the 31-th of October, 2016 year
+// *****************************************************************************
+// The MIT License (MIT)
+//
+// Copyright (c) 2016 Vasiliy V. Bodrov aka Bodro and Denis Evgrafov, Ryazan, Russia
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the "Software"),
+// Software is furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included
+// in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+// OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+// IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+// CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT
+// OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+// THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+// *****************************************************************************
+
+#ifndef BRAINLOLLER_H
+#define BRAINLOLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// @brief Results of brainloller_run (the same as exit status of the program)
+///
+///
+enum brainloller_status {
+	BRAINLOLLER_OK = 0,
+	BRAINLOLLER_ERROR = 1,             // Wrong program (see brainloller_error)
+	BRAINLOLLER_INSTRUCTION_LIMIT = 3, // Stopped by max_instructions
+	BRAINLOLLER_TIME_LIMIT = 4,        // Stopped by max_time
+	BRAINLOLLER_INFINITE_LOOP = 5,     // Stopped by hang_check
+	BRAINLOLLER_OUTPUT_REFUSED = 6,    // The output callback failed or the output buffer is full
+	BRAINLOLLER_TAPE_BOUNDS = 7        // Stopped by checked: the head is out of the tape
+};
+
+/// @brief Compiled program with its tape (one run at a time, may be run many times)
+///
+///
+typedef struct brainloller_machine brainloller_machine;
+
+/// @brief Options of brainloller_compile_* (see brainloller_default_options)
+///
+/// @note The same as options of the command line with the same names.
+typedef struct brainloller_options {
+	char const* engine;        // "reference", "compiled", "threaded" or "tiered"
+	char const* output_type;   // "null", "char", "hex" or "both"
+	uint32_t cell_size;        // Pixels of the side of the cell of the image
+	uint64_t tape_size;        // Cells of the tape (at most 2^32)
+	uint64_t max_instructions; // Zero - no limit
+	uint64_t max_time;         // Milliseconds of one run, zero - no limit
+	int hang_check;            // Stop loops which provably never end (compiled engines)
+	uint64_t prefix_budget;    // Steps of partial evaluation (zero - disabled)
+	uint32_t jit_threshold;    // Back-edges of loop before native compilation ("tiered")
+	char const* cache_dir;     // Directory of compiled programs (NULL - no cache)
+	int checked;               // Stop the program when the head leaves the tape (untrusted images)
+} brainloller_options;
+
+/// @brief Counters of the last run
+///
+///
+typedef struct brainloller_stats {
+	uint64_t executed;    // Instructions
+	uint64_t back_edges;  // Loop iterations
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+	uint64_t tape_extent; // Cells up to the last used one
+} brainloller_stats;
+
+/// @brief Give up to size bytes of the input (zero - end of the input)
+///
+///
+typedef size_t (*brainloller_read_t)(void* user, unsigned char* data, size_t size);
+
+/// @brief Take all bytes of the output (non-zero - stop the run)
+///
+///
+typedef int (*brainloller_write_t)(void* user, unsigned char const* data, size_t size);
+
+/// @brief
+///
+///
+void brainloller_default_options(brainloller_options* options);
+
+/// @brief Compile the encoded image (PNG, BMP etc) from memory (NULL - wrong image or options)
+///
+///
+brainloller_machine* brainloller_compile_image(void const* data, size_t size, brainloller_options const* options);
+
+/// @brief Compile the image from rows of RGB pixels (NULL - wrong image or options)
+///
+/// @note stride is bytes from the start of one row to the start of the next one.
+brainloller_machine* brainloller_compile_rgb(void const* pixels, uint32_t width, uint32_t height, size_t stride,
+											 brainloller_options const* options);
+
+/// @brief Run the program: the input and the output are bare bytes (no prompts)
+///
+/// @note read or write can be NULL: no input, output is dropped. stats can be NULL.
+int brainloller_run(brainloller_machine* machine, brainloller_read_t read, brainloller_write_t write, void* user,
+					brainloller_stats* stats);
+
+/// @brief Run the program with the input and the output in memory
+///
+/// @note The output is cut at output_size bytes (BRAINLOLLER_OUTPUT_REFUSED).
+int brainloller_run_buffers(brainloller_machine* machine, void const* input, size_t input_size,
+							void* output, size_t output_size, size_t* written, brainloller_stats* stats);
+
+/// @brief Message of the last failed run (empty - no error)
+///
+///
+char const* brainloller_error(brainloller_machine const* machine);
+
+/// @brief
+///
+///
+void brainloller_free(brainloller_machine* machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BRAINLOLLER_H
@@ -2,18 +2,31 @@
 
 export SRC_FILENAME="main.cpp"
 export BIN_FILENAME="brainloller"
+export LIB_FILENAME="libbrainloller.so"
 
 if [ -f "${BIN_FILENAME}" ]; then
     rm -f ${BIN_FILENAME}
 fi
+
+if [ -f "${LIB_FILENAME}" ]; then
+    rm -f ${LIB_FILENAME}
+fi
    
-g++ -std=c++14 -Wall -Wextra -gdwarf-4 \
+g++ -std=c++14 -Wall -Wextra -gdwarf-4 -pthread \
     ${SRC_FILENAME} \
     `pkg-config --cflags opencv` \
     `pkg-config --libs opencv` \
     -o ${BIN_FILENAME}
 
-if [ -f "${BIN_FILENAME}" ]; then
+# The library (see brainloller.h): the same source without main() and the command line
+g++ -std=c++14 -Wall -Wextra -gdwarf-4 -pthread \
+    -fPIC -shared -DBRAINLOLLER_LIBRARY \
+    ${SRC_FILENAME} \
+    `pkg-config --cflags opencv` \
+    `pkg-config --libs opencv` \
+    -o ${LIB_FILENAME}
+
+if [ -f "${BIN_FILENAME}" ] && [ -f "${LIB_FILENAME}" ]; then
     echo "OK!"
     ./${BIN_FILENAME} --help
 else
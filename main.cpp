@@ -33,22 +33,36 @@
 #include <cassert>
 #include <cerrno>
 #include <cstring>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <csignal>
 
 // Includes: standard C++-headers
 #include <iostream>
+#include <fstream>
 #include <sstream>
 #include <ios>
 #include <iomanip>
 #include <new>
 #include <memory>
 #include <string>
+#include <list>
 #include <map>
 #include <vector>
 #include <stack>
 #include <iterator>
+#include <initializer_list>
 #include <algorithm>
 #include <exception>
+#include <typeinfo>
 #include <functional>
+#include <chrono>
+#include <limits>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 // Includes: Boost C++-headers (different)
 #include <boost/cstdint.hpp>
@@ -61,8 +75,27 @@
 // Include system C/C++-headers
 #include <getopt.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <poll.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <sys/inotify.h>
+#include <linux/perf_event.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
+// Includes: the library
+#include "brainloller.h"
+
+#if !defined(BRAINLOLLER_LIBRARY)
 int main(int argc, char** argv);
+#endif // !defined(BRAINLOLLER_LIBRARY)
 
 #ifndef UNUSED_SUPPRESSOR
 #define UNUSED_SUPPRESSOR(x) do { utils::__unused_suppressor__(x); } while(0)
@@ -80,1031 +113,9800 @@ namespace {
 		
 		template<typename T>
 		void __unused_suppressor__(T const& x) { (void) x; }
-	} // namespace utils
-
-	// *************************************************************************
-	// Common constants
-	// *************************************************************************
 
-	std::string const PRINTER_TYPE_NULL = std::string("null");
-	std::string const PRINTER_TYPE_SIMPLE = std::string("simple");
-	std::string const PRINTER_TYPE_SIMPLE_SPACE = std::string("simplespace");
-	std::string const PRINTER_TYPE_CLASSIC_BRAINFUCK = std::string("brainfuck");
+		/// @brief FNV-1a hash (64 bits)
+		///
+		///
+		inline boost::uint64_t fnv1a(void const* data, std::size_t size,
+									 boost::uint64_t hash = 0xCBF29CE484222325ULL) noexcept {
+			boost::uint8_t const* p = static_cast<boost::uint8_t const*>(data);
 
-	std::string const OUTPUT_TYPE_NULL = std::string("null");
-	std::string const OUTPUT_TYPE_CHAR = std::string("char");
-	std::string const OUTPUT_TYPE_HEX = std::string("hex");
-	std::string const OUTPUT_TYPE_BOTH = std::string("both");
-	
-	std::string const LANGUAGE_BRAINLOLLER = std::string("brainloller");
-	std::string const LANGUAGE_BRAINFUCK = std::string("brainfuck");
+			for(std::size_t i = 0; i < size; i++) {
+				hash ^= p[i];
+				hash *= 0x00000100000001B3ULL;
+			}
 
-	// *************************************************************************
-	// Functions etc for program's arguments
-	// *************************************************************************
-	
-	void usage(void) noexcept;
-	void help() noexcept;
-	void license() noexcept;
-	void authors() noexcept;
-	void version() noexcept;
+			return hash;
+		}
 
-	const char* PROG_NAME = "brainloller";
-	const char* PROG_NAME_FULL = "Interpretator of Brainfuck/Brainloller";
-	const char* PROG_VERSION = "0.7";
-	const char* PROG_AUTHORS = "Vasiliy V. Bodrov aka Bodro (bodro-mail@list.ru) and Denis Evgrafov";
-	const char* PROG_LICENSE = ""		\
-    "The MIT License (MIT)\n"\
-    "\n"\
-    "Copyright (c) 2016 Vasiliy V. Bodrov aka Bodro and Denis Evgrafov, Ryazan, Russia\n"\
-    "\n"\
-    "Permission is hereby granted, free of charge, to any person obtaining a\n"\
-    "copy of this software and associated documentation files (the \"Software\"),\n"\
-    "Software is furnished to do so, subject to the following conditions:\n"\
-    "\n"\
-    "The above copyright notice and this permission notice shall be included\n"\
-    "in all copies or substantial portions of the Software.\n"\
-    "\n"\
-    "THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS\n"\
-    "OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF\n"\
-    "MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.\n"\
-    "IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY\n"\
-    "CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT\n"\
-    "OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR\n"\
-    "THE USE OR OTHER DEALINGS IN THE SOFTWARE.\n";
+		/// @brief Read the whole file (false - file can't be read)
+		///
+		///
+		inline bool read_file(std::string const& filename, std::string& data) {
+			std::ifstream f(filename.c_str(), std::ios::binary);
+			std::ostringstream oss;
 
-	struct configuration {
-	public:
-		/* Fields (direct access) */
-		int global_argc;
-		char const* const* global_argv;
-		int flag_show_help;
-		int flag_show_version;
-		int flag_show_authors;
-		int flag_show_license;
-		int flag_show_variable;
-		int flag_show_variable_stop;
-		std::string filename;
-		std::string printer_type;
-		std::string output_type;
-		std::string language;
-		int flag_run;
-		int flag_print;
-		std::list<std::string> operands;
+			oss << f.rdbuf();
+			data = oss.str();
 
-		/* Methods */
-		inline void set_flag_show_help(char const* value) {
-			this->flag_show_help = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_show_version(char const* value) {
-			this->flag_show_version = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_show_authors(char const* value) {
-			this->flag_show_authors = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_show_license(char const* value) {
-			this->flag_show_license = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_show_variable(char const* value) {
-			this->flag_show_variable = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_show_variable_stop(char const* value) {
-			this->flag_show_variable_stop = boost::lexical_cast<int>(value);
-		}
-		inline void set_filename(char const* value) {
-			this->filename = boost::lexical_cast<std::string>(value);
-		}
-		inline void set_printer_type(char const* value) {
-			this->printer_type = boost::lexical_cast<std::string>(value);
-		}
-		inline void set_output_type(char const* value) {
-			this->output_type = boost::lexical_cast<std::string>(value);
-		}
-		inline void set_language(char const* value) {
-			this->language = boost::lexical_cast<std::string>(value);
-		}
-		inline void set_flag_run(char const* value) {
-			this->flag_run = boost::lexical_cast<int>(value);
-		}
-		inline void set_flag_print(char const* value) {
-			this->flag_print = boost::lexical_cast<int>(value);
-		}
-		inline void set_operands(char const* value) {
-		std::istringstream iss(value);
-		std::copy(std::istream_iterator<std::string>(iss),
-				  std::istream_iterator<std::string>(),
-				  std::back_inserter(this->operands));
+			return static_cast<bool>(f);
 		}
-		inline configuration(void) :
-			global_argc(0),
-			global_argv(nullptr),
-			flag_show_help(0),
-			flag_show_version(0),
-			flag_show_authors(0),
-			flag_show_license(0),
-			flag_show_variable(0),
-			flag_show_variable_stop(0),
-			filename(),
-			printer_type(PRINTER_TYPE_CLASSIC_BRAINFUCK),
-			output_type(OUTPUT_TYPE_CHAR),
-			language(LANGUAGE_BRAINLOLLER),
-			flag_run(1),
-			flag_print(0),
-			operands()
-			{}
-		inline ~configuration(void) {
-			this->global_argc = 0;
-			this->global_argv = nullptr;
-			this->flag_show_help = 0;
-			this->flag_show_version = 0;
-			this->flag_show_authors = 0;
-			this->flag_show_license = 0;
-			this->flag_show_variable = 0;
-			this->flag_show_variable_stop = 0;
-			this->filename.clear();
-			this->printer_type.clear();
-			this->output_type.clear();
-			this->language.clear();
-			this->flag_run = 0;
-			this->flag_print = 0;
-			this->operands.clear();
+
+		/// @brief Quoted JSON string
+		///
+		///
+		inline std::string json_string(std::string const& value) {
+			std::ostringstream oss;
+
+			oss << '"';
+			std::for_each(value.begin(), value.end(), [&oss](char c)->void {
+					if(c == '"' || c == '\\') {
+						oss << '\\' << c;
+					}
+					else if(static_cast<unsigned char>(c) < 0x20) {
+						oss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+							<< static_cast<int>(c) << std::dec << std::setfill(' ');
+					}
+					else {
+						oss << c;
+					}
+				});
+			oss << '"';
+
+			return oss.str();
 		}
-	};
-		
-	typedef struct environment_names_s {
-		const char* name;
-		std::function<void(char const*)> setter;
-	} environment_names_t;
 
-	extern char** environ;
+		/// @brief Writer of binary files (little-endian, independent of host)
+		///
+		///
+		class BinaryWriter {
+		public:
+			BinaryWriter(void) : buffer() {}
 
-	configuration config;
+			void put_u8(boost::uint8_t value) {
+				this->buffer.push_back(static_cast<char>(value));
+			}
 
-	option longopts[] = {
-		{"help",                no_argument,       &config.flag_show_help,          0x01}, // 'h'
-		{"version",             no_argument,       &config.flag_show_version,       0x01}, // 'v'
-		{"authors",             no_argument,       &config.flag_show_authors,       0x01}, // none
-		{"license",             no_argument,       &config.flag_show_license,       0x01}, // 'l'
-		{"file",                required_argument, 0,                               'f' }, // 'f'
-		{"show-variable",       no_argument,       &config.flag_show_variable,      0x01}, // 's'
-		{"show-variable-stop",  no_argument,       &config.flag_show_variable_stop, 0x01}, // none
-		{"set-printer-type",    no_argument,       0,                               'p'},  // 'p'
-		{"set-output-type",     no_argument,       0,                               'o'},  // 'o'
-		{"language",            no_argument,       0,                               'i'},  // 'i'
-		{"run",                 no_argument,       &config.flag_run, 0x01},                // none
-		{"no-run",              no_argument,       &config.flag_run, 0x00},                // none
-		{"print",               no_argument,       &config.flag_print, 0x01},              // none
-		{"no-print",            no_argument,       &config.flag_print, 0x00},              // none
-		{0,          0,                 0,                                          0x00}  // end
-	};
+			void put_u32(boost::uint32_t value) {
+				for(int i = 0; i < 4; i++) {
+					this->put_u8(static_cast<boost::uint8_t>(value >> (i * 8)));
+				}
+			}
 
-	environment_names_t env_names[] = {
-		{"BRAINLOLLER_FLAG_SHOW_HELP",          boost::bind(&configuration::set_flag_show_help, &config, _1)},
-		{"BRAINLOLLER_FLAG_SHOW_VERSION",       boost::bind(&configuration::set_flag_show_version, &config, _1)},
-		{"BRAINLOLLER_FLAG_SHOW_AUTHORS",       boost::bind(&configuration::set_flag_show_authors, &config, _1)},
-		{"BRAINLOLLER_FLAG_SHOW_LICENSE",       boost::bind(&configuration::set_flag_show_variable, &config, _1)},
-		{"BRAINLOLLER_FLAG_SHOW_VARIABLE",      boost::bind(&configuration::set_flag_show_variable, &config, _1)},
-		{"BRAINLOLLER_FLAG_SHOW_VARIABLE_STOP", boost::bind(&configuration::set_flag_show_variable_stop, &config, _1)},
-		{"BRAINLOLLER_FILENAME",                boost::bind(&configuration::set_filename, &config, _1)},
-		{"BRAINLOLLER_PRINTER_TYPE",            boost::bind(&configuration::set_printer_type, &config, _1)},
-		{"BRAINLOLLER_OUTPUT_TYPE",             boost::bind(&configuration::set_output_type, &config, _1)},
-		{"BRAINLOLLER_LANGUAGE",                boost::bind(&configuration::set_language, &config, _1)},
-		{"BRAINLOLLER_FLAG_RUN",                boost::bind(&configuration::set_flag_run, &config, _1)},
-		{"BRAINLOLLER_FLAG_PRINT",              boost::bind(&configuration::set_flag_print, &config, _1)},
-		{"BRAINLOLLER_OPERANDS",                boost::bind(&configuration::set_operands, &config, _1)},
-	};
+			void put_u64(boost::uint64_t value) {
+				for(int i = 0; i < 8; i++) {
+					this->put_u8(static_cast<boost::uint8_t>(value >> (i * 8)));
+				}
+			}
 
-	void usage(void) noexcept {
-		std::cout << "Program: " << PROG_NAME << " (" << PROG_NAME_FULL << ")" << std::endl;
-		std::cout << "Use --help or -h for help" << std::endl;
-	}
+			/// @brief Seven bits per byte, the high bit - more bytes follow
+			///
+			///
+			void put_varint(boost::uint64_t value) {
+				while(value >= 0x80) {
+					this->put_u8(static_cast<boost::uint8_t>(value | 0x80));
+					value >>= 7;
+				}
+				this->put_u8(static_cast<boost::uint8_t>(value));
+			}
 
-	void help() noexcept {
-		version();
-		authors();
-	
-		std::cout << std::endl << "This program uses getopts' rules (with long opts)." << std::endl;
-		std::cout << "You can see \"man 3 getopt_long\" or \"info getopt_long\" for more help." << std::endl;
-		std::cout << std::endl << "Use " << config.global_argv[0] << " [OPTIONS]" << std::endl;
-		std::cout << std::endl << "Options:" << std::endl;
-		std::cout <<"-h\t--help\t\t\t\t" << "- show this help and exit" << std::endl;
-		std::cout <<"-v\t--version\t\t\t" << "- show program version and exit" << std::endl;
-		std::cout <<"\t--authors\t\t\t" << "- show authors and exit" << std::endl;
-		std::cout <<"-l\t--license\t\t\t" << "- show license and exit" << std::endl;
-		std::cout <<"-f\t--file=[STRING]\t\t\t" << "- set filename" << std::endl;
-		std::cout <<"-s\t--show-variable\t\t\t" << "- show internal variables (for debug)" << std::endl;
-		std::cout <<"\t--show-variable-stop\t\t" << "- show internal variables and stop (for debug)" << std::endl;
-		std::cout <<"-p\t--set-printer-type\t\t" << "- set printer type" << std::endl;
-		std::cout <<"-o\t--set-output-type\t\t" << "- set type of output" << std::endl;
-		std::cout <<"-i\t--language\t\t\t" << "- set language name" << std::endl;
-		std::cout <<"\t--run\t\t\t\t" << "- run interpretator" << std::endl;
-		std::cout <<"\t--no-run\t\t\t" << "- don't run interpretator" << std::endl;
-		std::cout <<"\t--print\t\t\t\t" << "- run printer (retranslator)" << std::endl;
-		std::cout <<"\t--no-print\t\t\t" << "- don't run printer (retranslator)" << std::endl;
-		std::cout << std::endl << "Environment:" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_HELP\t\t" << "- same as '-h|--help': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VERSION\t\t" << "- same as '-v|--version': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_AUTHORS\t\t" << "- same as '--authors': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_LICENSE\t\t" << "- same as '-l|--license': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VARIABLE\t\t" << "- same as '-s|--show-variable': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VARIABLE_STOP\t" << "- same as '--show-variable-stop': {0,1}" << std::endl;
-		std::cout << "\tBRAINLOLLER_FILENAME\t\t\t" << "- same as '-f|--file'" << std::endl;
-		std::cout << "\tBRAINLOLLER_PRINTER_TYPE\t\t" << "- same as '-p|--set-printer-type'" << std::endl;
-		std::cout << "\tBRAINLOLLER_OUTPUT_TYPE\t\t\t" << "- same as '-o|--set-output-type'" << std::endl;
-		std::cout << "\tBRAINLOLLER_LANGUAGE\t\t\t" << "- same as '-i|--language'" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_RUN\t\t\t" << "- same as '--run|--no-run'" << std::endl;
-		std::cout << "\tBRAINLOLLER_FLAG_PRINT\t\t\t" << "- same as '--print|--no-print'" << std::endl;
-		std::cout << std::endl << "Printers:" << std::endl;
-		std::cout << "\t" << PRINTER_TYPE_NULL << "\t\t" << "- NULL printer (print nothing)" << std::endl;
-		std::cout << "\t" << PRINTER_TYPE_SIMPLE << "\t\t" << "- SIMPLE printer (show internal codes without spaces)" << std::endl;
-		std::cout << "\t" << PRINTER_TYPE_SIMPLE_SPACE << "\t" << "- SIMPLE WITH SPACE printer (show internal codes with spaces)" << std::endl;
-		std::cout << "\t" << PRINTER_TYPE_CLASSIC_BRAINFUCK << "\t" << "- CLASSICAL BRAINFUCK printer (show comands of Brainfuck language)" << std::endl;
-		std::cout << std::endl << "Outputs:" << std::endl;
-		std::cout << "\t" << OUTPUT_TYPE_NULL << "\t\t" << "- NULL output" << std::endl;
-		std::cout << "\t" << OUTPUT_TYPE_CHAR << "\t\t" << "- CHAR output" << std::endl;
-		std::cout << "\t" << OUTPUT_TYPE_HEX << "\t\t" << "- HEX output" << std::endl;
-		std::cout << "\t" << OUTPUT_TYPE_BOTH << "\t\t" << "- CHAR AND HEX output" << std::endl;
-		std::cout << std::endl << "Language:" << std::endl;
-		std::cout << "\t" << LANGUAGE_BRAINLOLLER << "\t" << "- Brainloller (limited edition)" << std::endl;
-		std::cout << "\t" << LANGUAGE_BRAINFUCK << "\t" << "- Brainfuck (not support in current version of program) " << std::endl;
-		std::cout << std::endl << "Example:" << std::endl;
-		std::cout << "\t" << config.global_argv[0] << " --help" << std::endl;
-		std::cout << "\t" << config.global_argv[0] << " -l" << std::endl;
-		std::cout << "\t" << config.global_argv[0] << " -f l1.png -i brainloller -p brainfuck -o char --run --print --" << std::endl;
-		std::cout << "\t" << config.global_argv[0] << " -f l1.png -i brainloller -o both --run --no-print --" << std::endl;
-	}
+			void put_bytes(void const* data, std::size_t size) {
+				this->buffer.append(static_cast<char const*>(data), size);
+			}
 
-	void license() noexcept {
-		std::cout << PROG_LICENSE << std::endl;
-	}
+			std::string const& data(void) const noexcept {
+				return this->buffer;
+			}
 
-	void authors() noexcept {
-		std::cout << "Authors: " << PROG_AUTHORS << std::endl;
-	}
+			/// @brief Append the hash of data and write all to file through a temporary file
+			///
+			/// @note The file is replaced by rename(2), so a crash never leaves a half-written file.
+			bool save(std::string const& filename) {
+				std::string const tmp = filename + ".tmp";
 
-	void version() noexcept {
-		std::cout << "Program: " << PROG_NAME << " (" << PROG_NAME_FULL << ")" << std::endl;
-		std::cout << "Version: " << PROG_VERSION << std::endl;
-	}
-	
-	// *************************************************************************
-	// Common types, enums etc
-	// *************************************************************************
-	
-	/// @brief
+				this->put_u64(fnv1a(this->buffer.data(), this->buffer.size()));
+
+				std::ofstream f(tmp.c_str(), std::ios::binary | std::ios::trunc);
+				f.write(this->buffer.data(), this->buffer.size());
+				f.close();
+
+				return f && !std::rename(tmp.c_str(), filename.c_str());
+			}
+		private:
+			std::string buffer;
+		};
+
+		/// @brief Reader of files written by BinaryWriter
+		///
+		/// @note Reading out of range returns zeros and clears the "good" flag.
+		class BinaryReader {
+		public:
+			BinaryReader(void) : buffer(), offset(0), ok(false) {}
+
+			/// @brief Read data in memory (no hash at the end)
+			///
+			///
+			explicit BinaryReader(std::string const& data) : buffer(data), offset(0), ok(true) {}
+
+			bool load(std::string const& filename) {
+				this->offset = 0;
+				this->ok = read_file(filename, this->buffer) && this->buffer.size() >= 8;
+
+				if(this->ok) {
+					BinaryReader tail;
+
+					tail.buffer = this->buffer.substr(this->buffer.size() - 8);
+					tail.ok = true;
+					this->buffer.resize(this->buffer.size() - 8);
+					this->ok = (tail.get_u64() == fnv1a(this->buffer.data(), this->buffer.size()));
+				}
+
+				return this->ok;
+			}
+
+			boost::uint8_t get_u8(void) {
+				if(this->offset >= this->buffer.size()) {
+					this->ok = false;
+					return 0;
+				}
+
+				return static_cast<boost::uint8_t>(this->buffer[this->offset++]);
+			}
+
+			boost::uint32_t get_u32(void) {
+				boost::uint32_t value = 0;
+
+				for(int i = 0; i < 4; i++) {
+					value |= static_cast<boost::uint32_t>(this->get_u8()) << (i * 8);
+				}
+
+				return value;
+			}
+
+			boost::uint64_t get_u64(void) {
+				boost::uint64_t value = 0;
+
+				for(int i = 0; i < 8; i++) {
+					value |= static_cast<boost::uint64_t>(this->get_u8()) << (i * 8);
+				}
+
+				return value;
+			}
+
+			boost::uint64_t get_varint(void) {
+				boost::uint64_t value = 0;
+
+				for(int shift = 0; shift < 64; shift += 7) {
+					boost::uint8_t const x = this->get_u8();
+
+					value |= static_cast<boost::uint64_t>(x & 0x7F) << shift;
+					if(!(x & 0x80)) {
+						return value;
+					}
+				}
+
+				this->ok = false;
+				return 0;
+			}
+
+			bool get_bytes(void* data, std::size_t size) {
+				if(size > this->buffer.size() - this->offset) {
+					this->ok = false;
+					return false;
+				}
+
+				std::memcpy(data, this->buffer.data() + this->offset, size);
+				this->offset += size;
+
+				return true;
+			}
+
+			bool good(void) const noexcept {
+				return this->ok;
+			}
+
+			/// @brief All data is read
+			///
+			///
+			bool done(void) const noexcept {
+				return this->offset >= this->buffer.size();
+			}
+
+			/// @brief Bytes which are not read yet
+			///
+			///
+			std::size_t left(void) const noexcept {
+				return this->buffer.size() - std::min(this->offset, this->buffer.size());
+			}
+		private:
+			std::string buffer;
+			std::size_t offset;
+			bool ok;
+		};
+
+		/// @brief Waits for the file to be written again (see --watch)
+		///
+		/// @note The directory is watched by inotify: editors often write a new file and
+		///       rename it over the old one. Without inotify the time of modification is polled.
+		class FileWatcher {
+			typedef FileWatcher self;
+		public:
+			explicit FileWatcher(std::string const& raw_filename) :
+				filename(raw_filename),
+				name(raw_filename),
+				fd(-1),
+				mtime(self::modified(raw_filename)) {
+#if defined(__linux__)
+				std::string::size_type const slash = this->filename.rfind('/');
+				std::string const dir = (slash == std::string::npos) ? std::string(".") :
+					this->filename.substr(0, std::max<std::string::size_type>(slash, 1));
+
+				if(slash != std::string::npos) {
+					this->name = this->filename.substr(slash + 1);
+				}
+
+				this->fd = ::inotify_init1(IN_CLOEXEC);
+				if(this->fd >= 0 && ::inotify_add_watch(this->fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+					::close(this->fd);
+					this->fd = -1;
+				}
+#endif
+			}
+
+			~FileWatcher(void) noexcept {
+				if(this->fd >= 0) {
+					::close(this->fd);
+				}
+			}
+
+			FileWatcher(self const&) = delete;
+			self& operator=(self const&) = delete;
+
+			/// @brief Wait for the next change of the file (a burst of writes is one change)
+			///
+			///
+			void wait(void) {
+				if(this->fd >= 0) {
+					while(!this->events(-1)) {}
+					while(this->events(self::QUIET_MS)) {}
+
+					return;
+				}
+
+				for(;;) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(self::POLL_MS));
+
+					boost::int64_t const m = self::modified(this->filename);
+
+					if(m != this->mtime) {
+						this->mtime = m;
+						std::this_thread::sleep_for(std::chrono::milliseconds(self::QUIET_MS));
+						return;
+					}
+				}
+			}
+		private:
+			/// @brief Read events of the directory (true - the file is written; false - timeout)
+			///
+			///
+			bool events(int timeout) {
+				bool written = false;
+#if defined(__linux__)
+				struct pollfd p = {this->fd, POLLIN, 0};
+
+				if(::poll(&p, 1, timeout) <= 0) {
+					return false;
+				}
+
+				alignas(struct inotify_event) char buffer[4096];
+				ssize_t const size = ::read(this->fd, buffer, sizeof(buffer));
+
+				for(ssize_t i = 0; i < size; ) {
+					struct inotify_event const* e = reinterpret_cast<struct inotify_event const*>(buffer + i);
+
+					if(e->len && !this->name.compare(e->name)) {
+						written = true;
+					}
+					i += static_cast<ssize_t>(sizeof(struct inotify_event) + e->len);
+				}
+#else
+				__unused_suppressor__(timeout);
+#endif
+				return written;
+			}
+
+			static boost::int64_t modified(std::string const& filename) {
+				struct stat st;
+
+				if(::stat(filename.c_str(), &st)) {
+					return -1;
+				}
+
+				return static_cast<boost::int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+			}
+
+			std::string const filename;
+			std::string name;
+			int fd;
+			boost::int64_t mtime;
+
+			static int const QUIET_MS = 50;
+			static int const POLL_MS = 200;
+		};
+
+		int const FileWatcher::QUIET_MS;
+		int const FileWatcher::POLL_MS;
+
+		/// @brief Regular files of the directory (sorted) or the file itself
+		///
+		///
+		inline std::vector<std::string> list_files(std::string const& path) {
+			std::vector<std::string> files;
+			struct stat st;
+
+			if(::stat(path.c_str(), &st) || !S_ISDIR(st.st_mode)) {
+				files.push_back(path);
+				return files;
+			}
+
+			if(DIR* const dir = ::opendir(path.c_str())) {
+				while(struct dirent const* const e = ::readdir(dir)) {
+					std::string const name = path + "/" + e->d_name;
+
+					if(!::stat(name.c_str(), &st) && S_ISREG(st.st_mode)) {
+						files.push_back(name);
+					}
+				}
+				::closedir(dir);
+			}
+
+			std::sort(files.begin(), files.end());
+			return files;
+		}
+	} // namespace utils
+
+	/// @brief Tracing of phases of the run (Chrome trace format), statistics of the run and
+	///        map of generated code for perf
 	///
+	/// @note Every thread writes events into its own ring (single writer, no locks); rings are
+	///       linked into the lock-free list and read once on export. The ring keeps the last
+	///       RING_SIZE events. When tracing and statistics are off a scope costs two loads
+	///       of flags.
+	namespace tracing {
+		/// @brief
+		///
+		///
+		struct event_t {
+			char const* name;      // Static string
+			boost::uint64_t begin; // Nanoseconds from the start of the process
+			boost::uint64_t end;
+		};
+
+		/// @brief
+		///
+		///
+		class Ring {
+			typedef Ring self;
+		public:
+			static std::size_t const RING_SIZE = 4096; // Power of two
+
+			/// @brief
+			///
+			///
+			explicit Ring(boost::uint32_t raw_tid) noexcept : head(0), tid(raw_tid), next(nullptr) {}
+
+			/// @brief
+			///
+			///
+			inline void push(event_t const& e) noexcept {
+				boost::uint64_t const h = this->head.load(std::memory_order_relaxed);
+
+				this->events[h & (self::RING_SIZE - 1)] = e;
+				this->head.store(h + 1, std::memory_order_release);
+			}
+
+			event_t events[RING_SIZE];
+			std::atomic<boost::uint64_t> head;
+			boost::uint32_t tid;
+			Ring* next;
+		};
+
+		/// @brief Hardware counters (perf_event_open)
+		///
+		///
+		enum HardwareCounter {
+			HW_CYCLES = 0,
+			HW_INSTRUCTIONS,
+			HW_BRANCHES,
+			HW_BRANCH_MISSES,
+			HW_L1D_MISSES,
+			HW_LLC_MISSES,
+			HW_DTLB_MISSES,
+			HW_COUNT
+		};
+
+		char const* const HW_NAMES[HW_COUNT] = {
+			"cycles", "instructions", "branches", "branch_misses", "l1d_misses", "llc_misses", "dtlb_misses"
+		};
+
+		/// @brief Readings of the hardware counters
+		///
+		///
+		struct hw_t {
+			boost::uint64_t value[HW_COUNT];
+		};
+
+		/// @brief Totals of one phase (for statistics)
+		///
+		///
+		struct phase_t {
+			char const* name;
+			boost::uint64_t count;
+			boost::uint64_t wall; // Nanoseconds
+			boost::uint64_t cpu;  // Nanoseconds of the thread
+			hw_t hw;              // Events of the thread (if hardware)
+		};
+
+		/// @brief Counters of the machine at the end of the run (for statistics)
+		///
+		///
+		struct counters_t {
+			bool valid;
+			boost::uint64_t executed;
+			boost::uint64_t back_edges;
+			boost::uint64_t bytes_in;
+			boost::uint64_t bytes_out;
+			boost::uint64_t tape_extent; // Cells up to the last used one
+			bool optimized;              // The engine runs the decoded program (see Program)
+			boost::uint64_t eliminated;  // Instructions removed by the dataflow pass
+		};
+
+		std::atomic<bool> enabled(false);
+		std::atomic<bool> stats(false);
+		std::atomic<bool> hardware(false);
+		std::atomic<unsigned> hw_available(0); // Mask of the counters opened at least in one thread
+		std::atomic<int> hw_error(0);          // errno of the first counter failed to open
+		std::atomic<Ring*> rings(nullptr);
+		std::mutex phases_mutex;
+		std::vector<phase_t> phases;
+		counters_t counters = {false, 0, 0, 0, 0, 0, false, 0};
+		std::atomic<boost::uint32_t> next_tid(1);
+		std::chrono::steady_clock::time_point const origin = std::chrono::steady_clock::now();
+
+		/// @brief
+		///
+		///
+		inline boost::uint64_t now(void) noexcept {
+			return static_cast<boost::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+													std::chrono::steady_clock::now() - origin).count());
+		}
+
+		/// @brief CPU time of the current thread
+		///
+		///
+		inline boost::uint64_t cpu_now(void) noexcept {
+			struct timespec ts = {0, 0};
+
+			::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+			return static_cast<boost::uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<boost::uint64_t>(ts.tv_nsec);
+		}
+
+		/// @brief Hardware counters of the current thread
+		///
+		/// Every counter is opened alone (not as a group), so the ones which the CPU,
+		/// the kernel or perf_event_paranoid don't allow are just skipped. Only the
+		/// user space of the thread is counted; multiplexed counters are scaled.
+		class Hardware {
+			typedef Hardware self;
+		public:
+			/// @brief
+			///
+			///
+			Hardware(void) noexcept : available(0) {
+				std::fill(this->fd, this->fd + HW_COUNT, -1);
+#if defined(__linux__) && defined(__NR_perf_event_open)
+				struct event_config_t {
+					boost::uint32_t type;
+					boost::uint64_t config;
+				};
+				event_config_t const CONFIG[HW_COUNT] = {
+					{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+					{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+					{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS},
+					{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+					{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+						(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+					{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+						(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+					{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+						(PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}
+				};
+
+				for(std::size_t i = 0; i < HW_COUNT; ++i) {
+					struct perf_event_attr attr;
+
+					std::memset(&attr, 0, sizeof(attr));
+					attr.size = sizeof(attr);
+					attr.type = CONFIG[i].type;
+					attr.config = CONFIG[i].config;
+					attr.exclude_kernel = 1;
+					attr.exclude_hv = 1;
+					attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+					this->fd[i] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+					if(this->fd[i] < 0) {
+						int expected = 0;
+
+						hw_error.compare_exchange_strong(expected, errno);
+					}
+					else {
+						this->available |= 1u << i;
+					}
+				}
+#else
+				int expected = 0;
+
+				hw_error.compare_exchange_strong(expected, ENOSYS);
+#endif
+				hw_available.fetch_or(this->available);
+			}
+
+			/// @brief
+			///
+			///
+			~Hardware(void) noexcept {
+				std::for_each(this->fd, this->fd + HW_COUNT, [](int x)->void {
+						if(x >= 0) {
+							::close(x);
+						}
+					});
+			}
+
+			Hardware(self const&) = delete;
+			self& operator=(self const&) = delete;
+
+			/// @brief Current readings (zero for the unavailable counters)
+			///
+			///
+			inline void read(hw_t& out) const noexcept {
+				for(std::size_t i = 0; i < HW_COUNT; ++i) {
+					boost::uint64_t data[3] = {0, 0, 0}; // value, time enabled, time running
+
+					out.value[i] = 0;
+					if(this->fd[i] >= 0 && ::read(this->fd[i], data, sizeof(data)) == static_cast<ssize_t>(sizeof(data))) {
+						out.value[i] = (data[2] && data[2] < data[1]) ?
+							static_cast<boost::uint64_t>(static_cast<double>(data[0]) * data[1] / data[2]) : data[0];
+					}
+				}
+			}
+		private:
+			int fd[HW_COUNT];
+			unsigned available;
+		};
+
+		/// @brief Hardware counters of the current thread (opened on the first use)
+		///
+		///
+		inline Hardware const& hardware_local(void) {
+			thread_local Hardware counters;
+
+			return counters;
+		}
+
+		/// @brief Add the time of the phase to the totals
+		///
+		///
+		inline void account(char const* name, boost::uint64_t wall, boost::uint64_t cpu, hw_t const* hw) {
+			std::lock_guard<std::mutex> lock(phases_mutex);
+			std::vector<phase_t>::iterator i = std::find_if(phases.begin(), phases.end(), [name](phase_t const& x)->bool {
+					return !std::strcmp(x.name, name);
+				});
+
+			if(i == phases.end()) {
+				phases.push_back(phase_t{name, 0, 0, 0, hw_t{{0}}});
+				i = phases.end() - 1;
+			}
+
+			i->count++;
+			i->wall += wall;
+			i->cpu += cpu;
+			if(hw) {
+				for(std::size_t j = 0; j < HW_COUNT; ++j) {
+					i->hw.value[j] += hw->value[j];
+				}
+			}
+		}
+
+		/// @brief Ring of the current thread (created on the first event; never freed)
+		///
+		///
+		inline Ring& local(void) {
+			thread_local Ring* ring = nullptr;
+
+			if(!ring) {
+				ring = new Ring(next_tid.fetch_add(1));
+				ring->next = rings.load(std::memory_order_relaxed);
+				while(!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release)) {
+				}
+			}
+
+			return *ring;
+		}
+
+		/// @brief Event for the lifetime of the object
+		///
+		///
+		class Scope {
+			typedef Scope self;
+		public:
+			explicit Scope(char const* raw_name) noexcept :
+				trace(enabled.load(std::memory_order_relaxed)),
+				account(stats.load(std::memory_order_relaxed)),
+				hardware(this->account && tracing::hardware.load(std::memory_order_relaxed)),
+				name(raw_name),
+				begin((this->trace || this->account) ? now() : 0),
+				cpu_begin((this->account) ? cpu_now() : 0) {
+				// RU: Счётчики читаются последними, чтобы не считать работу самого Scope
+				if(this->hardware) {
+					hardware_local().read(this->hw_begin);
+				}
+			}
+
+			~Scope(void) noexcept {
+				if(this->trace || this->account) {
+					hw_t hw_end;
+
+					if(this->hardware) {
+						hardware_local().read(hw_end);
+						for(std::size_t i = 0; i < HW_COUNT; ++i) {
+							hw_end.value[i] = (hw_end.value[i] > this->hw_begin.value[i]) ?
+								hw_end.value[i] - this->hw_begin.value[i] : 0;
+						}
+					}
+
+					boost::uint64_t const end = now();
+
+					if(this->trace) {
+						local().push(event_t{this->name, this->begin, end});
+					}
+					if(this->account) {
+						tracing::account(this->name, end - this->begin, cpu_now() - this->cpu_begin,
+										 (this->hardware) ? &hw_end : nullptr);
+					}
+				}
+			}
+
+			Scope(self const&) = delete;
+			self& operator=(self const&) = delete;
+		private:
+			bool const trace;
+			bool const account;
+			bool const hardware;
+			char const* const name;
+			boost::uint64_t const begin;
+			boost::uint64_t const cpu_begin;
+			hw_t hw_begin;
+		};
+
+		/// @brief Write all events as Chrome trace JSON (chrome://tracing, Perfetto)
+		///
+		/// @note It's called at exit, when the writers are done.
+		inline bool save(std::string const& filename) {
+			std::ofstream f(filename.c_str(), std::ios::binary);
+			long const pid = static_cast<long>(::getpid());
+			char const* sep = "";
+
+			f << "{\"traceEvents\":[";
+			for(Ring const* r = rings.load(std::memory_order_acquire); r; r = r->next) {
+				boost::uint64_t const head = r->head.load(std::memory_order_acquire);
+				boost::uint64_t const first = (head > Ring::RING_SIZE) ? head - Ring::RING_SIZE : 0;
+
+				for(boost::uint64_t i = first; i < head; i++) {
+					event_t const& e = r->events[i & (Ring::RING_SIZE - 1)];
+
+					f << sep << "\n{\"name\":\"" << e.name << "\",\"cat\":\"brainloller\",\"ph\":\"X\""
+					  << ",\"ts\":" << e.begin / 1000 << "." << std::setw(3) << std::setfill('0') << e.begin % 1000
+					  << ",\"dur\":" << (e.end - e.begin) / 1000 << "." << std::setw(3) << (e.end - e.begin) % 1000
+					  << std::setfill(' ') << ",\"pid\":" << pid << ",\"tid\":" << r->tid << "}";
+					sep = ",";
+				}
+			}
+			f << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+			return static_cast<bool>(f);
+		}
+
+		/// @brief Entries of /tmp/perf-<pid>.map for generated code (see perf-report)
+		///
+		///
+		class PerfMap {
+			typedef PerfMap self;
+		public:
+			/// @brief
+			///
+			///
+			static void add(void const* addr, std::size_t size, std::string const& name) {
+				if(!self::enabled) {
+					return;
+				}
+
+				std::lock_guard<std::mutex> lock(self::mutex);
+				std::ostringstream filename;
+
+				filename << "/tmp/perf-" << ::getpid() << ".map";
+				std::ofstream f(filename.str().c_str(), std::ios::app);
+				f << std::hex << reinterpret_cast<std::uintptr_t>(addr) << " " << size << " " << name << std::endl;
+			}
+
+			static bool enabled;
+		private:
+			static std::mutex mutex;
+		};
+
+		bool PerfMap::enabled = false;
+		std::mutex PerfMap::mutex;
+	} // namespace tracing
+
+	/// @brief Asynchronous standard input and output (see --async-io)
 	///
-	enum Operation {
-		OP_UNKNOWN = 0,              // Неизвестная комманда
-		OP_INC_CELL,                 // Увеличить текущее значение ячейки ленты памяти на единицу
-		OP_DEC_CELL,                 // Уменьшить текущее значение ячейки ленты памяти на единицу
-		OP_NEXT_CELL,                // Сдвинуть указатель текущей ячейки ленты памяти вправо на одну ячейку
-		OP_PREV_CELL,                // Сдвинуть указатель текущей ячейки ленты памяти вправо на одну ячейку
-		OP_READ,                     // Ввод
-		OP_WRITE,                    // Вывод
-		OP_BEGIN_LOOP,               //
-		OP_END_LOOP,                 //
-		OP_ROTATE_CLOCKWISE,         //
-		OP_ROTATE_COUNTER_CLOCKWISE, // 
-	};
+	/// @note The interpreter and a thread of I/O share a lock-free ring of bytes (one producer,
+	///       one consumer). The writer thread drains the output by large writes, the reader
+	///       thread fills the input ahead of OP_READ. A full ring stops the producer until the
+	///       consumer frees space. The engines still use std::cout and std::cin: only buffers
+	///       of the streams are replaced.
+	namespace asyncio {
+		/// @brief Lock-free ring of bytes for one producer and one consumer
+		///
+		/// @note Positions only grow: the producer owns head, the consumer owns tail.
+		class ByteRing {
+			typedef ByteRing self;
+		public:
+			/// @brief
+			///
+			/// @note The size is a power of two.
+			explicit ByteRing(std::size_t raw_size) : data(raw_size), mask(raw_size - 1), head(0), tail(0) {}
+
+			/// @brief Put up to size bytes (returns the count of them)
+			///
+			///
+			std::size_t push(char const* src, std::size_t size) noexcept {
+				std::size_t const h = this->head.load(std::memory_order_relaxed);
+				std::size_t const t = this->tail.load(std::memory_order_acquire);
+				std::size_t const n = std::min(size, this->data.size() - (h - t));
+				std::size_t const first = std::min(n, this->data.size() - (h & this->mask));
+
+				std::memcpy(&this->data[h & this->mask], src, first);
+				std::memcpy(&this->data[0], src + first, n - first);
+				this->head.store(h + n, std::memory_order_release);
+
+				return n;
+			}
+
+			/// @brief Take up to size bytes (returns the count of them)
+			///
+			///
+			std::size_t pop(char* dst, std::size_t size) noexcept {
+				std::size_t const t = this->tail.load(std::memory_order_relaxed);
+				std::size_t const h = this->head.load(std::memory_order_acquire);
+				std::size_t const n = std::min(size, h - t);
+				std::size_t const first = std::min(n, this->data.size() - (t & this->mask));
+
+				std::memcpy(dst, &this->data[t & this->mask], first);
+				std::memcpy(dst + first, &this->data[0], n - first);
+				this->tail.store(t + n, std::memory_order_release);
+
+				return n;
+			}
+
+			/// @brief
+			///
+			///
+			bool empty(void) const noexcept {
+				return this->head.load(std::memory_order_acquire) == this->tail.load(std::memory_order_acquire);
+			}
+
+			/// @brief
+			///
+			///
+			bool full(void) const noexcept {
+				return this->head.load(std::memory_order_acquire) - this->tail.load(std::memory_order_acquire) == this->data.size();
+			}
+		private:
+			std::vector<char> data;
+			std::size_t mask;
+			std::atomic<std::size_t> head;
+			char padding[64]; // RU: head и tail в разных строках кэша
+			std::atomic<std::size_t> tail;
+		};
+
+		/// @brief Sleep of the side which can't go on (the ring is empty or full)
+		///
+		/// @note The mutex is taken only when somebody sleeps: the fence orders the change of
+		///       the ring and the check of sleepers against the same steps of the sleeper.
+		class Signal {
+			typedef Signal self;
+		public:
+			/// @brief
+			///
+			///
+			Signal(void) : mutex(), cv(), waiters(0) {}
+
+			/// @brief
+			///
+			///
+			template<typename PREDICATE>
+			void wait(PREDICATE ready) {
+				std::unique_lock<std::mutex> lock(this->mutex);
+
+				this->waiters.fetch_add(1);
+				this->cv.wait(lock, ready);
+				this->waiters.fetch_sub(1);
+			}
+
+			/// @brief
+			///
+			///
+			void notify(void) {
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				if(this->waiters.load(std::memory_order_relaxed)) {
+					std::lock_guard<std::mutex> lock(this->mutex);
+
+					this->cv.notify_all();
+				}
+			}
+		private:
+			std::mutex mutex;
+			std::condition_variable cv;
+			std::atomic<unsigned> waiters;
+		};
+
+		/// @brief Buffer of std::cout which is written by the writer thread
+		///
+		/// @note sync() (std::cout.flush()) returns when all bytes are written: checkpoints
+		///       and limits of the engines rely on it.
+		class OutputBuffer : public std::streambuf {
+			typedef OutputBuffer self;
+		public:
+			/// @brief
+			///
+			///
+			OutputBuffer(int raw_fd, std::size_t size) :
+				ring(size),
+				signal(),
+				fd(raw_fd),
+				pushed(0),
+				written(0),
+				stopped(false),
+				failed(false),
+				writer() {
+				this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+				this->writer = std::thread(&self::drain, this);
+			}
+
+			/// @brief
+			///
+			///
+			virtual ~OutputBuffer(void) {
+				this->stop();
+			}
+
+			/// @brief Give the buffered bytes to the writer thread without waiting for the write
+			///
+			///
+			void publish(void) {
+				char const* p = this->pbase();
+				std::size_t size = static_cast<std::size_t>(this->pptr() - this->pbase());
+
+				while(size) {
+					std::size_t const n = this->ring.push(p, size);
+
+					if(n) {
+						p += n;
+						size -= n;
+						this->pushed += n;
+						this->signal.notify();
+						continue;
+					}
+
+					this->signal.wait([this]()->bool { return !this->ring.full(); });
+				}
+
+				this->setp(this->buffer, this->buffer + sizeof(this->buffer));
+			}
+
+			/// @brief Write all bytes and stop the writer thread
+			///
+			///
+			void stop(void) {
+				if(!this->writer.joinable()) {
+					return;
+				}
+
+				this->sync();
+				this->stopped.store(true);
+				this->signal.notify();
+				this->writer.join();
+			}
+		protected:
+			virtual int_type overflow(int_type c) {
+				this->publish();
+
+				if(!traits_type::eq_int_type(c, traits_type::eof())) {
+					*this->pptr() = traits_type::to_char_type(c);
+					this->pbump(1);
+				}
+
+				return traits_type::not_eof(c);
+			}
+
+			virtual int sync(void) {
+				this->publish();
+				this->signal.wait([this]()->bool { return this->written.load(std::memory_order_acquire) == this->pushed; });
+
+				return (this->failed.load()) ? -1 : 0;
+			}
+		private:
+			/// @brief Body of the writer thread
+			///
+			///
+			void drain(void) {
+				std::vector<char> chunk(self::CHUNK_SIZE);
+
+				for(;;) {
+					std::size_t const n = this->ring.pop(chunk.data(), chunk.size());
+
+					if(!n) {
+						if(this->stopped.load()) {
+							return;
+						}
+
+						this->signal.wait([this]()->bool { return !this->ring.empty() || this->stopped.load(); });
+						continue;
+					}
+
+					this->signal.notify();
+					this->write(chunk.data(), n);
+					this->written.fetch_add(n, std::memory_order_release);
+					this->signal.notify();
+				}
+			}
+
+			/// @brief
+			///
+			/// @note Bytes which can't be written are dropped: the error is returned by sync().
+			void write(char const* data, std::size_t size) {
+				while(size && !this->failed.load(std::memory_order_relaxed)) {
+					ssize_t const n = ::write(this->fd, data, size);
+
+					if(n < 0) {
+						if(errno != EINTR) {
+							this->failed.store(true);
+						}
+						continue;
+					}
+
+					data += n;
+					size -= static_cast<std::size_t>(n);
+				}
+			}
+
+			static std::size_t const CHUNK_SIZE = 65536;
+
+			ByteRing ring;
+			Signal signal;
+			int fd;
+			std::size_t pushed; // Owned by the producer
+			std::atomic<std::size_t> written;
+			std::atomic<bool> stopped;
+			std::atomic<bool> failed;
+			std::thread writer;
+			char buffer[4096];
+		};
+
+		/// @brief Buffer of std::cin which is filled by the reader thread
+		///
+		/// @note The reader starts on the first read, so a restored checkpoint can seek the
+		///       input before. The tied output is published (but not waited for) when the
+		///       interpreter has to wait for the input: the prompt is seen, the output overlaps.
+		class InputBuffer : public std::streambuf {
+			typedef InputBuffer self;
+		public:
+			/// @brief
+			///
+			///
+			InputBuffer(int raw_fd, std::size_t size, OutputBuffer* raw_tie) :
+				ring(size),
+				signal(),
+				fd(raw_fd),
+				tie(raw_tie),
+				offset(::lseek(raw_fd, 0, SEEK_CUR)),
+				consumed(0),
+				eof(false),
+				stopped(false),
+				reader() {
+				this->setg(this->buffer, this->buffer, this->buffer);
+			}
+
+			/// @brief
+			///
+			///
+			virtual ~InputBuffer(void) {
+				this->stop();
+			}
+
+			/// @brief Stop the reader thread
+			///
+			/// @note The reader can wait for the terminal forever: it's left alone, so the
+			///       buffer must live until the exit.
+			void stop(void) {
+				if(!this->reader.joinable()) {
+					return;
+				}
+
+				this->stopped.store(true);
+				this->signal.notify();
+				this->reader.detach();
+			}
+		protected:
+			virtual int_type underflow(void) {
+				if(this->gptr() < this->egptr()) {
+					return traits_type::to_int_type(*this->gptr());
+				}
+
+				if(!this->reader.joinable() && !this->stopped.load()) {
+					this->reader = std::thread(&self::fill, this);
+				}
+
+				std::size_t n = 0;
+
+				while(!(n = this->ring.pop(this->buffer, sizeof(this->buffer)))) {
+					if(this->eof.load(std::memory_order_acquire)) {
+						// RU: Читатель кладёт последние байты до флага конца, поэтому проверяем ещё раз
+						if(!(n = this->ring.pop(this->buffer, sizeof(this->buffer)))) {
+							return traits_type::eof();
+						}
+						break;
+					}
+
+					if(this->tie) {
+						this->tie->publish();
+					}
+					this->signal.wait([this]()->bool { return !this->ring.empty() || this->eof.load(); });
+				}
+
+				this->signal.notify();
+				this->consumed += n;
+				this->setg(this->buffer, this->buffer, this->buffer + n);
+
+				return traits_type::to_int_type(*this->gptr());
+			}
+
+			/// @brief Position of the input (tellg), only for files
+			///
+			///
+			virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+				if(off || dir != std::ios_base::cur || !(which & std::ios_base::in) || this->offset < 0) {
+					return pos_type(off_type(-1));
+				}
+
+				return pos_type(this->offset + static_cast<off_type>(this->consumed) - (this->egptr() - this->gptr()));
+			}
+
+			/// @brief Move the input (seekg), only before the first read
+			///
+			///
+			virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which) {
+				if(!(which & std::ios_base::in) || this->reader.joinable() || this->offset < 0 ||
+				   ::lseek(this->fd, static_cast<off_t>(pos), SEEK_SET) < 0) {
+					return pos_type(off_type(-1));
+				}
+
+				this->offset = static_cast<off_type>(pos);
+				this->consumed = 0;
+				this->setg(this->buffer, this->buffer, this->buffer);
+
+				return pos;
+			}
+		private:
+			/// @brief Body of the reader thread
+			///
+			///
+			void fill(void) {
+				std::vector<char> chunk(self::CHUNK_SIZE);
+
+				while(!this->stopped.load()) {
+					ssize_t const n = ::read(this->fd, chunk.data(), chunk.size());
+
+					if(n < 0 && errno == EINTR) {
+						continue;
+					}
+
+					if(n <= 0) {
+						break;
+					}
+
+					for(char const* p = chunk.data(), * end = p + n; p < end && !this->stopped.load(); ) {
+						std::size_t const pushed = this->ring.push(p, static_cast<std::size_t>(end - p));
+
+						if(pushed) {
+							p += pushed;
+							this->signal.notify();
+							continue;
+						}
+
+						this->signal.wait([this]()->bool { return !this->ring.full() || this->stopped.load(); });
+					}
+				}
+
+				this->eof.store(true, std::memory_order_release);
+				this->signal.notify();
+			}
+
+			static std::size_t const CHUNK_SIZE = 65536;
+
+			ByteRing ring;
+			Signal signal;
+			int fd;
+			OutputBuffer* tie;
+			off_type offset;             // Position of the first byte of the ring (-1 - not a file)
+			boost::uint64_t consumed;    // Owned by the consumer
+			std::atomic<bool> eof;
+			std::atomic<bool> stopped;
+			std::thread reader;
+			char buffer[4096];
+		};
+
+		std::size_t const RING_SIZE = 1 << 20;
+
+		OutputBuffer* output = nullptr;
+		InputBuffer* input = nullptr;
+		std::streambuf* cout_buffer = nullptr;
+		std::streambuf* cin_buffer = nullptr;
+
+		/// @brief Replace buffers of std::cout and std::cin
+		///
+		/// @note std::cin isn't tied to std::cout any more: the output is published when the
+		///       interpreter waits for the input (see InputBuffer).
+		inline void start(void) {
+			// RU: Буферы не удаляются: поток чтения может остаться в read() до самого выхода
+			output = new OutputBuffer(STDOUT_FILENO, RING_SIZE);
+			input = new InputBuffer(STDIN_FILENO, RING_SIZE, output);
+
+			cout_buffer = std::cout.rdbuf(output);
+			cin_buffer = std::cin.rdbuf(input);
+			std::cin.tie(nullptr);
+		}
+
+		/// @brief Write the rest of the output and return the buffers (at exit)
+		///
+		///
+		inline void stop(void) {
+			if(!output) {
+				return;
+			}
+
+			std::cout.flush();
+			output->stop();
+			input->stop();
+
+			std::cout.rdbuf(cout_buffer);
+			std::cin.rdbuf(cin_buffer);
+			std::cin.tie(&std::cout);
+		}
+	} // namespace asyncio
+
+	// *************************************************************************
+	// Common constants
+	// *************************************************************************
+
+	std::string const PRINTER_TYPE_NULL = std::string("null");
+	std::string const PRINTER_TYPE_SIMPLE = std::string("simple");
+	std::string const PRINTER_TYPE_SIMPLE_SPACE = std::string("simplespace");
+	std::string const PRINTER_TYPE_CLASSIC_BRAINFUCK = std::string("brainfuck");
+
+	std::string const OUTPUT_TYPE_NULL = std::string("null");
+	std::string const OUTPUT_TYPE_CHAR = std::string("char");
+	std::string const OUTPUT_TYPE_HEX = std::string("hex");
+	std::string const OUTPUT_TYPE_BOTH = std::string("both");
+	
+	std::string const LANGUAGE_BRAINLOLLER = std::string("brainloller");
+	std::string const LANGUAGE_BRAINFUCK = std::string("brainfuck");
+
+	std::string const ENGINE_TYPE_REFERENCE = std::string("reference");
+	std::string const ENGINE_TYPE_COMPILED = std::string("compiled");
+	std::string const ENGINE_TYPE_THREADED = std::string("threaded");
+	std::string const ENGINE_TYPE_DEBUG = std::string("debug");
+	std::string const ENGINE_TYPE_TIERED = std::string("tiered");
+
+	std::string const TAPE_ALLOCATOR_DEFAULT = std::string("default");
+	std::string const TAPE_ALLOCATOR_ALIGNED = std::string("aligned");
+	std::string const TAPE_ALLOCATOR_HUGEPAGES = std::string("hugepages");
+	std::string const TAPE_ALLOCATOR_HUGETLB = std::string("hugetlb");
+
+	int const EXIT_INSTRUCTION_LIMIT = 3;
+	int const EXIT_TIME_LIMIT = 4;
+	int const EXIT_INFINITE_LOOP = 5;
+	int const EXIT_TAPE_BOUNDS = 7;
+	int const EXIT_DIVERGED = 8;
+
+	// Codes of long options without short equivalent (out of range of char)
+	enum LongOptionCode {
+		OPT_MAX_INSTRUCTIONS = 0x100,
+		OPT_MAX_TIME,
+		OPT_CHECKPOINT,
+		OPT_CHECKPOINT_INTERVAL,
+		OPT_RESTORE,
+		OPT_CACHE_DIR,
+		OPT_PREFIX_BUDGET,
+		OPT_PROFILE,
+		OPT_SUPERINSTRUCTIONS,
+		OPT_CELL_SIZE,
+		OPT_ENCODE,
+		OPT_PRINT_FILE,
+		OPT_TAPE_SIZE,
+		OPT_TAPE_ALLOCATOR,
+		OPT_DEBUG_INPUT,
+		OPT_TRACE,
+		OPT_JIT_THRESHOLD,
+		OPT_VERIFY_INTERVAL,
+		OPT_RECORD,
+		OPT_REPLAY,
+		OPT_RECORD_INTERVAL
+	};
+
+	// *************************************************************************
+	// Functions etc for program's arguments
+	// *************************************************************************
+	
+#if !defined(BRAINLOLLER_LIBRARY)
+	void usage(void) noexcept;
+	void help() noexcept;
+	void license() noexcept;
+	void authors() noexcept;
+	void version() noexcept;
+
+	const char* PROG_NAME = "brainloller";
+	const char* PROG_NAME_FULL = "Interpretator of Brainfuck/Brainloller";
+	const char* PROG_VERSION = "0.7";
+	const char* PROG_AUTHORS = "Vasiliy V. Bodrov aka Bodro (bodro-mail@list.ru) and Denis Evgrafov";
+	const char* PROG_LICENSE = ""		\
+    "The MIT License (MIT)\n"\
+    "\n"\
+    "Copyright (c) 2016 Vasiliy V. Bodrov aka Bodro and Denis Evgrafov, Ryazan, Russia\n"\
+    "\n"\
+    "Permission is hereby granted, free of charge, to any person obtaining a\n"\
+    "copy of this software and associated documentation files (the \"Software\"),\n"\
+    "Software is furnished to do so, subject to the following conditions:\n"\
+    "\n"\
+    "The above copyright notice and this permission notice shall be included\n"\
+    "in all copies or substantial portions of the Software.\n"\
+    "\n"\
+    "THE SOFTWARE IS PROVIDED \"AS IS\", WITHOUT WARRANTY OF ANY KIND, EXPRESS\n"\
+    "OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF\n"\
+    "MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.\n"\
+    "IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY\n"\
+    "CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT\n"\
+    "OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR\n"\
+    "THE USE OR OTHER DEALINGS IN THE SOFTWARE.\n";
+#endif // !defined(BRAINLOLLER_LIBRARY)
+
+	struct configuration {
+	public:
+		/* Fields (direct access) */
+		int global_argc;
+		char const* const* global_argv;
+		int flag_show_help;
+		int flag_show_version;
+		int flag_show_authors;
+		int flag_show_license;
+		int flag_show_variable;
+		int flag_show_variable_stop;
+		std::string filename;
+		std::string printer_type;
+		std::string output_type;
+		std::string language;
+		std::string engine;
+		int flag_run;
+		int flag_print;
+		boost::uint64_t max_instructions;
+		boost::uint64_t max_time;
+		std::string checkpoint;
+		boost::uint64_t checkpoint_interval;
+		std::string restore;
+		std::string cache_dir;
+		boost::uint64_t prefix_budget;
+		std::string profile;
+		std::string superinstructions;
+		boost::uint32_t jit_threshold;
+		boost::uint32_t cell_size;
+		std::string encode;
+		std::string print_file;
+		boost::uint64_t tape_size;
+		std::string tape_allocator;
+		int flag_numa;
+		std::string debug_input;
+		std::string trace;
+		int flag_perf_map;
+		int flag_stats;
+		int flag_perf_counters;
+		int flag_hang_check;
+		int flag_async_io;
+		int flag_watch;
+		int flag_checked;
+		int flag_verify;
+		boost::uint64_t verify_interval;
+		std::string record;
+		std::string replay;
+		boost::uint64_t record_interval;
+		std::list<std::string> operands;
+
+		/* Methods */
+		inline void set_flag_show_help(char const* value) {
+			this->flag_show_help = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_show_version(char const* value) {
+			this->flag_show_version = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_show_authors(char const* value) {
+			this->flag_show_authors = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_show_license(char const* value) {
+			this->flag_show_license = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_show_variable(char const* value) {
+			this->flag_show_variable = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_show_variable_stop(char const* value) {
+			this->flag_show_variable_stop = boost::lexical_cast<int>(value);
+		}
+		inline void set_filename(char const* value) {
+			this->filename = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_printer_type(char const* value) {
+			this->printer_type = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_output_type(char const* value) {
+			this->output_type = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_language(char const* value) {
+			this->language = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_engine(char const* value) {
+			this->engine = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_flag_run(char const* value) {
+			this->flag_run = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_print(char const* value) {
+			this->flag_print = boost::lexical_cast<int>(value);
+		}
+		inline void set_max_instructions(char const* value) {
+			this->max_instructions = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_max_time(char const* value) {
+			this->max_time = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_checkpoint(char const* value) {
+			this->checkpoint = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_checkpoint_interval(char const* value) {
+			this->checkpoint_interval = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_restore(char const* value) {
+			this->restore = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_cache_dir(char const* value) {
+			this->cache_dir = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_prefix_budget(char const* value) {
+			this->prefix_budget = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_profile(char const* value) {
+			this->profile = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_superinstructions(char const* value) {
+			this->superinstructions = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_jit_threshold(char const* value) {
+			this->jit_threshold = boost::lexical_cast<boost::uint32_t>(value);
+		}
+		inline void set_cell_size(char const* value) {
+			this->cell_size = boost::lexical_cast<boost::uint32_t>(value);
+		}
+		inline void set_encode(char const* value) {
+			this->encode = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_print_file(char const* value) {
+			this->print_file = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_tape_size(char const* value) {
+			this->tape_size = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_tape_allocator(char const* value) {
+			this->tape_allocator = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_flag_numa(char const* value) {
+			this->flag_numa = boost::lexical_cast<int>(value);
+		}
+		inline void set_debug_input(char const* value) {
+			this->debug_input = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_trace(char const* value) {
+			this->trace = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_flag_perf_map(char const* value) {
+			this->flag_perf_map = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_stats(char const* value) {
+			this->flag_stats = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_perf_counters(char const* value) {
+			this->flag_perf_counters = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_hang_check(char const* value) {
+			this->flag_hang_check = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_async_io(char const* value) {
+			this->flag_async_io = boost::lexical_cast<int>(value);
+		}
+
+		inline void set_flag_watch(char const* value) {
+			this->flag_watch = boost::lexical_cast<int>(value);
+		}
+
+		inline void set_flag_checked(char const* value) {
+			this->flag_checked = boost::lexical_cast<int>(value);
+		}
+		inline void set_flag_verify(char const* value) {
+			this->flag_verify = boost::lexical_cast<int>(value);
+		}
+		inline void set_verify_interval(char const* value) {
+			this->verify_interval = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_record(char const* value) {
+			this->record = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_replay(char const* value) {
+			this->replay = boost::lexical_cast<std::string>(value);
+		}
+		inline void set_record_interval(char const* value) {
+			this->record_interval = boost::lexical_cast<boost::uint64_t>(value);
+		}
+		inline void set_operands(char const* value) {
+		std::istringstream iss(value);
+		std::copy(std::istream_iterator<std::string>(iss),
+				  std::istream_iterator<std::string>(),
+				  std::back_inserter(this->operands));
+		}
+		inline configuration(void) :
+			global_argc(0),
+			global_argv(nullptr),
+			flag_show_help(0),
+			flag_show_version(0),
+			flag_show_authors(0),
+			flag_show_license(0),
+			flag_show_variable(0),
+			flag_show_variable_stop(0),
+			filename(),
+			printer_type(PRINTER_TYPE_CLASSIC_BRAINFUCK),
+			output_type(OUTPUT_TYPE_CHAR),
+			language(LANGUAGE_BRAINLOLLER),
+			engine(ENGINE_TYPE_REFERENCE),
+			flag_run(1),
+			flag_print(0),
+			max_instructions(0),
+			max_time(0),
+			checkpoint(),
+			checkpoint_interval(0),
+			restore(),
+			cache_dir(),
+			prefix_budget(10000000),
+			profile(),
+			superinstructions(),
+			jit_threshold(1024),
+			cell_size(20),
+			encode(),
+			print_file(),
+			tape_size(30000),
+			tape_allocator(TAPE_ALLOCATOR_DEFAULT),
+			flag_numa(0),
+			debug_input("/dev/tty"),
+			trace(),
+			flag_perf_map(0),
+			flag_stats(0),
+			flag_perf_counters(0),
+			flag_hang_check(1),
+			flag_async_io(0),
+			flag_watch(0),
+			flag_checked(0),
+			flag_verify(0),
+			verify_interval(4096),
+			record(),
+			replay(),
+			record_interval(0),
+			operands()
+			{}
+		inline ~configuration(void) {
+			this->global_argc = 0;
+			this->global_argv = nullptr;
+			this->flag_show_help = 0;
+			this->flag_show_version = 0;
+			this->flag_show_authors = 0;
+			this->flag_show_license = 0;
+			this->flag_show_variable = 0;
+			this->flag_show_variable_stop = 0;
+			this->filename.clear();
+			this->printer_type.clear();
+			this->output_type.clear();
+			this->language.clear();
+			this->engine.clear();
+			this->flag_run = 0;
+			this->flag_print = 0;
+			this->max_instructions = 0;
+			this->max_time = 0;
+			this->checkpoint.clear();
+			this->checkpoint_interval = 0;
+			this->restore.clear();
+			this->cache_dir.clear();
+			this->prefix_budget = 0;
+			this->profile.clear();
+			this->superinstructions.clear();
+			this->jit_threshold = 0;
+			this->cell_size = 0;
+			this->encode.clear();
+			this->print_file.clear();
+			this->tape_size = 0;
+			this->tape_allocator.clear();
+			this->flag_numa = 0;
+			this->debug_input.clear();
+			this->trace.clear();
+			this->flag_perf_map = 0;
+			this->flag_stats = 0;
+			this->flag_perf_counters = 0;
+			this->flag_hang_check = 0;
+			this->flag_async_io = 0;
+			this->flag_watch = 0;
+			this->flag_checked = 0;
+			this->flag_verify = 0;
+			this->verify_interval = 0;
+			this->record.clear();
+			this->replay.clear();
+			this->record_interval = 0;
+			this->operands.clear();
+		}
+	};
+		
+	typedef struct environment_names_s {
+		const char* name;
+		std::function<void(char const*)> setter;
+	} environment_names_t;
+
+	extern char** environ;
+
+	configuration config;
+
+#if !defined(BRAINLOLLER_LIBRARY)
+	option longopts[] = {
+		{"help",                no_argument,       &config.flag_show_help,          0x01}, // 'h'
+		{"version",             no_argument,       &config.flag_show_version,       0x01}, // 'v'
+		{"authors",             no_argument,       &config.flag_show_authors,       0x01}, // none
+		{"license",             no_argument,       &config.flag_show_license,       0x01}, // 'l'
+		{"file",                required_argument, 0,                               'f' }, // 'f'
+		{"show-variable",       no_argument,       &config.flag_show_variable,      0x01}, // 's'
+		{"show-variable-stop",  no_argument,       &config.flag_show_variable_stop, 0x01}, // none
+		{"set-printer-type",    no_argument,       0,                               'p'},  // 'p'
+		{"set-output-type",     no_argument,       0,                               'o'},  // 'o'
+		{"language",            no_argument,       0,                               'i'},  // 'i'
+		{"engine",              required_argument, 0,                               'e'},  // 'e'
+		{"run",                 no_argument,       &config.flag_run, 0x01},                // none
+		{"no-run",              no_argument,       &config.flag_run, 0x00},                // none
+		{"print",               no_argument,       &config.flag_print, 0x01},              // none
+		{"no-print",            no_argument,       &config.flag_print, 0x00},              // none
+		{"max-instructions",    required_argument, 0,                  OPT_MAX_INSTRUCTIONS}, // none
+		{"max-time",            required_argument, 0,                  OPT_MAX_TIME},      // none
+		{"checkpoint",          required_argument, 0,                  OPT_CHECKPOINT},    // none
+		{"checkpoint-interval", required_argument, 0,                  OPT_CHECKPOINT_INTERVAL}, // none
+		{"restore",             required_argument, 0,                  OPT_RESTORE},       // none
+		{"cache-dir",           required_argument, 0,                  OPT_CACHE_DIR},     // none
+		{"prefix-budget",       required_argument, 0,                  OPT_PREFIX_BUDGET}, // none
+		{"profile",             required_argument, 0,                  OPT_PROFILE},       // none
+		{"superinstructions",   required_argument, 0,                  OPT_SUPERINSTRUCTIONS}, // none
+		{"jit-threshold",       required_argument, 0,                  OPT_JIT_THRESHOLD}, // none
+		{"cell-size",           required_argument, 0,                  OPT_CELL_SIZE},     // none
+		{"encode",              required_argument, 0,                  OPT_ENCODE},        // none
+		{"print-file",          required_argument, 0,                  OPT_PRINT_FILE},    // none
+		{"tape-size",           required_argument, 0,                  OPT_TAPE_SIZE},     // none
+		{"tape-allocator",      required_argument, 0,                  OPT_TAPE_ALLOCATOR}, // none
+		{"numa",                no_argument,       &config.flag_numa, 0x01},               // none
+		{"no-numa",             no_argument,       &config.flag_numa, 0x00},               // none
+		{"debug-input",         required_argument, 0,                  OPT_DEBUG_INPUT},   // none
+		{"trace",               required_argument, 0,                  OPT_TRACE},         // none
+		{"perf-map",            no_argument,       &config.flag_perf_map, 0x01},           // none
+		{"no-perf-map",         no_argument,       &config.flag_perf_map, 0x00},           // none
+		{"stats",               no_argument,       &config.flag_stats, 0x01},              // none
+		{"no-stats",            no_argument,       &config.flag_stats, 0x00},              // none
+		{"perf-counters",       no_argument,       &config.flag_perf_counters, 0x01},      // none
+		{"no-perf-counters",    no_argument,       &config.flag_perf_counters, 0x00},      // none
+		{"hang-check",          no_argument,       &config.flag_hang_check, 0x01},         // none
+		{"no-hang-check",       no_argument,       &config.flag_hang_check, 0x00},         // none
+		{"async-io",            no_argument,       &config.flag_async_io, 0x01},           // none
+		{"no-async-io",         no_argument,       &config.flag_async_io, 0x00},           // none
+		{"watch",               no_argument,       &config.flag_watch, 0x01},              // none
+		{"no-watch",            no_argument,       &config.flag_watch, 0x00},              // none
+		{"checked",             no_argument,       &config.flag_checked, 0x01},            // none
+		{"no-checked",          no_argument,       &config.flag_checked, 0x00},            // none
+		{"verify",              no_argument,       &config.flag_verify, 0x01},             // none
+		{"no-verify",           no_argument,       &config.flag_verify, 0x00},             // none
+		{"verify-interval",     required_argument, 0,                  OPT_VERIFY_INTERVAL}, // none
+		{"record",              required_argument, 0,                  OPT_RECORD},        // none
+		{"replay",              required_argument, 0,                  OPT_REPLAY},        // none
+		{"record-interval",     required_argument, 0,                  OPT_RECORD_INTERVAL}, // none
+		{0,          0,                 0,                                          0x00}  // end
+	};
+#endif // !defined(BRAINLOLLER_LIBRARY)
+
+	environment_names_t env_names[] = {
+		{"BRAINLOLLER_FLAG_SHOW_HELP",          boost::bind(&configuration::set_flag_show_help, &config, _1)},
+		{"BRAINLOLLER_FLAG_SHOW_VERSION",       boost::bind(&configuration::set_flag_show_version, &config, _1)},
+		{"BRAINLOLLER_FLAG_SHOW_AUTHORS",       boost::bind(&configuration::set_flag_show_authors, &config, _1)},
+		{"BRAINLOLLER_FLAG_SHOW_LICENSE",       boost::bind(&configuration::set_flag_show_variable, &config, _1)},
+		{"BRAINLOLLER_FLAG_SHOW_VARIABLE",      boost::bind(&configuration::set_flag_show_variable, &config, _1)},
+		{"BRAINLOLLER_FLAG_SHOW_VARIABLE_STOP", boost::bind(&configuration::set_flag_show_variable_stop, &config, _1)},
+		{"BRAINLOLLER_FILENAME",                boost::bind(&configuration::set_filename, &config, _1)},
+		{"BRAINLOLLER_PRINTER_TYPE",            boost::bind(&configuration::set_printer_type, &config, _1)},
+		{"BRAINLOLLER_OUTPUT_TYPE",             boost::bind(&configuration::set_output_type, &config, _1)},
+		{"BRAINLOLLER_LANGUAGE",                boost::bind(&configuration::set_language, &config, _1)},
+		{"BRAINLOLLER_ENGINE",                  boost::bind(&configuration::set_engine, &config, _1)},
+		{"BRAINLOLLER_FLAG_RUN",                boost::bind(&configuration::set_flag_run, &config, _1)},
+		{"BRAINLOLLER_FLAG_PRINT",              boost::bind(&configuration::set_flag_print, &config, _1)},
+		{"BRAINLOLLER_MAX_INSTRUCTIONS",        boost::bind(&configuration::set_max_instructions, &config, _1)},
+		{"BRAINLOLLER_MAX_TIME",                boost::bind(&configuration::set_max_time, &config, _1)},
+		{"BRAINLOLLER_CHECKPOINT",              boost::bind(&configuration::set_checkpoint, &config, _1)},
+		{"BRAINLOLLER_CHECKPOINT_INTERVAL",     boost::bind(&configuration::set_checkpoint_interval, &config, _1)},
+		{"BRAINLOLLER_RESTORE",                 boost::bind(&configuration::set_restore, &config, _1)},
+		{"BRAINLOLLER_CACHE_DIR",               boost::bind(&configuration::set_cache_dir, &config, _1)},
+		{"BRAINLOLLER_PREFIX_BUDGET",           boost::bind(&configuration::set_prefix_budget, &config, _1)},
+		{"BRAINLOLLER_PROFILE",                 boost::bind(&configuration::set_profile, &config, _1)},
+		{"BRAINLOLLER_SUPERINSTRUCTIONS",       boost::bind(&configuration::set_superinstructions, &config, _1)},
+		{"BRAINLOLLER_JIT_THRESHOLD",           boost::bind(&configuration::set_jit_threshold, &config, _1)},
+		{"BRAINLOLLER_CELL_SIZE",               boost::bind(&configuration::set_cell_size, &config, _1)},
+		{"BRAINLOLLER_ENCODE",                  boost::bind(&configuration::set_encode, &config, _1)},
+		{"BRAINLOLLER_PRINT_FILE",              boost::bind(&configuration::set_print_file, &config, _1)},
+		{"BRAINLOLLER_TAPE_SIZE",               boost::bind(&configuration::set_tape_size, &config, _1)},
+		{"BRAINLOLLER_TAPE_ALLOCATOR",          boost::bind(&configuration::set_tape_allocator, &config, _1)},
+		{"BRAINLOLLER_FLAG_NUMA",               boost::bind(&configuration::set_flag_numa, &config, _1)},
+		{"BRAINLOLLER_DEBUG_INPUT",             boost::bind(&configuration::set_debug_input, &config, _1)},
+		{"BRAINLOLLER_TRACE",                   boost::bind(&configuration::set_trace, &config, _1)},
+		{"BRAINLOLLER_FLAG_PERF_MAP",           boost::bind(&configuration::set_flag_perf_map, &config, _1)},
+		{"BRAINLOLLER_FLAG_STATS",              boost::bind(&configuration::set_flag_stats, &config, _1)},
+		{"BRAINLOLLER_FLAG_PERF_COUNTERS",      boost::bind(&configuration::set_flag_perf_counters, &config, _1)},
+		{"BRAINLOLLER_FLAG_HANG_CHECK",         boost::bind(&configuration::set_flag_hang_check, &config, _1)},
+		{"BRAINLOLLER_FLAG_ASYNC_IO",           boost::bind(&configuration::set_flag_async_io, &config, _1)},
+		{"BRAINLOLLER_FLAG_WATCH",              boost::bind(&configuration::set_flag_watch, &config, _1)},
+		{"BRAINLOLLER_FLAG_CHECKED",            boost::bind(&configuration::set_flag_checked, &config, _1)},
+		{"BRAINLOLLER_FLAG_VERIFY",             boost::bind(&configuration::set_flag_verify, &config, _1)},
+		{"BRAINLOLLER_VERIFY_INTERVAL",         boost::bind(&configuration::set_verify_interval, &config, _1)},
+		{"BRAINLOLLER_RECORD",                  boost::bind(&configuration::set_record, &config, _1)},
+		{"BRAINLOLLER_REPLAY",                  boost::bind(&configuration::set_replay, &config, _1)},
+		{"BRAINLOLLER_RECORD_INTERVAL",         boost::bind(&configuration::set_record_interval, &config, _1)},
+		{"BRAINLOLLER_OPERANDS",                boost::bind(&configuration::set_operands, &config, _1)},
+	};
+
+#if !defined(BRAINLOLLER_LIBRARY)
+	void usage(void) noexcept {
+		std::cout << "Program: " << PROG_NAME << " (" << PROG_NAME_FULL << ")" << std::endl;
+		std::cout << "Use --help or -h for help" << std::endl;
+	}
+
+	void help() noexcept {
+		version();
+		authors();
+	
+		std::cout << std::endl << "This program uses getopts' rules (with long opts)." << std::endl;
+		std::cout << "You can see \"man 3 getopt_long\" or \"info getopt_long\" for more help." << std::endl;
+		std::cout << std::endl << "Use " << config.global_argv[0] << " [OPTIONS]" << std::endl;
+		std::cout << std::endl << "Options:" << std::endl;
+		std::cout <<"-h\t--help\t\t\t\t" << "- show this help and exit" << std::endl;
+		std::cout <<"-v\t--version\t\t\t" << "- show program version and exit" << std::endl;
+		std::cout <<"\t--authors\t\t\t" << "- show authors and exit" << std::endl;
+		std::cout <<"-l\t--license\t\t\t" << "- show license and exit" << std::endl;
+		std::cout <<"-f\t--file=[STRING]\t\t\t" << "- set filename" << std::endl;
+		std::cout <<"-s\t--show-variable\t\t\t" << "- show internal variables (for debug)" << std::endl;
+		std::cout <<"\t--show-variable-stop\t\t" << "- show internal variables and stop (for debug)" << std::endl;
+		std::cout <<"-p\t--set-printer-type\t\t" << "- set printer type" << std::endl;
+		std::cout <<"-o\t--set-output-type\t\t" << "- set type of output" << std::endl;
+		std::cout <<"-i\t--language\t\t\t" << "- set language name" << std::endl;
+		std::cout <<"-e\t--engine=[STRING]\t\t" << "- set engine (interpretator) type" << std::endl;
+		std::cout <<"\t--run\t\t\t\t" << "- run interpretator" << std::endl;
+		std::cout <<"\t--no-run\t\t\t" << "- don't run interpretator" << std::endl;
+		std::cout <<"\t--print\t\t\t\t" << "- run printer (retranslator)" << std::endl;
+		std::cout <<"\t--no-print\t\t\t" << "- don't run printer (retranslator)" << std::endl;
+		std::cout <<"\t--print-file=[STRING]\t\t" << "- write result of printer to file (default - stdout)" << std::endl;
+		std::cout <<"\t--tape-size=[NUMBER]\t\t" << "- cells of the tape" << std::endl;
+		std::cout <<"\t--tape-allocator=[STRING]\t" << "- set allocator of the tape" << std::endl;
+		std::cout <<"\t--numa\t\t\t\t" << "- place the tape on NUMA node of the current CPU (pin the run with taskset)" << std::endl;
+		std::cout <<"\t--no-numa\t\t\t" << "- don't bind the tape to NUMA node" << std::endl;
+		std::cout <<"\t--debug-input=[STRING]\t\t" << "- read commands of the debugger from file (default - /dev/tty)" << std::endl;
+		std::cout <<"\t--trace=[STRING]\t\t" << "- write phases of the run to file (Chrome trace JSON)" << std::endl;
+		std::cout <<"\t--perf-map\t\t\t" << "- write /tmp/perf-PID.map for generated code (for perf)" << std::endl;
+		std::cout <<"\t--no-perf-map\t\t\t" << "- don't write map for perf" << std::endl;
+		std::cout <<"\t--stats\t\t\t\t" << "- write statistics of the run at exit (JSON, to stderr)" << std::endl;
+		std::cout <<"\t--no-stats\t\t\t" << "- don't write statistics" << std::endl;
+		std::cout <<"\t--perf-counters\t\t\t" << "- add hardware counters of every phase to statistics (implies --stats)" << std::endl;
+		std::cout <<"\t--no-perf-counters\t\t" << "- don't read hardware counters" << std::endl;
+		std::cout <<"\t--hang-check\t\t\t" << "- stop provably infinite loops (compiled engines, default)" << std::endl;
+		std::cout <<"\t--no-hang-check\t\t\t" << "- don't look for infinite loops" << std::endl;
+		std::cout <<"\t--async-io\t\t\t" << "- write the output and read the input by separate threads" << std::endl;
+		std::cout <<"\t--no-async-io\t\t\t" << "- write the output and read the input by the interpreter" << std::endl;
+		std::cout <<"\t--watch\t\t\t\t" << "- run the program again each time the image is changed" << std::endl;
+		std::cout <<"\t--no-watch\t\t\t" << "- run the program once" << std::endl;
+		std::cout <<"\t--checked\t\t\t" << "- stop the program when the head leaves the tape (untrusted images)" << std::endl;
+		std::cout <<"\t--no-checked\t\t\t" << "- don't check the head" << std::endl;
+		std::cout <<"\t--verify\t\t\t" << "- run the engine in the shadow of the reference one and compare (file or directory)" << std::endl;
+		std::cout <<"\t--no-verify\t\t\t" << "- run the program" << std::endl;
+		std::cout <<"\t--verify-interval=[NUMBER]\t" << "- loop iterations between checksums of the tape (for '--verify')" << std::endl;
+		std::cout <<"\t--record=[STRING]\t\t" << "- write the options, the input and the result of the run to file" << std::endl;
+		std::cout <<"\t--replay=[STRING]\t\t" << "- run again the recorded run (by the engine of '-e') and compare" << std::endl;
+		std::cout <<"\t--record-interval=[NUMBER]\t" << "- loop iterations between checksums of the tape (for '--record', 0 - none)" << std::endl;
+		std::cout <<"\t--max-instructions=[NUMBER]\t" << "- stop the program after NUMBER instructions (0 - no limit)" << std::endl;
+		std::cout <<"\t--max-time=[MILLISECONDS]\t" << "- stop the program after MILLISECONDS of work (0 - no limit)" << std::endl;
+		std::cout <<"\t--checkpoint=[STRING]\t\t" << "- write state of machine to file on SIGUSR1 or by interval" << std::endl;
+		std::cout <<"\t--checkpoint-interval=[SECONDS]\t" << "- write checkpoint every SECONDS (0 - by SIGUSR1 only)" << std::endl;
+		std::cout <<"\t--restore=[STRING]\t\t" << "- continue the program from checkpoint file" << std::endl;
+		std::cout <<"\t--cache-dir=[STRING]\t\t" << "- directory of compiled programs (for compiled engine)" << std::endl;
+		std::cout <<"\t--prefix-budget=[NUMBER]\t" << "- steps of precomputation of the program before input (0 - disable)" << std::endl;
+		std::cout <<"\t--profile=[STRING]\t\t" << "- write opcode statistics of the run (for threaded engine)" << std::endl;
+		std::cout <<"\t--superinstructions=[STRING]\t" << "- choose superinstructions by opcode statistics (for threaded engine)" << std::endl;
+		std::cout <<"\t--jit-threshold=[NUMBER]\t" << "- back-edges of loop before native compilation (for tiered engine, 0 - never)" << std::endl;
+		std::cout <<"\t--cell-size=[NUMBER]\t\t" << "- size of cell of the image in pixels" << std::endl;
+		std::cout <<"\t--encode=[STRING]\t\t" << "- encode Brainfuck source (see '-f') into Brainloller image and exit" << std::endl;
+		std::cout << std::endl << "Environment:" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_HELP\t\t" << "- same as '-h|--help': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VERSION\t\t" << "- same as '-v|--version': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_AUTHORS\t\t" << "- same as '--authors': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_LICENSE\t\t" << "- same as '-l|--license': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VARIABLE\t\t" << "- same as '-s|--show-variable': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_SHOW_VARIABLE_STOP\t" << "- same as '--show-variable-stop': {0,1}" << std::endl;
+		std::cout << "\tBRAINLOLLER_FILENAME\t\t\t" << "- same as '-f|--file'" << std::endl;
+		std::cout << "\tBRAINLOLLER_PRINTER_TYPE\t\t" << "- same as '-p|--set-printer-type'" << std::endl;
+		std::cout << "\tBRAINLOLLER_OUTPUT_TYPE\t\t\t" << "- same as '-o|--set-output-type'" << std::endl;
+		std::cout << "\tBRAINLOLLER_LANGUAGE\t\t\t" << "- same as '-i|--language'" << std::endl;
+		std::cout << "\tBRAINLOLLER_ENGINE\t\t\t" << "- same as '-e|--engine'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_RUN\t\t\t" << "- same as '--run|--no-run'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_PRINT\t\t\t" << "- same as '--print|--no-print'" << std::endl;
+		std::cout << "\tBRAINLOLLER_MAX_INSTRUCTIONS\t\t" << "- same as '--max-instructions'" << std::endl;
+		std::cout << "\tBRAINLOLLER_MAX_TIME\t\t\t" << "- same as '--max-time'" << std::endl;
+		std::cout << "\tBRAINLOLLER_CHECKPOINT\t\t\t" << "- same as '--checkpoint'" << std::endl;
+		std::cout << "\tBRAINLOLLER_CHECKPOINT_INTERVAL\t\t" << "- same as '--checkpoint-interval'" << std::endl;
+		std::cout << "\tBRAINLOLLER_RESTORE\t\t\t" << "- same as '--restore'" << std::endl;
+		std::cout << "\tBRAINLOLLER_CACHE_DIR\t\t\t" << "- same as '--cache-dir'" << std::endl;
+		std::cout << "\tBRAINLOLLER_PREFIX_BUDGET\t\t" << "- same as '--prefix-budget'" << std::endl;
+		std::cout << "\tBRAINLOLLER_PROFILE\t\t\t" << "- same as '--profile'" << std::endl;
+		std::cout << "\tBRAINLOLLER_SUPERINSTRUCTIONS\t\t" << "- same as '--superinstructions'" << std::endl;
+		std::cout << "\tBRAINLOLLER_JIT_THRESHOLD\t\t" << "- same as '--jit-threshold'" << std::endl;
+		std::cout << "\tBRAINLOLLER_CELL_SIZE\t\t\t" << "- same as '--cell-size'" << std::endl;
+		std::cout << "\tBRAINLOLLER_ENCODE\t\t\t" << "- same as '--encode'" << std::endl;
+		std::cout << "\tBRAINLOLLER_PRINT_FILE\t\t\t" << "- same as '--print-file'" << std::endl;
+		std::cout << "\tBRAINLOLLER_TAPE_SIZE\t\t\t" << "- same as '--tape-size'" << std::endl;
+		std::cout << "\tBRAINLOLLER_TAPE_ALLOCATOR\t\t" << "- same as '--tape-allocator'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_NUMA\t\t\t" << "- same as '--numa|--no-numa'" << std::endl;
+		std::cout << "\tBRAINLOLLER_DEBUG_INPUT\t\t\t" << "- same as '--debug-input'" << std::endl;
+		std::cout << "\tBRAINLOLLER_TRACE\t\t\t" << "- same as '--trace'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_PERF_MAP\t\t" << "- same as '--perf-map|--no-perf-map'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_STATS\t\t\t" << "- same as '--stats|--no-stats'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_PERF_COUNTERS\t\t" << "- same as '--perf-counters|--no-perf-counters'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_HANG_CHECK\t\t" << "- same as '--hang-check|--no-hang-check'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_ASYNC_IO\t\t" << "- same as '--async-io|--no-async-io'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_WATCH\t\t\t" << "- same as '--watch|--no-watch'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_CHECKED\t\t" << "- same as '--checked|--no-checked'" << std::endl;
+		std::cout << "\tBRAINLOLLER_FLAG_VERIFY\t\t\t" << "- same as '--verify|--no-verify'" << std::endl;
+		std::cout << "\tBRAINLOLLER_VERIFY_INTERVAL\t\t" << "- same as '--verify-interval'" << std::endl;
+		std::cout << "\tBRAINLOLLER_RECORD\t\t\t" << "- same as '--record'" << std::endl;
+		std::cout << "\tBRAINLOLLER_REPLAY\t\t\t" << "- same as '--replay'" << std::endl;
+		std::cout << "\tBRAINLOLLER_RECORD_INTERVAL\t\t" << "- same as '--record-interval'" << std::endl;
+		std::cout << std::endl << "Printers:" << std::endl;
+		std::cout << "\t" << PRINTER_TYPE_NULL << "\t\t" << "- NULL printer (print nothing)" << std::endl;
+		std::cout << "\t" << PRINTER_TYPE_SIMPLE << "\t\t" << "- SIMPLE printer (show internal codes without spaces)" << std::endl;
+		std::cout << "\t" << PRINTER_TYPE_SIMPLE_SPACE << "\t" << "- SIMPLE WITH SPACE printer (show internal codes with spaces)" << std::endl;
+		std::cout << "\t" << PRINTER_TYPE_CLASSIC_BRAINFUCK << "\t" << "- CLASSICAL BRAINFUCK printer (show comands of Brainfuck language)" << std::endl;
+		std::cout << std::endl << "Outputs:" << std::endl;
+		std::cout << "\t" << OUTPUT_TYPE_NULL << "\t\t" << "- NULL output" << std::endl;
+		std::cout << "\t" << OUTPUT_TYPE_CHAR << "\t\t" << "- CHAR output" << std::endl;
+		std::cout << "\t" << OUTPUT_TYPE_HEX << "\t\t" << "- HEX output" << std::endl;
+		std::cout << "\t" << OUTPUT_TYPE_BOTH << "\t\t" << "- CHAR AND HEX output" << std::endl;
+		std::cout << std::endl << "Language:" << std::endl;
+		std::cout << "\t" << LANGUAGE_BRAINLOLLER << "\t" << "- Brainloller (limited edition)" << std::endl;
+		std::cout << "\t" << LANGUAGE_BRAINFUCK << "\t" << "- Brainfuck (not support in current version of program) " << std::endl;
+		std::cout << std::endl << "Engines:" << std::endl;
+		std::cout << "\t" << ENGINE_TYPE_REFERENCE << "\t" << "- REFERENCE engine (walks the image instruction by instruction)" << std::endl;
+		std::cout << "\t" << ENGINE_TYPE_COMPILED << "\t" << "- COMPILED engine (decodes and optimizes the program before the run)" << std::endl;
+		std::cout << "\t" << ENGINE_TYPE_THREADED << "\t" << "- THREADED engine (compiled engine with threaded code and superinstructions)" << std::endl;
+		std::cout << "\t" << ENGINE_TYPE_DEBUG << "\t\t" << "- DEBUG engine (reference engine with interactive debugger, see '--debug-input')" << std::endl;
+		std::cout << "\t" << ENGINE_TYPE_TIERED << "\t\t" << "- TIERED engine (compiled engine, hot loops are compiled to native code)" << std::endl;
+		std::cout << std::endl << "Tape allocators:" << std::endl;
+		std::cout << "\t" << TAPE_ALLOCATOR_DEFAULT << "\t" << "- DEFAULT allocator" << std::endl;
+		std::cout << "\t" << TAPE_ALLOCATOR_ALIGNED << "\t" << "- ALIGNED to page (and cache line)" << std::endl;
+		std::cout << "\t" << TAPE_ALLOCATOR_HUGEPAGES << "\t" << "- transparent HUGE PAGES (madvise)" << std::endl;
+		std::cout << "\t" << TAPE_ALLOCATOR_HUGETLB << "\t\t" << "- explicit huge pages (HUGETLBFS), transparent if none are reserved" << std::endl;
+		std::cout << std::endl << "Exit status:" << std::endl;
+		std::cout << "\t" << EXIT_SUCCESS << "\t\t" << "- success" << std::endl;
+		std::cout << "\t" << EXIT_FAILURE << "\t\t" << "- wrong options or arguments" << std::endl;
+		std::cout << "\t" << EXIT_INSTRUCTION_LIMIT << "\t\t" << "- program was stopped by '--max-instructions'" << std::endl;
+		std::cout << "\t" << EXIT_TIME_LIMIT << "\t\t" << "- program was stopped by '--max-time'" << std::endl;
+		std::cout << "\t" << EXIT_INFINITE_LOOP << "\t\t" << "- program was stopped by '--hang-check': the loop never ends" << std::endl;
+		std::cout << "\t" << EXIT_TAPE_BOUNDS << "\t\t" << "- program was stopped by '--checked': the head is out of the tape" << std::endl;
+		std::cout << "\t" << EXIT_DIVERGED << "\t\t" << "- the engine diverged from the reference one ('--verify') or from the recording ('--replay')" << std::endl;
+		std::cout << std::endl << "Example:" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " --help" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -l" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -i brainloller -p brainfuck -o char --run --print --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -i brainloller -o both --run --no-print --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -p brainfuck --print --print-file=l1.b --no-run --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png --max-instructions=1000000 --max-time=500 --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png --checkpoint=l1.state --checkpoint-interval=60 --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png --restore=l1.state --checkpoint=l1.state --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e threaded --profile=l1.profile --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e threaded --superinstructions=l1.profile --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.b --encode=l1.png --cell-size=4 --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e debug --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e compiled --trace=l1.json --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e compiled --stats -- 2> l1.stats" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e tiered --record=l1.rec --record-interval=4096 --" << std::endl;
+		std::cout << "\t" << config.global_argv[0] << " -f l1.png -e threaded --replay=l1.rec --profile=l1.profile --" << std::endl;
+		std::cout << "\ttaskset -c 2 " << config.global_argv[0] << " -f l1.png --tape-size=67108864 --tape-allocator=hugepages --numa --" << std::endl;
+	}
+
+	/// @brief Write the trace at exit (the run can be stopped by ::exit anywhere)
+	///
+	///
+	void save_trace(void) {
+		std::cout.flush();
+
+		if(!tracing::save(config.trace)) {
+			std::cerr << "Trace can't be written: " << config.trace << std::endl;
+		}
+	}
+
+	/// @brief Write statistics of the run at exit (JSON)
+	///
+	///
+	void save_stats(void) {
+		struct rusage usage;
+		double const wall = static_cast<double>(tracing::now()) / 1e9;
+		double cpu = 0;
+		long rss = 0;
+		unsigned const hw_mask = (tracing::hardware) ? tracing::hw_available.load() : 0;
+		std::ostringstream oss;
+
+		if(!::getrusage(RUSAGE_SELF, &usage)) {
+			cpu = static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+				static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+			rss = usage.ru_maxrss;
+		}
+
+		std::cout.flush();
+
+		oss << std::fixed << std::setprecision(6);
+		oss << "{" << std::endl;
+		oss << "  \"engine\": " << utils::json_string(config.engine) << "," << std::endl;
+		oss << "  \"file\": " << utils::json_string(config.filename) << "," << std::endl;
+		oss << "  \"wall_time\": " << wall << "," << std::endl;
+		oss << "  \"cpu_time\": " << cpu << "," << std::endl;
+		oss << "  \"peak_rss_kb\": " << rss << "," << std::endl;
+
+		if(tracing::counters.valid) {
+			oss << "  \"instructions\": " << tracing::counters.executed << "," << std::endl;
+			oss << "  \"loop_iterations\": " << tracing::counters.back_edges << "," << std::endl;
+			oss << "  \"bytes_in\": " << tracing::counters.bytes_in << "," << std::endl;
+			oss << "  \"bytes_out\": " << tracing::counters.bytes_out << "," << std::endl;
+			oss << "  \"peak_tape_extent\": " << tracing::counters.tape_extent << "," << std::endl;
+		}
+		if(tracing::counters.optimized) {
+			oss << "  \"eliminated_instructions\": " << tracing::counters.eliminated << "," << std::endl;
+		}
+
+		if(tracing::hardware) {
+			char const* sep = "";
+
+			oss << "  \"perf_counters\": [";
+			for(std::size_t i = 0; i < tracing::HW_COUNT; ++i) {
+				if(hw_mask & (1u << i)) {
+					oss << sep << "\"" << tracing::HW_NAMES[i] << "\"";
+					sep = ", ";
+				}
+			}
+			oss << "]," << std::endl;
+			if(tracing::hw_error) {
+				oss << "  \"perf_counters_error\": " << utils::json_string(std::strerror(tracing::hw_error)) << "," << std::endl;
+			}
+		}
+
+		oss << "  \"phases\": {";
+		{
+			std::lock_guard<std::mutex> lock(tracing::phases_mutex);
+			char const* sep = "";
+
+			std::for_each(tracing::phases.begin(), tracing::phases.end(), [&oss, &sep, hw_mask](tracing::phase_t const& x)->void {
+					oss << sep << std::endl << "    " << utils::json_string(x.name) << ": {"
+						<< "\"count\": " << x.count << ", "
+						<< "\"wall_time\": " << static_cast<double>(x.wall) / 1e9 << ", "
+						<< "\"cpu_time\": " << static_cast<double>(x.cpu) / 1e9;
+					for(std::size_t i = 0; i < tracing::HW_COUNT; ++i) {
+						if(hw_mask & (1u << i)) {
+							oss << ", \"" << tracing::HW_NAMES[i] << "\": " << x.hw.value[i];
+						}
+					}
+					if((hw_mask & (1u << tracing::HW_CYCLES)) && (hw_mask & (1u << tracing::HW_INSTRUCTIONS))) {
+						oss << ", \"ipc\": " << ((x.hw.value[tracing::HW_CYCLES]) ?
+												  static_cast<double>(x.hw.value[tracing::HW_INSTRUCTIONS]) / x.hw.value[tracing::HW_CYCLES] : 0.0);
+					}
+					if((hw_mask & (1u << tracing::HW_BRANCHES)) && (hw_mask & (1u << tracing::HW_BRANCH_MISSES))) {
+						oss << ", \"branch_miss_rate\": " << ((x.hw.value[tracing::HW_BRANCHES]) ?
+															   static_cast<double>(x.hw.value[tracing::HW_BRANCH_MISSES]) / x.hw.value[tracing::HW_BRANCHES] : 0.0);
+					}
+					oss << "}";
+					sep = ",";
+				});
+		}
+		oss << std::endl << "  }" << std::endl;
+		oss << "}" << std::endl;
+
+		std::cerr << oss.str();
+	}
+
+	void license() noexcept {
+		std::cout << PROG_LICENSE << std::endl;
+	}
+
+	void authors() noexcept {
+		std::cout << "Authors: " << PROG_AUTHORS << std::endl;
+	}
+
+	void version() noexcept {
+		std::cout << "Program: " << PROG_NAME << " (" << PROG_NAME_FULL << ")" << std::endl;
+		std::cout << "Version: " << PROG_VERSION << std::endl;
+	}
+#endif // !defined(BRAINLOLLER_LIBRARY)
+	
+	// *************************************************************************
+	// Common types, enums etc
+	// *************************************************************************
+	
+	/// @brief
+	///
+	///
+	enum Operation {
+		OP_UNKNOWN = 0,              // Неизвестная комманда
+		OP_INC_CELL,                 // Увеличить текущее значение ячейки ленты памяти на единицу
+		OP_DEC_CELL,                 // Уменьшить текущее значение ячейки ленты памяти на единицу
+		OP_NEXT_CELL,                // Сдвинуть указатель текущей ячейки ленты памяти вправо на одну ячейку
+		OP_PREV_CELL,                // Сдвинуть указатель текущей ячейки ленты памяти вправо на одну ячейку
+		OP_READ,                     // Ввод
+		OP_WRITE,                    // Вывод
+		OP_BEGIN_LOOP,               //
+		OP_END_LOOP,                 //
+		OP_ROTATE_CLOCKWISE,         //
+		OP_ROTATE_COUNTER_CLOCKWISE, // 
+		OP_COUNT                     // Количество операций (не операция, размер таблиц)
+	};
+
+	/// @brief
+	///
+	///
+	enum OutputType {
+		OT_NULL = 0,     // Пустой вывод (глушить вывод)
+		OT_CHAR,         // Символы
+		OT_HEX,          // Шестнадцатеричные числа
+		OT_BOTH          // Оба (символы и шестнадцатеричные числа)
+	};
+	
+	/// @brief How the memory of the tape is allocated
+	///
+	///
+	enum TapeAllocation {
+		TA_DEFAULT = 0,  // Стандартный аллокатор
+		TA_ALIGNED,      // Выравнивание на границу страницы (и строки кэша)
+		TA_HUGEPAGES,    // Transparent huge pages (madvise)
+		TA_HUGETLB       // Явные huge pages (hugetlbfs), если нет - transparent huge pages
+	};
+
+	/// @brief Limits of one run of a machine
+	///
+	/// @note Zero means "no limit". Limits are checked on back-edges of loops only:
+	///       a program without loops always terminates by itself.
+	struct MachineLimits {
+		boost::uint64_t max_instructions; // Executed instructions
+		boost::uint64_t max_time;         // Milliseconds of work
+		bool hang_check;                  // Stop loops which provably never end
+	};
+
+	/// @brief Streams of the program of a machine (the standard ones by default)
+	///
+	/// @note The console mode prompts before every read, reads symbols (spaces are skipped)
+	///       and ends the output with a new line. The library (see brainloller.h) gives bare
+	///       streams: bytes in, bytes out.
+	struct MachineStreams {
+		std::istream* in;
+		std::ostream* out;
+		bool console;
+	};
+
+	MachineStreams const CONSOLE_STREAMS = {&std::cin, &std::cout, true};
+
+	/// @brief Coordinates of the cell of the image (in cells, not in pixels)
+	///
+	///
+	struct GridPosition {
+		boost::uint32_t x;
+		boost::uint32_t y;
+	};
+
+	/// @brief Options of checkpoints (snapshots of the machine state)
+	///
+	/// @note A checkpoint is written on back-edge of loop when the interval is over or when
+	///       the process got SIGUSR1. Interval is in seconds, zero means "by signal only".
+	struct CheckpointOptions {
+		std::string filename;    // Where to write checkpoints (empty - never)
+		std::string restore;     // Checkpoint to resume from (empty - start from scratch)
+		boost::uint64_t interval;
+	};
+
+	/// @brief Options of the tape
+	///
+	///
+	struct TapeOptions {
+		boost::uint64_t size;      // Cells of the tape (zero - default size)
+		TapeAllocation allocation;
+		bool numa;                 // Bind the tape to NUMA node of the current CPU
+		bool checked;              // Stop the program when the head leaves the tape (see BoundsChecker)
+	};
+
+	/// @brief Options of the debugger (see DebugGraphicMachine)
+	///
+	///
+	struct DebuggerOptions {
+		std::string input; // Commands of the debugger
+	};
+
+	/// @brief Options of the program compiler (see ProgramCompiler and PrefixEvaluator)
+	///
+	///
+	struct CompilerOptions {
+		std::string cache_dir;         // Directory of compiled programs (empty - no cache)
+		boost::uint64_t prefix_budget; // Steps of partial evaluation (zero - disabled)
+		std::string profile;           // Where to write the profile of the run (empty - no profiling)
+		std::string superinstructions; // Profile to choose superinstructions by (empty - none)
+		boost::uint32_t jit_threshold; // Back-edges of loop before native compilation (zero - never)
+	};
+
+	// *************************************************************************
+	// Common and specific exceptions' interfaces and exceptions' classes
+	// *************************************************************************
+
+	/// @brief
+	///
+	///
+	class IMachineException : public std::exception {
+		typedef IMachineException self;
+	protected:
+		IMachineException(void) noexcept {}
+	public:
+		virtual ~IMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class ShitHappendGraphicMachineException : public IMachineException {
+		typedef ShitHappendGraphicMachineException self;
+	public:
+		ShitHappendGraphicMachineException(void) {}
+		virtual ~ShitHappendGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class UnsupportOperationGraphicMachineException : public IMachineException {
+		typedef UnsupportOperationGraphicMachineException self;
+	public:
+		UnsupportOperationGraphicMachineException(void) {}
+		virtual ~UnsupportOperationGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class UnknownOperationGraphicMachineException : public IMachineException {
+		typedef UnknownOperationGraphicMachineException self;
+	public:
+		UnknownOperationGraphicMachineException(void) {}
+		virtual ~UnknownOperationGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class UnexpectedOperationGraphicMachineException : public IMachineException {
+		typedef UnexpectedOperationGraphicMachineException self;
+	public:
+		UnexpectedOperationGraphicMachineException(void) {}
+		virtual ~UnexpectedOperationGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class UnexpectedEndOfProgrammGraphicMachineException : public IMachineException {
+		typedef UnexpectedEndOfProgrammGraphicMachineException self;
+	public:
+		UnexpectedEndOfProgrammGraphicMachineException(void) {}
+		virtual ~UnexpectedEndOfProgrammGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+	
+	/// @brief
+	///
+	///
+	class InstructionLimitGraphicMachineException : public IMachineException {
+		typedef InstructionLimitGraphicMachineException self;
+	public:
+		InstructionLimitGraphicMachineException(void) {}
+		virtual ~InstructionLimitGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class TimeLimitGraphicMachineException : public IMachineException {
+		typedef TimeLimitGraphicMachineException self;
+	public:
+		TimeLimitGraphicMachineException(void) {}
+		virtual ~TimeLimitGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+	
+	/// @brief
+	///
+	///
+	class InfiniteLoopGraphicMachineException : public IMachineException {
+		typedef InfiniteLoopGraphicMachineException self;
+	public:
+		InfiniteLoopGraphicMachineException(void) {}
+		virtual ~InfiniteLoopGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class TapeBoundsGraphicMachineException : public IMachineException {
+		typedef TapeBoundsGraphicMachineException self;
+	public:
+		TapeBoundsGraphicMachineException(void) {}
+		virtual ~TapeBoundsGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class LoopedPathGraphicMachineException : public IMachineException {
+		typedef LoopedPathGraphicMachineException self;
+	public:
+		LoopedPathGraphicMachineException(void) {}
+		virtual ~LoopedPathGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class OutputGraphicMachineException : public IMachineException {
+		typedef OutputGraphicMachineException self;
+	public:
+		OutputGraphicMachineException(void) {}
+		virtual ~OutputGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class EncoderGraphicMachineException : public IMachineException {
+		typedef EncoderGraphicMachineException self;
+	public:
+		EncoderGraphicMachineException(void) {}
+		virtual ~EncoderGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class DebuggerGraphicMachineException : public IMachineException {
+		typedef DebuggerGraphicMachineException self;
+	public:
+		DebuggerGraphicMachineException(void) {}
+		virtual ~DebuggerGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+
+	/// @brief
+	///
+	///
+	class CheckpointGraphicMachineException : public IMachineException {
+		typedef CheckpointGraphicMachineException self;
+	public:
+		CheckpointGraphicMachineException(void) {}
+		virtual ~CheckpointGraphicMachineException(void) noexcept {}
+		virtual const char* what(void) const noexcept {
+			return self::msg.c_str();
+		}
+	private:
+		static std::string const msg;
+	};
+	
+	std::string const IMachineException::msg = std::string("Error! It's a base IMachineException! Your code is shit");
+	std::string const ShitHappendGraphicMachineException::msg = std::string("Unknown exception!");
+	std::string const UnsupportOperationGraphicMachineException::msg = std::string("Unsupport operation!");
+	std::string const UnknownOperationGraphicMachineException::msg = std::string("Unknown operation!");
+	std::string const UnexpectedOperationGraphicMachineException::msg = std::string("Unexpected operation!");
+	std::string const UnexpectedEndOfProgrammGraphicMachineException::msg = std::string("Unexpected end of program!");
+	std::string const InstructionLimitGraphicMachineException::msg = std::string("Instruction limit exceeded!");
+	std::string const TimeLimitGraphicMachineException::msg = std::string("Time limit exceeded!");
+	std::string const InfiniteLoopGraphicMachineException::msg = std::string("Infinite loop detected!");
+	std::string const TapeBoundsGraphicMachineException::msg = std::string("Head is out of the tape!");
+	std::string const CheckpointGraphicMachineException::msg = std::string("Bad checkpoint file or checkpoint can't be written!");
+	std::string const LoopedPathGraphicMachineException::msg = std::string("Path of the program is looped!");
+	std::string const DebuggerGraphicMachineException::msg = std::string("Commands of the debugger can't be read!");
+	std::string const OutputGraphicMachineException::msg = std::string("Output is refused by the user of the library!");
+	std::string const EncoderGraphicMachineException::msg = std::string("Source can't be read or image can't be written!");
+
+	// *************************************************************************
+	// Main interfaces
+	// *************************************************************************
+	
+	/// @brief
+	///
+	///
+	class IPrinter {
+	public:
+		/// @brief
+		///
+		///
+		virtual ~IPrinter(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual std::string print(Operation op) const = 0;
+
+		/// @brief Bulk retranslation: append text of all operations to the buffer
+		///
+		/// @note Printers override it with the static tables; this version is for printers
+		///       which have print(Operation) only.
+		virtual void retranslate(Operation const* ops, std::size_t size, std::string& out) const {
+			std::for_each(ops, ops + size, [this, &out](Operation op)->void {
+					out += this->print(op);
+				});
+		}
+	};
+
+	/// @brief
+	///
+	///
+	class IIteratorMachine {
+	public:
+		///
+		///
+		///
+		IIteratorMachine(void) noexcept {}
+
+		///
+		///
+		///
+		virtual ~IIteratorMachine() noexcept {}
+	
+		///
+		///
+		///
+		virtual void init(void) = 0;
+	
+		///
+		///
+		///
+		virtual boost::uint32_t get_size(void) const = 0;
+	
+		///
+		///
+		///
+		virtual boost::uint32_t get_cur_pos(void) const = 0;
+	
+		///
+		///
+		///
+		virtual void set_cur_pos(boost::uint32_t pos) = 0;
+	
+		///
+		///
+		///
+		virtual Operation get_next(void) = 0;
+
+		///
+		///
+		///
+		virtual boost::uint32_t read(Operation* ops, boost::uint32_t size) = 0;
+	
+		///
+		///
+		///
+		virtual bool is_done(void) const = 0;
+
+		///
+		///
+		///
+		virtual boost::uint64_t get_hash(void) const = 0;
+
+		///
+		///
+		///
+		virtual GridPosition get_position(boost::uint32_t pos) const = 0;
+
+		/// @brief Read the program again after it was changed (false - operations are the same)
+		///
+		///
+		virtual bool reload(void) = 0;
+	};
+
+	/// @brief
+	///
+	///
+	class IMachine {
+	public:
+	
+		/// @brief
+		///
+		///
+		virtual ~IMachine() noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void init(void) = 0;
+	
+		/// @brief
+		///
+		///
+		virtual void run(void) = 0;
+	
+		/// @brief
+		///
+		///
+		virtual void print(std::ostream& os) = 0;
+
+		/// @brief Replace the streams of the program (see MachineStreams)
+		///
+		///
+		virtual void set_streams(MachineStreams const& s) = 0;
+
+		/// @brief Counters of the last run
+		///
+		///
+		virtual tracing::counters_t get_counters(void) const = 0;
+	};
+	
+	/// @brief
+	///
+	///
+	class IMachineCreator {
+	public:
+		IMachineCreator(void) noexcept {}
+		virtual ~IMachineCreator(void) noexcept {}
+		virtual std::shared_ptr<IMachine> create(void) const = 0;
+	};
+		
+	// *************************************************************************
+	// Main classes
+	// *************************************************************************
+	
+	/// @brief
+	///
+	///
+	class NullPrinter : public IPrinter {
+		typedef NullPrinter self;
+	public:
+		/// @brief
+		///
+		///
+		NullPrinter(void) {
+		}
+
+		/// @brief Destructor of class
+		///
+		///
+		virtual ~NullPrinter(void) noexcept {}
+
+		///
+		///
+		///
+		virtual std::string print(Operation op) const {
+			UNUSED_SUPPRESSOR(op);
+			
+			return std::string();
+		}
+
+		///
+		///
+		///
+		virtual void retranslate(Operation const* ops, std::size_t size, std::string& out) const {
+			UNUSED_SUPPRESSOR(ops);
+			UNUSED_SUPPRESSOR(size);
+			UNUSED_SUPPRESSOR(out);
+		}
+	};
+
+	/// @brief Printer by the static table of texts of operations
+	///
+	///
+	class TablePrinter : public IPrinter {
+		typedef TablePrinter self;
+	public:
+		/// @brief
+		///
+		///
+		explicit TablePrinter(std::string const* raw_table) : table(raw_table) {
+		}
+
+		/// @brief Destructor of class
+		///
+		///
+		virtual ~TablePrinter(void) noexcept {}
+
+		///
+		///
+		///
+		virtual std::string print(Operation op) const {
+			return this->table[op];
+		}
+
+		///
+		///
+		///
+		virtual void retranslate(Operation const* ops, std::size_t size, std::string& out) const {
+			std::string const* const t = this->table;
+
+			std::for_each(ops, ops + size, [t, &out](Operation op)->void {
+					out.append(t[op]);
+				});
+		}
+	private:
+		std::string const* table; // RU: Индекс - операция, OP_COUNT элементов
+	};
+
+	/// @brief
+	///
+	///
+	class SimplePrinter : public TablePrinter {
+		typedef SimplePrinter self;
+		typedef TablePrinter parent;
+	public:
+		/// @brief
+		///
+		///
+		SimplePrinter(void) : parent(self::TABLE) {
+		}
+
+		/// @brief Destructor of class
+		///
+		///
+		virtual ~SimplePrinter(void) noexcept {}
+	protected:
+		explicit SimplePrinter(std::string const* raw_table) : parent(raw_table) {
+		}
+	private:
+		static std::string const TABLE[OP_COUNT];
+	};
+
+	// RU: Внутренние коды операций (значения перечисления Operation)
+	std::string const SimplePrinter::TABLE[OP_COUNT] = {
+		"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "10"
+	};
+
+	/// @brief
+	///
+	///
+	class SimpleSpacePrinter : public SimplePrinter {
+		typedef SimpleSpacePrinter self;
+		typedef SimplePrinter parent;
+	public:
+		/// @brief
+		///
+		///
+		SimpleSpacePrinter(void) : parent(self::TABLE) {
+		}
+
+		/// @brief Destructor of class
+		///
+		///
+		virtual ~SimpleSpacePrinter(void) noexcept {}
+	private:
+		static std::string const TABLE[OP_COUNT];
+	};
+
+	std::string const SimpleSpacePrinter::TABLE[OP_COUNT] = {
+		"0 ", "1 ", "2 ", "3 ", "4 ", "5 ", "6 ", "7 ", "8 ", "9 ", "10 "
+	};
+
+	/// @brief
+	///
+	///
+	class ClassicalBrainfuckPrinter : public TablePrinter {
+		typedef ClassicalBrainfuckPrinter self;
+		typedef TablePrinter parent;
+	public:
+		/// @brief
+		///
+		///
+		ClassicalBrainfuckPrinter(void) : parent(self::TABLE) {
+		}
+
+		/// @brief Destructor of class
+		///
+		///
+		virtual ~ClassicalBrainfuckPrinter(void) noexcept {}
+	private:
+		static std::string const TABLE[OP_COUNT];
+	};
+
+	std::string const ClassicalBrainfuckPrinter::TABLE[OP_COUNT] = {
+		"",  // OP_UNKNOWN
+		"+", // OP_INC_CELL
+		"-", // OP_DEC_CELL
+		">", // OP_NEXT_CELL
+		"<", // OP_PREV_CELL
+		",", // OP_READ
+		".", // OP_WRITE
+		"[", // OP_BEGIN_LOOP
+		"]", // OP_END_LOOP
+		"",  // OP_ROTATE_CLOCKWISE
+		""   // OP_ROTATE_COUNTER_CLOCKWISE
+	};
+
+	/// @brief
+	///
+	/// 
+	class GraphicIteratorMachine final : public IIteratorMachine {
+		typedef GraphicIteratorMachine self;
+	
+		typedef std::map<boost::uint32_t, Operation> translator_map;
+	public:
+		/// @brief
+		///
+		///
+		GraphicIteratorMachine(std::string const& filename, boost::uint32_t raw_cell_size) :
+			filename(filename),
+			graphic_cell_size(raw_cell_size),
+			cur_pos(0),
+			n(0),
+			loaded(false),
+			cols(0),
+			rows(0),
+			row_offset(0),
+			decoded(0),
+			reused(0) {
+
+			this->trans[self::CODE_INC_CELL]                 = OP_INC_CELL;
+			this->trans[self::CODE_DEC_CELL]                 = OP_DEC_CELL;
+			this->trans[self::CODE_NEXT_CELL]                = OP_NEXT_CELL;
+			this->trans[self::CODE_PREV_CELL]                = OP_PREV_CELL;
+			this->trans[self::CODE_READ]                     = OP_READ;
+			this->trans[self::CODE_WRITE]                    = OP_WRITE;
+			this->trans[self::CODE_BEGIN_LOOP]               = OP_BEGIN_LOOP;
+			this->trans[self::CODE_END_LOOP]                 = OP_END_LOOP;
+			this->trans[self::CODE_ROTATE_CLOCKWISE]         = OP_ROTATE_CLOCKWISE;
+			this->trans[self::CODE_ROTATE_COUNTER_CLOCKWISE] = OP_ROTATE_COUNTER_CLOCKWISE;
+		}
+
+		/// @brief
+		///
+		///
+		GraphicIteratorMachine(std::string const& filename) : GraphicIteratorMachine(filename, 20) {}
+
+		/// @brief The image is in memory already (BGR, as cv::imread gives it); no file is read
+		///
+		///
+		GraphicIteratorMachine(cv::Mat const& image, boost::uint32_t raw_cell_size) :
+			GraphicIteratorMachine(std::string(), raw_cell_size) {
+			this->gp = image;
+		}
+
+		/// @brief
+		///
+		///
+		virtual ~GraphicIteratorMachine(void) noexcept {}
+	
+		/// @brief
+		///
+		///
+		virtual void init(void) {
+			// RU: Изображение читается при первой инициализации, а не в конструкторе: движку,
+			//     взявшему программу из кэша, само изображение не нужно.
+			if(!this->loaded) {
+				if(!this->filename.empty()) {
+					tracing::Scope scope("load image");
+
+					this->gp = cv::imread(this->filename, 1);
+				}
+				{
+					tracing::Scope scope("decode");
+
+					this->gp_size = this->gp.size();
+					this->decode();
+					this->trace(0);
+					this->n = static_cast<boost::uint32_t>(this->ops.size());
+				}
+				this->loaded = true;
+			}
+
+			this->cur_pos = 0;
+		}
+	
+		/// @brief
+		///
+		///
+		virtual boost::uint32_t get_size(void) const {
+			return this->n;
+		}
+
+		/// @brief
+		///
+		///
+		virtual boost::uint32_t get_cur_pos(void) const {
+			return this->cur_pos;
+		}
+	
+		/// @brief
+		///
+		///
+		virtual void set_cur_pos(boost::uint32_t pos) {
+			this->cur_pos = pos;
+		}
+	
+		/// @brief
+		///
+		///
+		virtual Operation get_next(void) {
+			return this->ops[this->cur_pos++];
+		}
+
+		/// @brief
+		///
+		///
+		virtual boost::uint32_t read(Operation* dst, boost::uint32_t size) {
+			boost::uint32_t const count = std::min(size, this->n - std::min(this->cur_pos, this->n));
+
+			std::copy(this->ops.begin() + this->cur_pos, this->ops.begin() + this->cur_pos + count, dst);
+			this->cur_pos += count;
+
+			return count;
+		}
+
+		/// @brief
+		///
+		///
+		virtual bool is_done(void) const {
+			return this->cur_pos >= this->n;
+		}
+
+		/// @brief Hash of the image file and the cell size (zero - file can't be read)
+		///
+		/// @note The image from memory is hashed by its pixels.
+		virtual boost::uint64_t get_hash(void) const {
+			std::string data;
+
+			if(this->filename.empty()) {
+				boost::uint64_t hash = utils::fnv1a(&this->graphic_cell_size, sizeof(this->graphic_cell_size));
+
+				for(int y = 0; y < this->gp.rows; y++) {
+					hash = utils::fnv1a(this->gp.ptr<uchar>(y), static_cast<std::size_t>(this->gp.cols) * 3, hash);
+				}
+
+				return (this->gp.empty()) ? 0 : hash;
+			}
+
+			if(!utils::read_file(this->filename, data)) {
+				return 0;
+			}
+
+			return utils::fnv1a(&this->graphic_cell_size, sizeof(this->graphic_cell_size),
+								utils::fnv1a(data.data(), data.size()));
+		}
+
+		/// @brief
+		///
+		///
+		virtual GridPosition get_position(boost::uint32_t pos) const {
+			return this->path.at(pos);
+		}
+
+		/// @brief Read the image file again; only bands with changed pixels are decoded
+		///
+		/// @note A band is a row of cells, it is hashed by the row of pixels the colors are
+		///       taken from. The path is kept up to the first step whose way (from the step
+		///       before, over filler) passes a changed cell and is walked again from there.
+		///       The image from memory is never changed.
+		virtual bool reload(void) {
+			if(this->filename.empty()) {
+				return false;
+			}
+
+			if(!this->loaded) {
+				this->init();
+
+				return true;
+			}
+
+			cv::Mat image;
+			{
+				tracing::Scope scope("load image");
+
+				image = cv::imread(this->filename, 1);
+			}
+
+			tracing::Scope scope("decode");
+
+			boost::int32_t const cols = this->cols;
+			boost::int32_t const rows = this->rows;
+
+			this->gp = image;
+			this->gp_size = image.size();
+			this->cur_pos = 0;
+			// RU: На время обхода машина считается незагруженной: если путь зациклился,
+			//     следующая перезагрузка начнётся с нуля
+			this->loaded = false;
+
+			this->reused = 0;
+			this->measure();
+			if(cols != this->cols || rows != this->rows) {
+				this->decode();
+				this->trace(0);
+			}
+			else {
+				std::vector<bool> dirty(this->grid.size(), false);
+				bool changed = false;
+
+				this->decoded = 0;
+				for(boost::int32_t y = 0; y < this->rows; y++) {
+					boost::uint64_t const hash = this->hash_band(y);
+
+					if(hash != this->bands[y]) {
+						this->bands[y] = hash;
+						changed = this->decode_band(y, dirty) || changed;
+						this->decoded++;
+					}
+				}
+
+				std::size_t from = this->path.size() + 1;
+
+				if(changed) {
+					this->link();
+				}
+
+				for(std::size_t i = 0; changed && i <= this->path.size(); i++) {
+					if(this->is_dirty_way(dirty, i)) {
+						from = i;
+						break;
+					}
+				}
+
+				if(from > this->path.size()) {
+					this->reused = this->path.size();
+					this->loaded = true;
+
+					return false;
+				}
+
+				this->trace(from);
+				this->reused = from;
+			}
+
+			this->n = static_cast<boost::uint32_t>(this->ops.size());
+			this->loaded = true;
+
+			return true;
+		}
+
+		/// @brief Bands (rows of cells) decoded by the last reload and all bands
+		///
+		///
+		std::pair<boost::uint32_t, boost::uint32_t> get_decoded(void) const {
+			return std::make_pair(this->decoded, static_cast<boost::uint32_t>(this->rows));
+		}
+
+		/// @brief Steps of the path kept by the last reload
+		///
+		///
+		std::size_t get_reused(void) const {
+			return this->reused;
+		}
+
+		/// @brief Code of color of the operation (zero - for unknown operation)
+		///
+		///
+		static boost::uint32_t op_to_code(Operation op) {
+			switch(op) {
+			case OP_INC_CELL:                 return self::CODE_INC_CELL;
+			case OP_DEC_CELL:                 return self::CODE_DEC_CELL;
+			case OP_NEXT_CELL:                return self::CODE_NEXT_CELL;
+			case OP_PREV_CELL:                return self::CODE_PREV_CELL;
+			case OP_READ:                     return self::CODE_READ;
+			case OP_WRITE:                    return self::CODE_WRITE;
+			case OP_BEGIN_LOOP:               return self::CODE_BEGIN_LOOP;
+			case OP_END_LOOP:                 return self::CODE_END_LOOP;
+			case OP_ROTATE_CLOCKWISE:         return self::CODE_ROTATE_CLOCKWISE;
+			case OP_ROTATE_COUNTER_CLOCKWISE: return self::CODE_ROTATE_COUNTER_CLOCKWISE;
+			case OP_UNKNOWN:
+			default:
+				return 0x000000;
+			}
+		}
+
+		/// @brief Reverse of pack
+		///
+		///
+		static cv::Vec3b unpack(boost::uint32_t code) {
+			cv::Vec3b res;
+
+			res[self::CH_NUM_RED]   = static_cast<uchar>((code & self::RED)   >> 0);
+			res[self::CH_NUM_GREEN] = static_cast<uchar>((code & self::GREEN) >> 8);
+			res[self::CH_NUM_BLUE]  = static_cast<uchar>((code & self::BLUE)  >> 16);
+
+			return res;
+		}
+	protected:
+		/// @brief Size of the grid of cells of the image
+		///
+		///
+		void measure(void) {
+			boost::int32_t const cell_size = static_cast<boost::int32_t>(this->graphic_cell_size);
+
+			this->cols = this->gp_size.width / cell_size;
+			// RU: Полоса ниже размера ячейки считается одной строкой ячеек (как и раньше)
+			this->rows = std::max(this->gp_size.height / cell_size, std::min(this->gp_size.height, 1));
+			// RU: Цвет берётся из второй строки пикселей ячейки, если она есть
+			this->row_offset = (std::min(cell_size, this->gp_size.height) > 1) ? 1 : 0;
+		}
+
+		/// @brief Decode all cells of the image into the grid of operations
+		///
+		///
+		void decode(void) {
+			std::vector<bool> dirty;
+
+			this->measure();
+			this->grid.assign(static_cast<std::size_t>(this->cols) * this->rows, OP_UNKNOWN);
+			this->bands.assign(this->rows, 0);
+			dirty.assign(this->grid.size(), false);
+
+			for(boost::int32_t y = 0; y < this->rows; y++) {
+				this->bands[y] = this->hash_band(y);
+				this->decode_band(y, dirty);
+			}
+
+			this->decoded = static_cast<boost::uint32_t>(this->rows);
+			this->link();
+		}
+
+		/// @brief Link every cell in every direction to the next cell with an operation
+		///
+		/// @note Cells of other colors (OP_UNKNOWN) are NOPs: the path jumps over a run of
+		///       them by one link, so filler of the image costs nothing. Links are built
+		///       from the grid only (no pixels), all at once, and dropped by trace.
+		void link(void) {
+			std::size_t const cols = static_cast<std::size_t>(this->cols);
+			std::size_t const rows = static_cast<std::size_t>(this->rows);
+
+			this->links.assign(this->grid.size() * 4, self::NO_LINK);
+
+			for(std::size_t y = 0; y < rows; y++) {
+				boost::uint32_t east = self::NO_LINK;
+				boost::uint32_t west = self::NO_LINK;
+
+				for(std::size_t k = 0; k < cols; k++) {
+					std::size_t const e = y * cols + (cols - 1 - k);
+					std::size_t const w = y * cols + k;
+
+					this->links[e * 4 + self::DIR_EAST] = east;
+					this->links[w * 4 + self::DIR_WEST] = west;
+					east = (this->grid[e] != OP_UNKNOWN) ? static_cast<boost::uint32_t>(e) : east;
+					west = (this->grid[w] != OP_UNKNOWN) ? static_cast<boost::uint32_t>(w) : west;
+				}
+			}
+
+			for(std::size_t x = 0; x < cols; x++) {
+				boost::uint32_t south = self::NO_LINK;
+				boost::uint32_t north = self::NO_LINK;
+
+				for(std::size_t k = 0; k < rows; k++) {
+					std::size_t const s = (rows - 1 - k) * cols + x;
+					std::size_t const n = k * cols + x;
+
+					this->links[s * 4 + self::DIR_SOUTH] = south;
+					this->links[n * 4 + self::DIR_NORTH] = north;
+					south = (this->grid[s] != OP_UNKNOWN) ? static_cast<boost::uint32_t>(s) : south;
+					north = (this->grid[n] != OP_UNKNOWN) ? static_cast<boost::uint32_t>(n) : north;
+				}
+			}
+		}
+
+		/// @brief Hash of the row of pixels the colors of the band are taken from
+		///
+		///
+		boost::uint64_t hash_band(boost::int32_t y) const {
+			boost::int32_t const row = y * static_cast<boost::int32_t>(this->graphic_cell_size) + this->row_offset;
+
+			return utils::fnv1a(this->gp.ptr<uchar>(row), static_cast<std::size_t>(this->gp.cols) * 3);
+		}
+
+		/// @brief Decode the band of cells (true - an operation is changed, its cell is marked)
+		///
+		///
+		bool decode_band(boost::int32_t y, std::vector<bool>& dirty) {
+			boost::int32_t const cell_size = static_cast<boost::int32_t>(this->graphic_cell_size);
+			bool changed = false;
+
+			for(boost::int32_t x = 0; x < this->cols; x++) {
+				cv::Vec3b const& code = this->gp.at<cv::Vec3b>(y * cell_size + this->row_offset, x * cell_size);
+				Operation const op = this->code_to_op(this->pack(code));
+				std::size_t const i = static_cast<std::size_t>(y) * this->cols + x;
+
+				if(this->grid[i] != op) {
+					this->grid[i] = op;
+					dirty[i] = true;
+					changed = true;
+				}
+			}
+
+			return changed;
+		}
+
+		/// @brief Index of the cell in the grid
+		///
+		///
+		std::size_t cell(GridPosition const& p) const {
+			return static_cast<std::size_t>(p.y) * this->cols + p.x;
+		}
+
+		/// @brief Walk the path of the program through the grid of cells from the step
+		///
+		/// @note The path starts in the top left cell and goes right; rotations turn it,
+		///       the program ends when the path leaves the image. The path is decoded once
+		///       into the flat list of operations (rotations stay there as NOPs, filler is
+		///       not there at all, see link), so the machines see a linear program and
+		///       positions are indexes in this list. Steps before from are kept (see reload).
+		void trace(std::size_t from) {
+			std::vector<bool> visited(this->grid.size() * 4, false);
+			boost::uint32_t next = (this->grid.empty()) ? self::NO_LINK : 0;
+			boost::uint32_t dir = self::DIR_EAST;
+
+			for(std::size_t i = 0; i < from; i++) {
+				visited[this->cell(this->path[i]) * 4 + this->dirs[i]] = true;
+			}
+			// RU: Продолжение - от предыдущего шага: ячейки между шагами могли измениться
+			if(from) {
+				dir = self::turn(this->dirs[from - 1], this->ops[from - 1]);
+				next = this->links[this->cell(this->path[from - 1]) * 4 + dir];
+			}
+			else if(next != self::NO_LINK && this->grid[next] == OP_UNKNOWN) {
+				next = this->links[next * 4 + dir];
+			}
+
+			this->ops.resize(from);
+			this->path.resize(from);
+			this->dirs.resize(from);
+
+			while(next != self::NO_LINK) {
+				std::size_t const state = static_cast<std::size_t>(next) * 4 + dir;
+
+				if(visited[state]) {
+					throw LoopedPathGraphicMachineException();
+				}
+				visited[state] = true;
+
+				Operation const op = this->grid[next];
+				GridPosition const p = {next % static_cast<boost::uint32_t>(this->cols),
+										next / static_cast<boost::uint32_t>(this->cols)};
+
+				this->dirs.push_back(static_cast<boost::uint8_t>(dir));
+				this->ops.push_back(op);
+				this->path.push_back(p);
+
+				dir = self::turn(dir, op);
+				next = this->links[static_cast<std::size_t>(next) * 4 + dir];
+			}
+
+			// RU: Ссылки нужны только для обхода; при перезагрузке они строятся заново
+			std::vector<boost::uint32_t>().swap(this->links);
+		}
+
+		/// @brief Direction of the path out of the cell with the operation
+		///
+		///
+		static boost::uint32_t turn(boost::uint32_t dir, Operation op) {
+			if(op == OP_ROTATE_CLOCKWISE) {
+				return (dir + 1) & 3;
+			}
+			else if(op == OP_ROTATE_COUNTER_CLOCKWISE) {
+				return (dir + 3) & 3;
+			}
+
+			return dir;
+		}
+
+		/// @brief Is a cell passed on the way to the step changed? (the last step + 1 - the way
+		///        out of the image after the last step)
+		///
+		/// @note The way goes over filler, so a new operation there changes the path too.
+		bool is_dirty_way(std::vector<bool> const& dirty, std::size_t step) const {
+			static boost::int32_t const dx[4] = {1, 0, -1, 0}; // RU: Восток, юг, запад, север
+			static boost::int32_t const dy[4] = {0, 1, 0, -1};
+
+			std::size_t const to = (step < this->path.size()) ? this->cell(this->path[step]) : this->grid.size();
+			boost::int32_t x = 0;
+			boost::int32_t y = 0;
+			boost::uint32_t dir = self::DIR_EAST;
+
+			if(step) {
+				dir = self::turn(this->dirs[step - 1], this->ops[step - 1]);
+				x = static_cast<boost::int32_t>(this->path[step - 1].x) + dx[dir];
+				y = static_cast<boost::int32_t>(this->path[step - 1].y) + dy[dir];
+			}
+
+			for(; x >= 0 && y >= 0 && x < this->cols && y < this->rows; x += dx[dir], y += dy[dir]) {
+				std::size_t const i = static_cast<std::size_t>(y) * this->cols + x;
+
+				if(dirty[i]) {
+					return true;
+				}
+				if(i == to) {
+					break;
+				}
+			}
+
+			return false;
+		}
+
+		virtual Operation code_to_op(boost::uint32_t code) const {
+			translator_map::const_iterator i_end = this->trans.end();
+			translator_map::const_iterator i = i_end;
+
+			// RU: Пояснение. Тут не используется метод at или [] по причине генерации исключения,
+			//     если такой элемент не будет найден. Генерация исключения - довольно медленный
+			//     процесс. Чтобы гарантировать более-менее одинаковое время поиска операции
+			//     используется алгоритм. Возможно, вариант с исключением более приемлем в некоторых
+			//     случаях, т.к. данные исключения могут возникать при нормальной работе крайне редко.
+			//     Однако тут всё равно используется алгоритм.
+			i = std::find_if(this->trans.begin(), this->trans.end(), [code](auto x)->bool{
+					return (x.first == code);
+				});
+		
+			return (i != i_end) ? i->second : OP_UNKNOWN;
+		}
+	
+		virtual boost::uint32_t pack(cv::Vec3b const value) const {
+			boost::uint32_t res = 0x00000000;
+
+			res =  (value[self::CH_NUM_RED]   << 0);
+			res += (value[self::CH_NUM_GREEN] << 8);
+			res += (value[self::CH_NUM_BLUE]  << 16);
+			
+			return res;
+		}
+	private:
+		std::string const filename;
+		boost::uint32_t graphic_cell_size;
+		boost::uint32_t cur_pos;
+		boost::uint32_t n;
+		cv::Mat gp;
+		cv::Size gp_size;
+		bool loaded;
+		self::translator_map trans;
+		std::vector<Operation> ops;
+		std::vector<GridPosition> path;
+		std::vector<boost::uint8_t> dirs;       // Direction of the path into the cell of the step
+		std::vector<Operation> grid;            // Decoded cells of the image
+		std::vector<boost::uint32_t> links;     // Next cell with an operation by cell and direction
+		std::vector<boost::uint64_t> bands;     // Hashes of the rows of cells
+		boost::int32_t cols;
+		boost::int32_t rows;
+		boost::int32_t row_offset;
+		boost::uint32_t decoded;
+		std::size_t reused;
+	
+		static boost::uint32_t const RED;
+		static boost::uint32_t const GREEN;
+		static boost::uint32_t const BLUE;
+	
+		static boost::uint8_t const CH_NUM_RED;
+		static boost::uint8_t const CH_NUM_GREEN;
+		static boost::uint8_t const CH_NUM_BLUE;
+
+		static boost::uint32_t const CODE_INC_CELL;
+		static boost::uint32_t const CODE_DEC_CELL;
+		static boost::uint32_t const CODE_NEXT_CELL;
+		static boost::uint32_t const CODE_PREV_CELL;
+		static boost::uint32_t const CODE_READ;
+		static boost::uint32_t const CODE_WRITE;
+		static boost::uint32_t const CODE_BEGIN_LOOP;
+		static boost::uint32_t const CODE_END_LOOP;
+		static boost::uint32_t const CODE_ROTATE_CLOCKWISE;
+		static boost::uint32_t const CODE_ROTATE_COUNTER_CLOCKWISE;
+
+		static boost::uint32_t const NO_LINK;   // The path leaves the image
+
+		static boost::uint32_t const DIR_EAST = 0;
+		static boost::uint32_t const DIR_SOUTH = 1;
+		static boost::uint32_t const DIR_WEST = 2;
+		static boost::uint32_t const DIR_NORTH = 3;
+	};
+
+	boost::uint32_t const GraphicIteratorMachine::NO_LINK = std::numeric_limits<boost::uint32_t>::max();
+
+	boost::uint32_t const GraphicIteratorMachine::RED   = 0x000000FF;
+	boost::uint32_t const GraphicIteratorMachine::GREEN = 0x0000FF00;
+	boost::uint32_t const GraphicIteratorMachine::BLUE  = 0x00FF0000;
+
+	boost::uint8_t const GraphicIteratorMachine::CH_NUM_RED   = 2;
+	boost::uint8_t const GraphicIteratorMachine::CH_NUM_GREEN = 1;
+	boost::uint8_t const GraphicIteratorMachine::CH_NUM_BLUE  = 0;
+
+	boost::uint32_t const GraphicIteratorMachine::CODE_INC_CELL                 = 0x00FF00;
+	boost::uint32_t const GraphicIteratorMachine::CODE_DEC_CELL                 = 0x008000;
+	boost::uint32_t const GraphicIteratorMachine::CODE_NEXT_CELL                = 0xFF0000;
+	boost::uint32_t const GraphicIteratorMachine::CODE_PREV_CELL                = 0x800000;
+	boost::uint32_t const GraphicIteratorMachine::CODE_READ                     = 0x000080;
+	boost::uint32_t const GraphicIteratorMachine::CODE_WRITE                    = 0x0000FF;
+	boost::uint32_t const GraphicIteratorMachine::CODE_BEGIN_LOOP               = 0xFFFF00;
+	boost::uint32_t const GraphicIteratorMachine::CODE_END_LOOP                 = 0x808000;
+	boost::uint32_t const GraphicIteratorMachine::CODE_ROTATE_CLOCKWISE         = 0x008080;
+	boost::uint32_t const GraphicIteratorMachine::CODE_ROTATE_COUNTER_CLOCKWISE = 0x00FFFF;
+
+	/// @brief Encoder of Brainfuck source to Brainloller image
+	///
+	/// @note The program is folded into near-square snake: rows go right and left in turn,
+	///       rotations in the first and the last cells of rows turn the path down. After the
+	///       last command the path turns down and leaves the image.
+	class BrainlollerEncoder {
+		typedef BrainlollerEncoder self;
+	public:
+		/// @brief
+		///
+		///
+		explicit BrainlollerEncoder(boost::uint32_t raw_cell_size) :
+			graphic_cell_size(std::max<boost::uint32_t>(raw_cell_size, 1)) {
+		}
+
+		/// @brief
+		///
+		///
+		virtual ~BrainlollerEncoder(void) noexcept {}
+
+		/// @brief Commands of Brainfuck source (all other characters are comments)
+		///
+		///
+		static std::vector<Operation> parse(std::string const& source) {
+			std::vector<Operation> res;
+
+			res.reserve(source.size());
+			std::for_each(source.begin(), source.end(), [&res](char c)->void {
+					switch(c) {
+					case '+': res.push_back(OP_INC_CELL);   break;
+					case '-': res.push_back(OP_DEC_CELL);   break;
+					case '>': res.push_back(OP_NEXT_CELL);  break;
+					case '<': res.push_back(OP_PREV_CELL);  break;
+					case ',': res.push_back(OP_READ);       break;
+					case '.': res.push_back(OP_WRITE);      break;
+					case '[': res.push_back(OP_BEGIN_LOOP); break;
+					case ']': res.push_back(OP_END_LOOP);   break;
+					default:
+						break;
+					}
+				});
+
+			return res;
+		}
+
+		/// @brief Place the program into the grid of cells (row by row, codes of colors)
+		///
+		///
+		std::vector<boost::uint32_t> layout(std::vector<Operation> const& ops, boost::uint32_t& width, boost::uint32_t& height) const {
+			std::size_t const size = ops.size();
+
+			self::dimensions(size, width, height);
+
+			std::vector<boost::uint32_t> grid(static_cast<std::size_t>(width) * height, self::CODE_BACKGROUND);
+			boost::uint32_t const cw = GraphicIteratorMachine::op_to_code(OP_ROTATE_CLOCKWISE);
+			boost::uint32_t const ccw = GraphicIteratorMachine::op_to_code(OP_ROTATE_COUNTER_CLOCKWISE);
+			std::size_t k = 0;
+
+			for(boost::uint32_t y = 0; y < height; y++) {
+				boost::uint32_t* row = &grid[static_cast<std::size_t>(y) * width];
+				bool const east = !(y & 1);
+				// RU: Клетки строки без поворотов по краям (в первой строке нет входа слева)
+				boost::int32_t const first = (east) ? ((y) ? 1 : 0) : static_cast<boost::int32_t>(width) - 2;
+				boost::int32_t const last = (east) ? static_cast<boost::int32_t>(width) - 2 : 1;
+				boost::int32_t const step = (east) ? 1 : -1;
+				boost::int32_t x = first;
+
+				if(y) {
+					row[(east) ? 0 : width - 1] = (east) ? ccw : cw;
+				}
+
+				for(; (east) ? x <= last : x >= last; x += step) {
+					if(k == size) {
+						break;
+					}
+					row[x] = GraphicIteratorMachine::op_to_code(ops[k++]);
+				}
+
+				// RU: Поворот вниз: к следующей строке или за пределы изображения
+				row[x] = (east) ? cw : ccw;
+
+				if(k == size) {
+					break;
+				}
+			}
+
+			return grid;
+		}
+
+		/// @brief Draw the image; every row of cells is drawn once into the buffer of one
+		///        line of pixels and copied graphic_cell_size times
+		///
+		///
+		cv::Mat encode(std::vector<Operation> const& ops) const {
+			boost::uint32_t width = 0;
+			boost::uint32_t height = 0;
+			std::vector<boost::uint32_t> const grid = this->layout(ops, width, height);
+			boost::uint32_t const cs = this->graphic_cell_size;
+
+			cv::Mat image(height * cs, width * cs, CV_8UC3, cv::Scalar(0, 0, 0));
+			std::vector<cv::Vec3b> line(static_cast<std::size_t>(width) * cs);
+
+			for(boost::uint32_t y = 0; y < height; y++) {
+				for(boost::uint32_t x = 0; x < width; x++) {
+					std::fill_n(line.begin() + static_cast<std::size_t>(x) * cs, cs,
+								GraphicIteratorMachine::unpack(grid[static_cast<std::size_t>(y) * width + x]));
+				}
+
+				for(boost::uint32_t r = 0; r < cs; r++) {
+					std::copy(line.begin(), line.end(), image.ptr<cv::Vec3b>(y * cs + r));
+				}
+			}
+
+			return image;
+		}
+
+		/// @brief Encode the Brainfuck source file into the image file
+		///
+		///
+		void encode(std::string const& source_filename, std::string const& image_filename) const {
+			tracing::Scope scope("encode");
+			std::string source;
+
+			if(!utils::read_file(source_filename, source) ||
+			   !cv::imwrite(image_filename, this->encode(self::parse(source)))) {
+				throw EncoderGraphicMachineException();
+			}
+		}
+	private:
+		/// @brief The least width of the snake that isn't less than its height
+		///
+		/// @note The first row holds (width - 1) commands, all other rows hold (width - 2)
+		///       commands: one cell on each side is taken by the rotation.
+		static void dimensions(std::size_t size, boost::uint32_t& width, boost::uint32_t& height) {
+			for(width = 1;; width++) {
+				if(size < width) {
+					height = 1;
+				}
+				else if(width > 2) {
+					height = static_cast<boost::uint32_t>(1 + (size - (width - 1) + (width - 3)) / (width - 2));
+				}
+				else {
+					continue;
+				}
+
+				if(height <= width) {
+					break;
+				}
+			}
+		}
+
+		boost::uint32_t graphic_cell_size;
+
+		static boost::uint32_t const CODE_BACKGROUND;
+	};
+
+	boost::uint32_t const BrainlollerEncoder::CODE_BACKGROUND = 0x000000;
+
+	/// @brief Opcodes of the decoded program
+	///
+	/// @note All cell accesses are addressed by a constant offset from the current cell:
+	///       the pointer is moved once per straight-line block (IR_MOVE), not per '<' or '>'.
+	enum Opcode {
+		IR_ADD = 0,   // cells[num + offset] += value
+		IR_MOVE,      // num += offset
+		IR_READ,      // cells[num + offset] = input
+		IR_WRITE,     // output(cells[num + offset])
+		IR_LOOP,      // if(!cells[num + offset]) goto jump
+		IR_END,       // if(cells[num + offset]) goto jump (back-edge)
+		IR_FAIL,      // throw the exception of operation 'value'
+		IR_HALT,      // end of program
+		IR_CLEAR,     // cells[num + offset] = 0 by (cells[num + offset] * value) & 0xFF iterations
+		IR_CHECK,     // cells[num + offset] .. cells[num + value] are in the tape (see BoundsChecker)
+		IR_VADD,      // cells[num + offset + k] += vectors[value].lanes[k]
+		IR_MUL,       // IR_CLEAR which adds vectors[value] on every iteration (see VectorOptimizer)
+		IR_SOLVE,     // the rest of iterations of the loop of the next IR_END at once (see LinearLoop)
+		IR_NATIVE     // run native code 'value' of the loop (TieredGraphicMachine only, never in Program)
+	};
+
+	/// @brief Instruction of the decoded program
+	///
+	/// @note 'count' is the number of source instructions of the block which ends at this
+	///       instruction (IR_LOOP, IR_END, IR_HALT, IR_CLEAR and IR_MUL): the instruction counter
+	///       is increased by blocks. IR_CLEAR is a whole loop "[-]" (see DataflowOptimizer),
+	///       its 'jump' is the number of source instructions of one iteration (IR_MUL too).
+	///       The back-edge of IR_END goes behind IR_LOOP: '[' is counted once per entry of
+	///       the loop, ']' once per iteration (the same in GraphicMachine::execute).
+	struct Instruction {
+		Opcode opcode;
+		boost::int32_t offset;
+		boost::int32_t value;
+		boost::uint32_t jump;
+		boost::uint32_t pos;   // Position of the source instruction (in the iterator)
+		boost::uint32_t count;
+	};
+
+	/// @brief Cells of the window of IR_VADD, IR_MUL and IR_SOLVE (one SSE register)
+	///
+	///
+	boost::uint32_t const VECTOR_LANES = 16;
+
+	/// @brief Constant additions to a window of cells (IR_VADD, IR_MUL and IR_SOLVE)
+	///
+	/// @note IR_MUL adds the lanes k times, where k = (counter * iterations) & 0xFF is the
+	///       number of iterations of its loop (as for IR_CLEAR).
+	struct VectorAdd {
+		boost::int32_t offset;              // First cell of the window (from the base cell)
+		boost::uint32_t size;               // Cells of the window (up to VECTOR_LANES)
+		boost::uint32_t iterations;         // IR_MUL only
+		boost::uint8_t lanes[VECTOR_LANES]; // Addends of the cells (zero out of the window)
+	};
+
+	/// @brief Add the lanes of the vector times the factor to the cells from the first one
+	///
+	/// @note One load-add-store when all VECTOR_LANES cells are in the tape of the size,
+	///       cell by cell otherwise (at the end of the tape or without SSE2).
+	inline void add_vector(boost::uint8_t* cells, std::size_t size, std::size_t first,
+						   VectorAdd const& v, boost::uint8_t factor) {
+#if defined(__SSE2__)
+		if(first < size && size - first >= VECTOR_LANES) {
+			__m128i* const p = reinterpret_cast<__m128i*>(cells + first);
+			__m128i x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(v.lanes));
+
+			if(factor != 1) {
+				// RU: В SSE2 нет умножения байтов: умножаем слова и берём младшие байты
+				__m128i const zero = _mm_setzero_si128();
+				__m128i const k = _mm_set1_epi16(factor);
+				__m128i const mask = _mm_set1_epi16(0x00FF);
+				__m128i const lo = _mm_and_si128(_mm_mullo_epi16(_mm_unpacklo_epi8(x, zero), k), mask);
+				__m128i const hi = _mm_and_si128(_mm_mullo_epi16(_mm_unpackhi_epi8(x, zero), k), mask);
+
+				x = _mm_packus_epi16(lo, hi);
+			}
+
+			_mm_storeu_si128(p, _mm_add_epi8(_mm_loadu_si128(p), x));
+			return;
+		}
+#endif // defined(__SSE2__)
+		for(boost::uint32_t k = 0; k < v.size; k++) {
+			cells[first + k] += static_cast<boost::uint8_t>(v.lanes[k] * factor);
+		}
+	}
+
+	/// @brief Closed form of a loop whose iterations add constants to fixed cells (IR_SOLVE)
+	///
+	/// @note The counter steps by u * 2^shift (u is odd) per iteration: the rest of the
+	///       iterations k solves counter + k * step = 0 (mod 256), it is defined only when
+	///       the counter is a multiple of 2^shift (see LinearLoopSolver).
+	struct LinearLoop {
+		boost::uint32_t shift;      // Trailing zero bits of the step
+		boost::uint32_t iterations; // -1 / u (mod 2^(8 - shift))
+		boost::uint64_t executed;   // Source instructions of one iteration
+		boost::uint64_t back_edges; // Back-edges of one iteration (the inner loops and its own)
+		boost::uint32_t first;      // Windows of additions of one iteration (Program::vectors)
+		boost::uint32_t vectors;
+
+		/// @brief Iterations after the current one (zero - the counter is zero or undefined)
+		///
+		///
+		boost::uint32_t rest(boost::uint8_t counter) const {
+			if(counter & ((1u << this->shift) - 1)) {
+				return 0;
+			}
+
+			return ((counter >> this->shift) * this->iterations) & (0xFFu >> this->shift);
+		}
+	};
+
+	/// @brief Superinstructions: fused handlers of the threaded engine for frequent sequences
+	///
+	///
+	enum Superinstruction {
+		SI_ADD_ADD = 0,
+		SI_ADD_MOVE,
+		SI_ADD_WRITE,
+		SI_ADD_END,
+		SI_MOVE_LOOP,
+		SI_MOVE_END,
+		SI_ADD_ADD_ADD,
+		SI_ADD_ADD_END,
+		SI_COUNT
+	};
+
+	/// @brief
+	///
+	///
+	struct SuperinstructionPattern {
+		char const* name;
+		boost::uint32_t size;
+		Opcode ops[3];
+	};
+
+	SuperinstructionPattern const SUPERINSTRUCTIONS[SI_COUNT] = {
+		{"ADD_ADD",     2, {IR_ADD,  IR_ADD,   IR_HALT}},
+		{"ADD_MOVE",    2, {IR_ADD,  IR_MOVE,  IR_HALT}},
+		{"ADD_WRITE",   2, {IR_ADD,  IR_WRITE, IR_HALT}},
+		{"ADD_END",     2, {IR_ADD,  IR_END,   IR_HALT}},
+		{"MOVE_LOOP",   2, {IR_MOVE, IR_LOOP,  IR_HALT}},
+		{"MOVE_END",    2, {IR_MOVE, IR_END,   IR_HALT}},
+		{"ADD_ADD_ADD", 3, {IR_ADD,  IR_ADD,   IR_ADD}},
+		{"ADD_ADD_END", 3, {IR_ADD,  IR_ADD,   IR_END}}
+	};
+
+	/// @brief State of the machine after the input-independent prefix of the program
+	///
+	/// @note See PrefixEvaluator. The run starts from this state instead of the beginning.
+	struct ProgramPrefix {
+		typedef std::vector<std::pair<boost::uint64_t, boost::uint8_t>> cells_t;
+
+		bool valid;
+		boost::uint32_t start;             // Instruction to continue from
+		boost::uint64_t num;               // Base cell of the instruction
+		boost::uint64_t executed;
+		boost::uint64_t back_edges;
+		boost::uint64_t ends;              // Back-edges of Program::stable_loops (see ShadowTrace)
+		cells_t cells;                     // Non-zero cells of the tape
+		std::vector<boost::uint8_t> output; // Values written by the prefix
+	};
+
+	/// @brief Decoded and optimized program: the input of all engines except the reference one
+	///
+	///
+	class Program {
+		typedef Program self;
+	public:
+		typedef std::vector<Instruction> code_t;
+
+		/// @brief
+		///
+		///
+		Program(void) : code(), size(0), eliminated(0), checked(false), vectors(), linear(), prefix(), superinstructions() {}
+
+		/// @brief
+		///
+		///
+		explicit Program(boost::uint32_t source_size) :
+			code(), size(source_size), eliminated(0), checked(false), vectors(), linear(), prefix(), superinstructions() {}
+
+		self::code_t code;          // Instructions (the last one is IR_HALT)
+		boost::uint32_t size;       // Number of source instructions
+		boost::uint32_t eliminated; // Instructions removed by DataflowOptimizer
+		bool checked;               // Range checks are inserted (see BoundsChecker)
+		std::vector<VectorAdd> vectors; // Constants of IR_VADD, IR_MUL and IR_SOLVE (see VectorOptimizer)
+		std::vector<LinearLoop> linear; // Loops of IR_SOLVE (see LinearLoopSolver)
+		ProgramPrefix prefix;
+		std::vector<boost::uint8_t> superinstructions; // Kinds to fuse (see Superinstruction)
+
+		/// @brief Write the program to file of cache
+		///
+		/// @note The key identifies the source image and the options of compiler.
+		bool save(std::string const& filename, boost::uint64_t key) const {
+			utils::BinaryWriter w;
+
+			w.put_bytes(self::MAGIC, sizeof(self::MAGIC));
+			w.put_u32(self::VERSION);
+			w.put_u64(key);
+			w.put_u32(this->size);
+			w.put_u32(this->eliminated);
+			w.put_u8(this->checked);
+
+			w.put_u32(static_cast<boost::uint32_t>(this->code.size()));
+			std::for_each(this->code.begin(), this->code.end(), [&w](Instruction const& x)->void {
+					w.put_u8(static_cast<boost::uint8_t>(x.opcode));
+					w.put_u32(static_cast<boost::uint32_t>(x.offset));
+					w.put_u32(static_cast<boost::uint32_t>(x.value));
+					w.put_u32(x.jump);
+					w.put_u32(x.pos);
+					w.put_u32(x.count);
+				});
+
+			w.put_u32(static_cast<boost::uint32_t>(this->vectors.size()));
+			std::for_each(this->vectors.begin(), this->vectors.end(), [&w](VectorAdd const& x)->void {
+					w.put_u32(static_cast<boost::uint32_t>(x.offset));
+					w.put_u32(x.size);
+					w.put_u32(x.iterations);
+					w.put_bytes(x.lanes, sizeof(x.lanes));
+				});
+
+			w.put_u32(static_cast<boost::uint32_t>(this->linear.size()));
+			std::for_each(this->linear.begin(), this->linear.end(), [&w](LinearLoop const& x)->void {
+					w.put_u32(x.shift);
+					w.put_u32(x.iterations);
+					w.put_u64(x.executed);
+					w.put_u64(x.back_edges);
+					w.put_u32(x.first);
+					w.put_u32(x.vectors);
+				});
+
+			w.put_u8(this->prefix.valid);
+			w.put_u32(this->prefix.start);
+			w.put_u64(this->prefix.num);
+			w.put_u64(this->prefix.executed);
+			w.put_u64(this->prefix.back_edges);
+			w.put_u64(this->prefix.ends);
+			w.put_u64(this->prefix.cells.size());
+			std::for_each(this->prefix.cells.begin(), this->prefix.cells.end(), [&w](auto const& x)->void {
+					w.put_u64(x.first);
+					w.put_u8(x.second);
+				});
+			w.put_u64(this->prefix.output.size());
+			w.put_bytes(this->prefix.output.data(), this->prefix.output.size());
+
+			w.put_u32(static_cast<boost::uint32_t>(this->superinstructions.size()));
+			w.put_bytes(this->superinstructions.data(), this->superinstructions.size());
+
+			return w.save(filename);
+		}
+
+		/// @brief Read the program from file of cache (false - no such program)
+		///
+		///
+		bool load(std::string const& filename, boost::uint64_t key) {
+			utils::BinaryReader r;
+			char magic[sizeof(self::MAGIC)];
+			self p;
+
+			if(!r.load(filename) ||
+			   !r.get_bytes(magic, sizeof(magic)) ||
+			   std::memcmp(magic, self::MAGIC, sizeof(magic)) ||
+			   r.get_u32() != self::VERSION ||
+			   r.get_u64() != key) {
+				return false;
+			}
+
+			p.size = r.get_u32();
+			p.eliminated = r.get_u32();
+			p.checked = r.get_u8();
+			for(boost::uint32_t i = 0, n = r.get_u32(); i < n && r.good(); i++) {
+				Instruction x;
+
+				x.opcode = static_cast<Opcode>(r.get_u8());
+				x.offset = static_cast<boost::int32_t>(r.get_u32());
+				x.value = static_cast<boost::int32_t>(r.get_u32());
+				x.jump = r.get_u32();
+				x.pos = r.get_u32();
+				x.count = r.get_u32();
+				p.code.push_back(x);
+			}
+			for(boost::uint32_t i = 0, n = r.get_u32(); i < n && r.good(); i++) {
+				VectorAdd x;
+
+				x.offset = static_cast<boost::int32_t>(r.get_u32());
+				x.size = std::min(r.get_u32(), VECTOR_LANES);
+				x.iterations = r.get_u32();
+				r.get_bytes(x.lanes, sizeof(x.lanes));
+				p.vectors.push_back(x);
+			}
+			for(boost::uint32_t i = 0, n = r.get_u32(); i < n && r.good(); i++) {
+				LinearLoop x;
+
+				x.shift = std::min(r.get_u32(), 7u);
+				x.iterations = r.get_u32();
+				x.executed = r.get_u64();
+				x.back_edges = r.get_u64();
+				x.first = r.get_u32();
+				x.vectors = r.get_u32();
+				p.linear.push_back(x);
+			}
+
+			p.prefix.valid = r.get_u8();
+			p.prefix.start = r.get_u32();
+			p.prefix.num = r.get_u64();
+			p.prefix.executed = r.get_u64();
+			p.prefix.back_edges = r.get_u64();
+			p.prefix.ends = r.get_u64();
+			for(boost::uint64_t i = 0, n = r.get_u64(); i < n && r.good(); i++) {
+				boost::uint64_t const index = r.get_u64();
+				p.prefix.cells.push_back(std::make_pair(index, r.get_u8()));
+			}
+			p.prefix.output.resize(std::min<boost::uint64_t>(r.get_u64(), std::numeric_limits<boost::uint32_t>::max()));
+			r.get_bytes(p.prefix.output.data(), p.prefix.output.size());
+
+			p.superinstructions.resize(std::min<boost::uint32_t>(r.get_u32(), SI_COUNT));
+			r.get_bytes(p.superinstructions.data(), p.superinstructions.size());
+
+			if(std::any_of(p.superinstructions.begin(), p.superinstructions.end(), [](boost::uint8_t x)->bool {
+						return x >= SI_COUNT;
+					})) {
+				return false;
+			}
+
+			if(std::any_of(p.code.begin(), p.code.end(), [&p](Instruction const& x)->bool {
+						return (x.opcode == IR_VADD || x.opcode == IR_MUL) &&
+							static_cast<boost::uint32_t>(x.value) >= p.vectors.size();
+					})) {
+				return false;
+			}
+
+			if(std::any_of(p.code.begin(), p.code.end(), [&p](Instruction const& x)->bool {
+						return x.opcode == IR_SOLVE && static_cast<boost::uint32_t>(x.value) >= p.linear.size();
+					}) ||
+			   std::any_of(p.linear.begin(), p.linear.end(), [&p](LinearLoop const& x)->bool {
+						return x.first > p.vectors.size() || p.vectors.size() - x.first < x.vectors;
+					})) {
+				return false;
+			}
+
+			if(!r.good() || p.code.empty() || p.code.back().opcode != IR_HALT) {
+				return false;
+			}
+
+			*this = p;
+			return true;
+		}
+
+		/// @brief Find the loop which starts at the source position
+		///
+		///
+		boost::uint32_t find_loop(boost::uint32_t pos) const {
+			for(boost::uint32_t i = 0; i < this->code.size(); i++) {
+				if((this->code[i].opcode == IR_LOOP || this->code[i].opcode == IR_CLEAR ||
+					this->code[i].opcode == IR_MUL) && this->code[i].pos == pos) {
+					return i;
+				}
+			}
+
+			return static_cast<boost::uint32_t>(this->code.size());
+		}
+
+		/// @brief Instructions which are targets of jumps
+		///
+		///
+		std::vector<bool> jump_targets(void) const {
+			std::vector<bool> targets(this->code.size() + 1, false);
+
+			std::for_each(this->code.begin(), this->code.end(), [&targets](Instruction const& x)->void {
+					if(x.opcode == IR_LOOP || x.opcode == IR_END) {
+						targets[x.jump] = true;
+					}
+				});
+			return targets;
+		}
+
+		/// @brief Source positions of all loops which enclose the instruction (outer first)
+		///
+		///
+		std::vector<boost::uint32_t> enclosing_loops(boost::uint32_t index) const {
+			std::vector<boost::uint32_t> loops;
+			boost::uint32_t depth = 0;
+
+			for(boost::uint32_t i = index; i-- > 0; ) {
+				if(this->code[i].opcode == IR_END) {
+					depth++;
+				}
+				else if(this->code[i].opcode == IR_LOOP) {
+					if(depth) {
+						depth--;
+					}
+					else {
+						loops.push_back(this->code[i].pos);
+					}
+				}
+			}
+
+			std::reverse(loops.begin(), loops.end());
+			return loops;
+		}
+
+		/// @brief Source positions of loops whose back-edges are the same as in the source
+		///
+		/// @note Loops of IR_SOLVE and all loops inside them skip back-edges, they are
+		///       excluded (see ShadowTrace).
+		std::vector<bool> stable_loops(void) const {
+			std::vector<bool> loops;
+			boost::uint32_t solved = 0; // End of the current loop of IR_SOLVE
+
+			for(boost::uint32_t i = 0; i < this->code.size(); i++) {
+				Instruction const& x = this->code[i];
+
+				if(x.opcode != IR_LOOP || i < solved) {
+					continue;
+				}
+
+				if(this->code[x.jump - 2].opcode == IR_SOLVE) {
+					solved = x.jump;
+					continue;
+				}
+
+				if(x.pos >= loops.size()) {
+					loops.resize(x.pos + 1, false);
+				}
+				loops[x.pos] = true;
+			}
+
+			return loops;
+		}
+	private:
+		static char const MAGIC[4];
+		static boost::uint32_t const VERSION;
+	};
+
+	char const Program::MAGIC[4] = {'B', 'L', 'P', 'G'};
+	boost::uint32_t const Program::VERSION = 9;
+
+	/// @brief Decoder of the iterator into the program and its optimizer
+	///
+	/// @note Straight-line code is scheduled at constant offsets from the base cell: additions
+	///       to the same cell are folded, and the pointer is moved once at the end of block.
+	///       A balanced loop (zero net movement, with all nested loops balanced) keeps the
+	///       pending movement as the base offset, so there are no pointer updates inside it.
+	class ProgramCompiler {
+		typedef ProgramCompiler self;
+
+		typedef std::map<boost::int32_t, boost::int32_t> pending_t;
+
+		struct open_loop {
+			boost::uint32_t index;   // Index of IR_LOOP
+			boost::int32_t delta;    // Base offset at the entry
+			bool balanced;
+		};
+	public:
+		/// @brief
+		///
+		/// @note Ordered accesses: all pending additions are written before every input and
+		///       output, so a failed access (see BoundsChecker) is after the same I/O as in
+		///       the reference engine.
+		explicit ProgramCompiler(bool raw_ordered = false) noexcept : ordered(raw_ordered) {}
+
+		/// @brief
+		///
+		///
+		virtual ~ProgramCompiler(void) noexcept {}
+
+		/// @brief Decode all instructions of the iterator and build the program
+		///
+		///
+		virtual Program compile(IIteratorMachine& im) const {
+			std::vector<Operation> ops;
+
+			im.init();
+			while(!im.is_done()) {
+				ops.push_back(im.get_next());
+			}
+			im.init();
+
+			return this->compile(ops);
+		}
+
+		/// @brief
+		///
+		///
+		virtual Program compile(std::vector<Operation> const& ops) const {
+			tracing::Scope scope("compile");
+			std::vector<bool> const balanced = self::find_balanced(ops);
+			Program p(static_cast<boost::uint32_t>(ops.size()));
+			std::vector<open_loop> loops;
+			pending_t pending;
+			boost::int32_t delta = 0;
+			boost::uint32_t block_begin = 0;
+
+			for(boost::uint32_t i = 0; i < ops.size(); i++) {
+				switch(ops[i]) {
+				case OP_INC_CELL:
+					pending[delta]++;
+					break;
+				case OP_DEC_CELL:
+					pending[delta]--;
+					break;
+				case OP_NEXT_CELL:
+					delta++;
+					break;
+				case OP_PREV_CELL:
+					delta--;
+					break;
+				case OP_READ:
+				case OP_WRITE:
+					if(this->ordered) {
+						this->flush_cells(p, pending, i);
+					}
+					this->flush_cell(p, pending, delta, i);
+					self::emit(p, (ops[i] == OP_READ) ? IR_READ : IR_WRITE, delta, 0, i);
+					break;
+				case OP_BEGIN_LOOP:
+					this->flush_cells(p, pending, i);
+					if(!balanced[i]) {
+						self::flush_move(p, delta, i);
+					}
+
+					loops.push_back(open_loop{static_cast<boost::uint32_t>(p.code.size()), delta, balanced[i]});
+					self::emit(p, IR_LOOP, delta, 0, i).count = i + 1 - block_begin;
+					block_begin = i + 1;
+					break;
+				case OP_END_LOOP:
+					if(loops.empty()) {
+						throw UnexpectedOperationGraphicMachineException();
+					}
+
+					this->flush_cells(p, pending, i);
+					if(!loops.back().balanced) {
+						self::flush_move(p, delta, i);
+					}
+					assert(delta == loops.back().delta || !loops.back().balanced);
+
+					self::emit(p, IR_END, delta, 0, i).count = i + 1 - block_begin;
+					p.code.back().jump = loops.back().index + 1;
+					p.code[loops.back().index].jump = static_cast<boost::uint32_t>(p.code.size());
+					loops.pop_back();
+					block_begin = i + 1;
+					break;
+				case OP_ROTATE_CLOCKWISE:
+				case OP_ROTATE_COUNTER_CLOCKWISE:
+					break;
+				case OP_UNKNOWN:
+				default:
+					this->flush_cells(p, pending, i);
+					self::emit(p, IR_FAIL, delta, static_cast<boost::int32_t>(ops[i]), i);
+					break;
+				}
+			}
+
+			if(!loops.empty()) {
+				throw UnexpectedEndOfProgrammGraphicMachineException();
+			}
+
+			this->flush_cells(p, pending, p.size);
+			self::flush_move(p, delta, p.size);
+			self::emit(p, IR_HALT, 0, 0, p.size).count = p.size - block_begin;
+
+			return p;
+		}
+	protected:
+		/// @brief Find balanced loops: zero net movement and all nested loops are balanced
+		///
+		///
+		static std::vector<bool> find_balanced(std::vector<Operation> const& ops) {
+			tracing::Scope scope("bracket match");
+			std::vector<bool> balanced(ops.size(), false);
+			std::vector<std::pair<boost::uint32_t, boost::int64_t>> st; // '[' and net movement
+			std::vector<bool> nested_ok;
+
+			for(boost::uint32_t i = 0; i < ops.size(); i++) {
+				switch(ops[i]) {
+				case OP_NEXT_CELL:
+				case OP_PREV_CELL:
+					if(!st.empty()) {
+						st.back().second += (ops[i] == OP_NEXT_CELL) ? 1 : -1;
+					}
+					break;
+				case OP_BEGIN_LOOP:
+					st.push_back(std::make_pair(i, 0));
+					nested_ok.push_back(true);
+					break;
+				case OP_END_LOOP:
+					if(!st.empty()) {
+						bool const ok = !st.back().second && nested_ok.back();
+
+						balanced[st.back().first] = ok;
+						st.pop_back();
+						nested_ok.pop_back();
+
+						if(!nested_ok.empty() && !ok) {
+							nested_ok.back() = false;
+						}
+					}
+					break;
+				default:
+					break;
+				}
+			}
+
+			return balanced;
+		}
+
+		static Instruction& emit(Program& p, Opcode opcode, boost::int32_t offset,
+								 boost::int32_t value, boost::uint32_t pos) {
+			p.code.push_back(Instruction{opcode, offset, value, 0, pos, 0});
+			return p.code.back();
+		}
+
+		/// @brief
+		///
+		/// @note In the ordered mode an addition of zero ("+-") is kept: it is an access.
+		void flush_cell(Program& p, pending_t& pending, boost::int32_t offset, boost::uint32_t pos) const {
+			pending_t::iterator i = pending.find(offset);
+
+			if(i != pending.end()) {
+				if(i->second || this->ordered) {
+					self::emit(p, IR_ADD, i->first, i->second, pos);
+				}
+				pending.erase(i);
+			}
+		}
+
+		void flush_cells(Program& p, pending_t& pending, boost::uint32_t pos) const {
+			std::for_each(pending.begin(), pending.end(), [this, &p, pos](auto const& x)->void {
+					if(x.second || this->ordered) {
+						self::emit(p, IR_ADD, x.first, x.second, pos);
+					}
+				});
+			pending.clear();
+		}
+
+		static void flush_move(Program& p, boost::int32_t& delta, boost::uint32_t pos) {
+			if(delta) {
+				self::emit(p, IR_MOVE, delta, 0, pos);
+				delta = 0;
+			}
+		}
+
+		bool ordered;
+	};
+
+	/// @brief Dataflow pass over the program: known-zero and constant cells, dead loops
+	///
+	/// @note Loops "[-]" with an odd step become IR_CLEAR. Then the values of cells are
+	///       tracked through straight-line code (the tape is zero at the start; additions
+	///       are folded onto known values); at the entry of a loop body nothing is known,
+	///       after a loop its cell is zero. A loop (or a clear) of a cell known to be zero
+	///       is removed; its block of source instructions is counted by the next IR_LOOP,
+	///       IR_END, IR_HALT or IR_CLEAR, so the instruction counter is the same.
+	class DataflowOptimizer {
+		typedef DataflowOptimizer self;
+
+		typedef std::map<boost::int64_t, boost::int32_t> known_t; // Cell (from origin) and value (-1 - unknown)
+
+		struct facts_t {
+			bool zero;            // Cells out of 'known' are zero (nothing is known otherwise)
+			boost::int64_t base;  // Current cell (from origin)
+			self::known_t known;
+			boost::int64_t tape;  // Cells out of the tape are never zero (zero - no bounds)
+		};
+	public:
+		/// @brief
+		///
+		/// @note With the size of the tape (the checked mode) an access out of the tape is
+		///       never removed: it must stop the program.
+		explicit DataflowOptimizer(boost::uint64_t raw_tape = 0) noexcept : tape(static_cast<boost::int64_t>(raw_tape)) {}
+
+		/// @brief
+		///
+		///
+		virtual ~DataflowOptimizer(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void optimize(Program& p) const {
+			std::vector<bool> keep(p.code.size(), true);
+			std::vector<bool> carried(p.code.size(), false);
+
+			self::find_clears(p, keep);
+			self::find_dead(p, keep, carried, this->tape);
+			self::rebuild(p, keep, carried);
+		}
+
+		/// @brief Multiplier of iterations of "[-]" with the odd step: -1 / step (mod 256)
+		///
+		///
+		static boost::int32_t iterations(boost::int32_t step) {
+			boost::uint8_t const v = static_cast<boost::uint8_t>(step);
+			boost::uint8_t inverse = v;
+
+			// RU: Метод Ньютона: каждая итерация удваивает число верных младших бит
+			for(int k = 0; k < 3; k++) {
+				inverse = static_cast<boost::uint8_t>(inverse * (2 - v * inverse));
+			}
+
+			return static_cast<boost::uint8_t>(-inverse);
+		}
+
+	protected:
+		static void find_clears(Program& p, std::vector<bool>& keep) {
+			for(boost::uint32_t i = 0; i + 2 < p.code.size(); i++) {
+				Instruction& loop = p.code[i];
+				Instruction const& add = p.code[i + 1];
+				Instruction const& end = p.code[i + 2];
+
+				if(loop.opcode == IR_LOOP && add.opcode == IR_ADD && end.opcode == IR_END &&
+				   loop.jump == i + 3 && add.offset == loop.offset && end.offset == loop.offset &&
+				   (add.value & 1)) {
+					loop.opcode = IR_CLEAR;
+					loop.value = self::iterations(add.value);
+					loop.jump = end.count;
+					keep[i + 1] = false;
+					keep[i + 2] = false;
+				}
+			}
+		}
+
+		/// @brief Find loops of cells known to be zero (their counters are carried)
+		///
+		///
+		static void find_dead(Program const& p, std::vector<bool>& keep, std::vector<bool>& carried,
+							  boost::int64_t tape) {
+			facts_t facts = {true, 0, self::known_t(), tape};
+
+			for(boost::uint32_t i = 0; i < p.code.size(); ) {
+				Instruction const& x = p.code[i];
+
+				if(!keep[i]) {
+					i++;
+					continue;
+				}
+
+				boost::int64_t const cell = facts.base + x.offset;
+
+				switch(x.opcode) {
+				case IR_ADD:
+					if(self::value(facts, cell) >= 0) {
+						facts.known[cell] = (self::value(facts, cell) + x.value) & 0xFF;
+					}
+					break;
+				case IR_MOVE:
+					facts.base += x.offset;
+					break;
+				case IR_READ:
+					facts.known[cell] = -1;
+					break;
+				case IR_LOOP:
+					if(!self::value(facts, cell)) {
+						std::fill(keep.begin() + i, keep.begin() + x.jump, false);
+						carried[i] = true;
+						i = x.jump;
+						continue;
+					}
+					self::forget(facts);
+					break;
+				case IR_END:
+					self::forget(facts);
+					facts.known[facts.base + x.offset] = 0;
+					break;
+				case IR_CLEAR:
+					if(!self::value(facts, cell)) {
+						keep[i] = false;
+						carried[i] = true;
+					}
+					facts.known[cell] = 0;
+					break;
+				case IR_WRITE:
+				case IR_FAIL:
+				case IR_HALT:
+				default:
+					break;
+				}
+
+				i++;
+			}
+		}
+
+		/// @brief Remove instructions, move the counters of the removed blocks and the jumps
+		///
+		///
+		static void rebuild(Program& p, std::vector<bool> const& keep, std::vector<bool> const& carried) {
+			Program::code_t code;
+			std::vector<boost::uint32_t> map(p.code.size() + 1, 0);
+			boost::uint32_t carry = 0;
+
+			for(boost::uint32_t i = 0; i < p.code.size(); i++) {
+				Instruction x = p.code[i];
+
+				map[i] = static_cast<boost::uint32_t>(code.size());
+
+				if(!keep[i]) {
+					// RU: Счётчик удалённого цикла достаётся следующему блоку; тело цикла и
+					//     хвост "[-]" (он уже в IR_CLEAR) не исполнялись и не считаются.
+					if(carried[i]) {
+						carry += x.count;
+					}
+					continue;
+				}
+
+				if(x.opcode == IR_LOOP || x.opcode == IR_END || x.opcode == IR_HALT || x.opcode == IR_CLEAR) {
+					x.count += carry;
+					carry = 0;
+				}
+
+				code.push_back(x);
+			}
+			map[p.code.size()] = static_cast<boost::uint32_t>(code.size());
+
+			std::for_each(code.begin(), code.end(), [&map](Instruction& x)->void {
+					if(x.opcode == IR_LOOP || x.opcode == IR_END) {
+						x.jump = map[x.jump];
+					}
+				});
+
+			p.eliminated += static_cast<boost::uint32_t>(p.code.size() - code.size());
+			p.code.swap(code);
+		}
+
+		static boost::int32_t value(facts_t const& facts, boost::int64_t cell) {
+			self::known_t::const_iterator const i = facts.known.find(cell);
+
+			if(i != facts.known.end()) {
+				return i->second;
+			}
+
+			if(facts.tape && (cell < 0 || cell >= facts.tape)) {
+				return -1;
+			}
+
+			return (facts.zero) ? 0 : -1;
+		}
+
+		static void forget(facts_t& facts) {
+			facts.zero = false;
+			facts.known.clear();
+		}
+
+		boost::int64_t tape;
+	};
+
+	/// @brief Vectors of additions: multiply loops and runs of IR_ADD (see VectorAdd)
+	///
+	/// @note A loop of IR_ADD only, whose counter has an odd step and whose other cells are
+	///       in one window, becomes IR_MUL (table initialization, "[->+>++>+++<<<]").
+	///       Adjacent IR_ADD (never jump targets) are summed by cells and cut into windows
+	///       from the lowest cell; a window of two cells or more becomes IR_VADD.
+	class VectorOptimizer {
+		typedef VectorOptimizer self;
+	public:
+		/// @brief
+		///
+		///
+		VectorOptimizer(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual ~VectorOptimizer(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void optimize(Program& p) const {
+			tracing::Scope scope("vectorize");
+			Program::code_t code;
+			std::vector<boost::uint32_t> map(p.code.size() + 1, 0);
+
+			for(boost::uint32_t i = 0; i < p.code.size(); ) {
+				boost::uint32_t next = i + 1;
+
+				map[i] = static_cast<boost::uint32_t>(code.size());
+
+				if(self::multiply(p, i, code)) {
+					next = p.code[i].jump;
+				}
+				else if(p.code[i].opcode == IR_ADD) {
+					while(next < p.code.size() && p.code[next].opcode == IR_ADD) {
+						next++;
+					}
+					self::vectorize(p, i, next, code);
+				}
+				else {
+					code.push_back(p.code[i]);
+				}
+
+				std::fill(map.begin() + i + 1, map.begin() + next, map[i]);
+				i = next;
+			}
+			map[p.code.size()] = static_cast<boost::uint32_t>(code.size());
+
+			std::for_each(code.begin(), code.end(), [&map](Instruction& x)->void {
+					if(x.opcode == IR_LOOP || x.opcode == IR_END) {
+						x.jump = map[x.jump];
+					}
+				});
+
+			p.code.swap(code);
+		}
+	protected:
+		/// @brief Replace the multiply loop which starts at the instruction (false - not such loop)
+		///
+		///
+		static bool multiply(Program& p, boost::uint32_t i, Program::code_t& code) {
+			Instruction const& loop = p.code[i];
+
+			if(loop.opcode != IR_LOOP || p.code[loop.jump - 1].offset != loop.offset) {
+				return false;
+			}
+
+			boost::uint32_t const end = loop.jump - 1;
+			boost::int32_t first = std::numeric_limits<boost::int32_t>::max();
+			boost::int32_t last = std::numeric_limits<boost::int32_t>::min();
+			boost::int32_t step = 0;
+
+			for(boost::uint32_t j = i + 1; j < end; j++) {
+				Instruction const& x = p.code[j];
+
+				if(x.opcode != IR_ADD) {
+					return false;
+				}
+
+				if(x.offset == loop.offset) {
+					step += x.value;
+				}
+				else {
+					first = std::min(first, x.offset);
+					last = std::max(last, x.offset);
+				}
+			}
+
+			if(!(step & 1) || first > last ||
+			   static_cast<boost::int64_t>(last) - first >= static_cast<boost::int64_t>(VECTOR_LANES)) {
+				return false;
+			}
+
+			VectorAdd v = VectorAdd();
+
+			v.offset = first;
+			v.size = static_cast<boost::uint32_t>(last - first + 1);
+			v.iterations = static_cast<boost::uint32_t>(DataflowOptimizer::iterations(step));
+			for(boost::uint32_t j = i + 1; j < end; j++) {
+				if(p.code[j].offset != loop.offset) {
+					v.lanes[p.code[j].offset - first] += static_cast<boost::uint8_t>(p.code[j].value);
+				}
+			}
+
+			p.vectors.push_back(v);
+			code.push_back(Instruction{IR_MUL, loop.offset, static_cast<boost::int32_t>(p.vectors.size() - 1),
+									   p.code[end].count, loop.pos, loop.count});
+			return true;
+		}
+
+		/// @brief Replace the run of IR_ADD [from, to) by windows
+		///
+		///
+		static void vectorize(Program& p, boost::uint32_t from, boost::uint32_t to, Program::code_t& code) {
+			std::map<boost::int32_t, boost::uint8_t> adds;
+			boost::uint32_t const pos = p.code[from].pos;
+
+			for(boost::uint32_t j = from; j < to; j++) {
+				adds[p.code[j].offset] += static_cast<boost::uint8_t>(p.code[j].value);
+			}
+
+			for(auto i = adds.begin(); i != adds.end(); ) {
+				auto j = i;
+				boost::uint32_t cells = 0;
+
+				for(; j != adds.end() && static_cast<boost::int64_t>(j->first) - i->first <
+						static_cast<boost::int64_t>(VECTOR_LANES); j++) {
+					cells++;
+				}
+
+				if(cells < 2) {
+					code.push_back(Instruction{IR_ADD, i->first, i->second, 0, pos, 0});
+					i = j;
+					continue;
+				}
+
+				VectorAdd v = VectorAdd();
+
+				v.offset = i->first;
+				for(; i != j; i++) {
+					v.lanes[i->first - v.offset] = i->second;
+					v.size = static_cast<boost::uint32_t>(i->first - v.offset + 1);
+				}
+
+				p.vectors.push_back(v);
+				code.push_back(Instruction{IR_VADD, v.offset, static_cast<boost::int32_t>(p.vectors.size() - 1),
+										   0, pos, 0});
+			}
+		}
+	};
+
+	/// @brief Range checks of the head for the checked mode (see TapeOptions::checked)
+	///
+	/// @note Between moves of the head all accesses are at constant offsets from one base
+	///       cell, and a loop without IR_MOVE doesn't move it at all. So a region from a move
+	///       (or the entry of a loop which moves the head) up to the next one gets a single
+	///       IR_CHECK of the range of its offsets, with bodies of such loops. Only bodies of
+	///       loops which move the head are checked on every iteration. The range may cover
+	///       accesses which are skipped, so a failed check is not an error: the engine checks
+	///       every access until the next check which passes.
+	class BoundsChecker {
+		typedef BoundsChecker self;
+	public:
+		/// @brief
+		///
+		///
+		BoundsChecker(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual ~BoundsChecker(void) noexcept {}
+
+		/// @brief Insert range checks at the starts of regions of the program
+		///
+		///
+		virtual void insert(Program& p) const {
+			tracing::Scope scope("bounds");
+			Program::code_t const& code = p.code;
+			std::vector<bool> starts(code.size(), false);
+			std::vector<bool> moving(code.size(), false); // IR_LOOP of loops which move the head
+			std::vector<boost::uint32_t> loops;           // Open loops
+			Program::code_t checked;
+			std::vector<boost::uint32_t> map(code.size() + 1, 0);
+
+			starts[0] = true;
+			for(boost::uint32_t i = 0; i < code.size(); i++) {
+				if(code[i].opcode == IR_MOVE) {
+					starts[i + 1] = true;
+					if(!loops.empty()) {
+						moving[loops.back()] = true;
+					}
+				}
+				else if(code[i].opcode == IR_LOOP) {
+					loops.push_back(i);
+				}
+				else if(code[i].opcode == IR_END && !loops.empty()) {
+					boost::uint32_t const loop = loops.back();
+
+					loops.pop_back();
+					if(moving[loop]) {
+						// RU: Тело проверяется на каждой итерации, код после цикла - заново
+						starts[loop + 1] = true;
+						starts[i + 1] = true;
+						if(!loops.empty()) {
+							moving[loops.back()] = true;
+						}
+					}
+				}
+			}
+
+			for(boost::uint32_t i = 0; i < code.size(); i++) {
+				map[i] = static_cast<boost::uint32_t>(checked.size());
+
+				if(starts[i]) {
+					boost::int32_t first = std::numeric_limits<boost::int32_t>::max();
+					boost::int32_t last = std::numeric_limits<boost::int32_t>::min();
+
+					for(boost::uint32_t j = i; j < code.size() && (j == i || !starts[j]); j++) {
+						self::span(p, code[j], first, last);
+					}
+
+					if(first <= last) {
+						checked.push_back(Instruction{IR_CHECK, first, last, 0, code[i].pos, 0});
+					}
+				}
+
+				checked.push_back(code[i]);
+			}
+			map[code.size()] = static_cast<boost::uint32_t>(checked.size());
+
+			std::for_each(checked.begin(), checked.end(), [&map](Instruction& x)->void {
+					if(x.opcode == IR_LOOP || x.opcode == IR_END) {
+						x.jump = map[x.jump];
+					}
+				});
+
+			p.code.swap(checked);
+			p.checked = true;
+		}
+
+		/// @brief Extend the range by the cells which the instruction accesses
+		///
+		///
+		static void span(Program const& p, Instruction const& x, boost::int32_t& first, boost::int32_t& last) {
+			switch(x.opcode) {
+			case IR_MUL:
+				first = std::min(first, x.offset);
+				last = std::max(last, x.offset);
+				// falls through
+			case IR_VADD:
+				{
+					VectorAdd const& v = p.vectors[x.value];
+
+					first = std::min(first, v.offset);
+					last = std::max(last, static_cast<boost::int32_t>(v.offset + v.size - 1));
+				}
+				break;
+			case IR_SOLVE:
+				{
+					LinearLoop const& l = p.linear[x.value];
+
+					first = std::min(first, x.offset);
+					last = std::max(last, x.offset);
+					for(boost::uint32_t k = l.first; k < l.first + l.vectors; k++) {
+						first = std::min(first, p.vectors[k].offset);
+						last = std::max(last, static_cast<boost::int32_t>(p.vectors[k].offset + p.vectors[k].size - 1));
+					}
+				}
+				break;
+			case IR_ADD:
+			case IR_READ:
+			case IR_WRITE:
+			case IR_LOOP:
+			case IR_END:
+			case IR_CLEAR:
+				first = std::min(first, x.offset);
+				last = std::max(last, x.offset);
+				break;
+			default:
+				break;
+			}
+		}
+	};
+
+	/// @brief Closed form of loops of constant additions (see LinearLoop and IR_SOLVE)
+	///
+	/// @note A loop without moves and I/O, whose counter steps by a constant: the rest of
+	///       iterations after the first one is solved by the inverse of the odd part of the
+	///       step. The body is run by abstract interpretation (inner loops, IR_CLEAR and
+	///       IR_MUL of known counters are simulated): the first pass from an unknown tape
+	///       finds the cells which are constant after one iteration, the second pass from
+	///       these cells must depend on nothing else and come back to the same constants.
+	///       Then all iterations but the first one are the same additions: the first one
+	///       runs as is, "LOOP body END" becomes "LOOP body IR_SOLVE END".
+	class LinearLoopSolver {
+		typedef LinearLoopSolver self;
+
+		struct value_t {
+			bool known;           // Constant, or the value at the entry plus delta
+			boost::uint8_t value; // The constant or the delta
+		};
+
+		typedef std::map<boost::int32_t, value_t> cells_t;
+
+		struct run_t {
+			bool strict;                // Fail on unknown counters (forget the cells of the loop otherwise)
+			self::cells_t cells;
+			boost::uint64_t executed;
+			boost::uint64_t back_edges;
+			boost::uint32_t steps;      // Budget of instructions of the simulation
+		};
+	public:
+		/// @brief
+		///
+		///
+		LinearLoopSolver(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual ~LinearLoopSolver(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void optimize(Program& p) const {
+			tracing::Scope scope("solve");
+			std::vector<boost::int32_t> solved(p.code.size(), -1); // LinearLoop of IR_END
+			Program::code_t code;
+			std::vector<boost::uint32_t> map(p.code.size() + 1, 0);
+
+			for(boost::uint32_t i = 0; i < p.code.size(); i++) {
+				LinearLoop l = LinearLoop();
+
+				if(p.code[i].opcode == IR_LOOP && self::solve(p, i, l)) {
+					solved[p.code[i].jump - 1] = static_cast<boost::int32_t>(p.linear.size());
+					p.linear.push_back(l);
+				}
+			}
+
+			for(boost::uint32_t i = 0; i < p.code.size(); i++) {
+				map[i] = static_cast<boost::uint32_t>(code.size());
+
+				// RU: Переход на IR_END изнутри цикла (пропуск вложенного) попадает на IR_SOLVE
+				if(solved[i] >= 0) {
+					code.push_back(Instruction{IR_SOLVE, p.code[i].offset, solved[i], 0, p.code[i].pos, 0});
+				}
+				code.push_back(p.code[i]);
+			}
+			map[p.code.size()] = static_cast<boost::uint32_t>(code.size());
+
+			std::for_each(code.begin(), code.end(), [&map](Instruction& x)->void {
+					if(x.opcode == IR_LOOP || x.opcode == IR_END) {
+						x.jump = map[x.jump];
+					}
+				});
+
+			p.code.swap(code);
+		}
+	protected:
+		/// @brief Solve the loop which starts at the instruction (false - not a linear loop)
+		///
+		///
+		static bool solve(Program& p, boost::uint32_t i, LinearLoop& l) {
+			Instruction const& loop = p.code[i];
+			boost::uint32_t const end = loop.jump - 1;
+
+			if(p.code[end].offset != loop.offset) {
+				return false;
+			}
+
+			for(boost::uint32_t j = i + 1; j < end; j++) {
+				switch(p.code[j].opcode) {
+				case IR_ADD:
+				case IR_LOOP:
+				case IR_END:
+				case IR_CLEAR:
+				case IR_VADD:
+				case IR_MUL:
+					break;
+				default:
+					return false;
+				}
+			}
+
+			run_t first = {false, self::cells_t(), 0, 0, self::MAX_STEPS};
+
+			if(!self::run(p, i + 1, end, first)) {
+				return false;
+			}
+
+			run_t steady = {true, self::cells_t(), 0, 0, self::MAX_STEPS};
+
+			std::for_each(first.cells.begin(), first.cells.end(), [&steady](auto const& x)->void {
+					if(x.second.known) {
+						steady.cells.insert(x);
+					}
+				});
+
+			self::cells_t const entry = steady.cells;
+			std::map<boost::int32_t, boost::uint8_t> adds;
+			boost::uint8_t step = 0;
+
+			if(!self::run(p, i + 1, end, steady)) {
+				return false;
+			}
+
+			for(auto const& x : steady.cells) {
+				if(x.second.known) {
+					auto const e = entry.find(x.first);
+
+					// RU: Константы должны вернуться к себе, иначе итерации не одинаковы
+					if(e == entry.end() || e->second.value != x.second.value) {
+						return false;
+					}
+				}
+				else if(x.first == loop.offset) {
+					step = x.second.value;
+				}
+				else if(x.second.value) {
+					adds[x.first] = x.second.value;
+				}
+			}
+
+			if(!step) {
+				return false;
+			}
+
+			l.shift = 0;
+			while(!((step >> l.shift) & 1)) {
+				l.shift++;
+			}
+			l.iterations = static_cast<boost::uint32_t>(DataflowOptimizer::iterations(step >> l.shift)) & (0xFFu >> l.shift);
+			l.executed = steady.executed + p.code[end].count;
+			l.back_edges = steady.back_edges + 1;
+			l.first = static_cast<boost::uint32_t>(p.vectors.size());
+
+			for(auto j = adds.begin(); j != adds.end(); ) {
+				VectorAdd v = VectorAdd();
+
+				v.offset = j->first;
+				for(; j != adds.end() && static_cast<boost::int64_t>(j->first) - v.offset <
+						static_cast<boost::int64_t>(VECTOR_LANES); j++) {
+					v.lanes[j->first - v.offset] = j->second;
+					v.size = static_cast<boost::uint32_t>(j->first - v.offset + 1);
+				}
+				p.vectors.push_back(v);
+			}
+			l.vectors = static_cast<boost::uint32_t>(p.vectors.size()) - l.first;
+
+			return true;
+		}
+
+		/// @brief Run the instructions [from, to) on the cells (false - not a linear body)
+		///
+		///
+		static bool run(Program const& p, boost::uint32_t from, boost::uint32_t to, run_t& r) {
+			for(boost::uint32_t j = from; j < to; ) {
+				Instruction const& x = p.code[j];
+
+				if(!r.steps) {
+					return false;
+				}
+				r.steps--;
+
+				switch(x.opcode) {
+				case IR_ADD:
+					r.cells[x.offset].value += static_cast<boost::uint8_t>(x.value);
+					break;
+				case IR_VADD:
+					self::add(r, p.vectors[x.value], 1);
+					break;
+				case IR_CLEAR:
+				case IR_MUL:
+					{
+						value_t& c = r.cells[x.offset];
+
+						if(!c.known && r.strict) {
+							return false;
+						}
+
+						if(!c.known) {
+							if(x.opcode == IR_MUL) {
+								self::forget(p, x, r);
+							}
+						}
+						else {
+							boost::uint32_t const iterations = (x.opcode == IR_MUL) ?
+								p.vectors[x.value].iterations : static_cast<boost::uint32_t>(x.value);
+							boost::uint64_t const k = (c.value * iterations) & 0xFF;
+
+							r.executed += x.count + k * x.jump;
+							r.back_edges += (k) ? k - 1 : 0;
+							if(x.opcode == IR_MUL) {
+								self::add(r, p.vectors[x.value], static_cast<boost::uint8_t>(k));
+							}
+						}
+						c = value_t{true, 0};
+					}
+					break;
+				case IR_LOOP:
+					if(!self::loop(p, j, r)) {
+						return false;
+					}
+					j = x.jump;
+					continue;
+				default:
+					return false;
+				}
+
+				j++;
+			}
+
+			return true;
+		}
+
+		/// @brief Run the inner loop which starts at the instruction
+		///
+		/// @note Not strict: the loop which can't be simulated leaves its cells unknown and
+		///       its counter zero (it has no exit otherwise).
+		static bool loop(Program const& p, boost::uint32_t i, run_t& r) {
+			Instruction const& x = p.code[i];
+			Instruction const& end = p.code[x.jump - 1];
+			run_t const saved = r;
+
+			r.executed += x.count;
+			for(boost::uint32_t n = 0; n <= self::MAX_ITERATIONS; n++) {
+				value_t const c = r.cells[x.offset];
+
+				if(!c.known) {
+					break;
+				}
+
+				if(!c.value) {
+					return true;
+				}
+
+				if(n) {
+					r.back_edges++;
+				}
+
+				if(!self::run(p, i + 1, x.jump - 1, r)) {
+					break;
+				}
+				r.executed += end.count;
+			}
+
+			if(r.strict || !r.steps) {
+				return false;
+			}
+
+			boost::uint32_t const steps = r.steps;
+
+			r = saved;
+			r.steps = steps;
+			for(boost::uint32_t j = i; j < x.jump; j++) {
+				self::forget(p, p.code[j], r);
+			}
+			r.cells[x.offset] = value_t{true, 0};
+			return true;
+		}
+
+		/// @brief Add the lanes of the vector times the factor
+		///
+		///
+		static void add(run_t& r, VectorAdd const& v, boost::uint8_t factor) {
+			for(boost::uint32_t k = 0; k < v.size; k++) {
+				if(v.lanes[k]) {
+					r.cells[v.offset + static_cast<boost::int32_t>(k)].value += static_cast<boost::uint8_t>(v.lanes[k] * factor);
+				}
+			}
+		}
+
+		/// @brief Make the cells which the instruction changes unknown
+		///
+		///
+		static void forget(Program const& p, Instruction const& x, run_t& r) {
+			boost::int32_t first = std::numeric_limits<boost::int32_t>::max();
+			boost::int32_t last = std::numeric_limits<boost::int32_t>::min();
+
+			BoundsChecker::span(p, x, first, last);
+			for(boost::int64_t k = first; k <= last; k++) {
+				r.cells[static_cast<boost::int32_t>(k)] = value_t{false, 0};
+			}
+		}
+
+		static boost::uint32_t const MAX_ITERATIONS; // Iterations of one entry of an inner loop
+		static boost::uint32_t const MAX_STEPS;      // Instructions of one pass
+	};
+
+	boost::uint32_t const LinearLoopSolver::MAX_ITERATIONS = 256;
+	boost::uint32_t const LinearLoopSolver::MAX_STEPS = 1 << 14;
+
+	/// @brief Partial evaluator of the input-independent prefix of the program
+	///
+	/// @note Runs the program until the first reachable OP_READ (or the end, or an unsupported
+	///       operation); a long computation is cut at a back-edge when the budget is over.
+	///       The output and the tape are stored in Program::prefix. A program which walks
+	///       out of the tape is left as is: it will fail at run time the same way.
+	class PrefixEvaluator {
+		typedef PrefixEvaluator self;
+	public:
+		/// @brief
+		///
+		///
+		PrefixEvaluator(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual ~PrefixEvaluator(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void evaluate(Program& p, boost::uint64_t tape_size, boost::uint64_t budget) const {
+			std::vector<boost::uint8_t> cells(tape_size, 0);
+			ProgramPrefix prefix = ProgramPrefix();
+			boost::uint64_t num = 0;
+			boost::uint64_t steps = 0;
+			boost::uint32_t pc = 0;
+			bool done = false;
+			std::vector<bool> const stable = p.stable_loops();
+
+			while(!done) {
+				Instruction const& i = p.code[pc];
+				boost::uint64_t const cell = num + static_cast<boost::uint64_t>(static_cast<boost::int64_t>(i.offset));
+
+				if(i.opcode != IR_MOVE && i.opcode != IR_READ && i.opcode != IR_FAIL &&
+				   i.opcode != IR_HALT && i.opcode != IR_CHECK && cell >= tape_size) {
+					return;
+				}
+
+				switch(i.opcode) {
+				case IR_ADD:
+					cells[cell] += static_cast<boost::uint8_t>(i.value);
+					pc++;
+					break;
+				case IR_MOVE:
+					num = cell;
+					pc++;
+					break;
+				case IR_WRITE:
+					prefix.output.push_back(cells[cell]);
+					pc++;
+					break;
+				case IR_LOOP:
+					prefix.executed += i.count;
+					pc = (cells[cell]) ? pc + 1 : i.jump;
+					break;
+				case IR_END:
+					prefix.executed += i.count;
+					if(cells[cell]) {
+						boost::uint32_t const pos = p.code[i.jump - 1].pos;
+
+						prefix.back_edges++;
+						prefix.ends += (pos < stable.size() && stable[pos]);
+						pc = i.jump;
+						done = (steps > budget);
+					}
+					else {
+						pc++;
+					}
+					break;
+				case IR_CLEAR:
+					{
+						boost::uint64_t const k = (cells[cell] * static_cast<boost::uint32_t>(i.value)) & 0xFF;
+
+						prefix.executed += i.count + k * i.jump;
+						prefix.back_edges += (k) ? k - 1 : 0; // The last iteration falls through
+						cells[cell] = 0;
+						pc++;
+					}
+					break;
+				case IR_VADD:
+				case IR_MUL:
+					{
+						VectorAdd const& v = p.vectors[i.value];
+						boost::uint64_t const first = num + static_cast<boost::uint64_t>(static_cast<boost::int64_t>(v.offset));
+						boost::uint64_t k = 1;
+
+						if(first >= tape_size || tape_size - first < v.size) {
+							return;
+						}
+
+						if(i.opcode == IR_MUL) {
+							k = (cells[cell] * v.iterations) & 0xFF;
+							prefix.executed += i.count + k * i.jump;
+							prefix.back_edges += (k) ? k - 1 : 0;
+							cells[cell] = 0;
+						}
+
+						add_vector(cells.data(), cells.size(), first, v, static_cast<boost::uint8_t>(k));
+						pc++;
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = p.linear[i.value];
+						boost::uint32_t const k = l.rest(cells[cell]);
+
+						for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+							boost::uint64_t const first = num + static_cast<boost::uint64_t>(static_cast<boost::int64_t>(p.vectors[j].offset));
+
+							if(first >= tape_size || tape_size - first < p.vectors[j].size) {
+								return;
+							}
+						}
+
+						if(k) {
+							prefix.executed += k * l.executed;
+							prefix.back_edges += k * l.back_edges;
+							cells[cell] = 0;
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								add_vector(cells.data(), cells.size(),
+										   num + static_cast<boost::uint64_t>(static_cast<boost::int64_t>(p.vectors[j].offset)),
+										   p.vectors[j], static_cast<boost::uint8_t>(k));
+							}
+						}
+						pc++;
+					}
+					break;
+				case IR_CHECK:
+					// RU: Диапазон вне ленты - префикс кончается, дальше решит машина
+					if(cell >= tape_size ||
+					   num + static_cast<boost::uint64_t>(static_cast<boost::int64_t>(i.value)) >= tape_size) {
+						done = true;
+					}
+					else {
+						pc++;
+					}
+					break;
+				case IR_READ:
+				case IR_FAIL:
+				case IR_HALT:
+				default:
+					done = true;
+					break;
+				}
+
+				steps++;
+			}
+
+			if(!pc && prefix.output.empty()) {
+				return;
+			}
+
+			for(boost::uint64_t i = 0; i < cells.size(); i++) {
+				if(cells[i]) {
+					prefix.cells.push_back(std::make_pair(i, cells[i]));
+				}
+			}
+
+			prefix.valid = true;
+			prefix.start = pc;
+			prefix.num = num;
+			p.prefix = prefix;
+		}
+	};
+
+	/// @brief Statistics of opcode sequences collected by the instrumented run
+	///
+	/// @note The weight of a superinstruction is the number of dispatches it would save:
+	///       the executions of all its instructions except the first one. Sequences which
+	///       cross a jump target can't be fused and are not counted.
+	class OpcodeProfile {
+		typedef OpcodeProfile self;
+	public:
+		/// @brief
+		///
+		///
+		OpcodeProfile(void) : total(0), weights(SI_COUNT, 0) {}
+
+		boost::uint64_t total;                // Dispatches of the instrumented run
+		std::vector<boost::uint64_t> weights; // Saved dispatches by kind
+
+		/// @brief Add executions of instructions of the program
+		///
+		///
+		void collect(Program const& p, std::vector<boost::uint64_t> const& counts) {
+			std::vector<bool> const targets = p.jump_targets();
+
+			for(boost::uint32_t i = 0; i < p.code.size(); i++) {
+				this->total += counts[i];
+
+				for(boost::uint32_t k = 0; k < SI_COUNT; k++) {
+					if(self::match(p, targets, i, SUPERINSTRUCTIONS[k])) {
+						for(boost::uint32_t j = 1; j < SUPERINSTRUCTIONS[k].size; j++) {
+							this->weights[k] += counts[i + j];
+						}
+					}
+				}
+			}
+		}
+
+		/// @brief Kinds worth fusing (at least 1% of dispatches), the heaviest first
+		///
+		///
+		std::vector<boost::uint8_t> select(void) const {
+			std::vector<boost::uint8_t> kinds;
+
+			for(boost::uint32_t k = 0; k < SI_COUNT; k++) {
+				if(this->weights[k] && this->weights[k] * 100 >= this->total) {
+					kinds.push_back(static_cast<boost::uint8_t>(k));
+				}
+			}
+
+			std::stable_sort(kinds.begin(), kinds.end(), [this](boost::uint8_t a, boost::uint8_t b)->bool {
+					return this->weights[a] > this->weights[b];
+				});
+			return kinds;
+		}
+
+		/// @brief Does the pattern match the instructions from i (without jumps inside)?
+		///
+		///
+		static bool match(Program const& p, std::vector<bool> const& targets,
+						  boost::uint32_t i, SuperinstructionPattern const& pattern) {
+			if(i + pattern.size > p.code.size()) {
+				return false;
+			}
+
+			for(boost::uint32_t j = 0; j < pattern.size; j++) {
+				if(p.code[i + j].opcode != pattern.ops[j] || (j && targets[i + j])) {
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/// @brief Text file: "TOTAL n" and "NAME weight" lines
+		///
+		///
+		bool save(std::string const& filename) const {
+			std::ofstream f(filename.c_str(), std::ios::trunc);
+
+			f << "TOTAL " << this->total << std::endl;
+			for(boost::uint32_t k = 0; k < SI_COUNT; k++) {
+				f << SUPERINSTRUCTIONS[k].name << " " << this->weights[k] << std::endl;
+			}
+
+			return static_cast<bool>(f);
+		}
+
+		/// @brief
+		///
+		///
+		bool load(std::string const& filename) {
+			std::ifstream f(filename.c_str());
+			std::string name;
+			boost::uint64_t value = 0;
+
+			while(f >> name >> value) {
+				if(name == "TOTAL") {
+					this->total += value;
+				}
+
+				for(boost::uint32_t k = 0; k < SI_COUNT; k++) {
+					if(name == SUPERINSTRUCTIONS[k].name) {
+						this->weights[k] += value;
+					}
+				}
+			}
+
+			return f.eof() && this->total;
+		}
+	};
+
+	/// @brief Allocator of the tape (see TapeAllocation)
+	///
+	/// @note The tape is zeroed by std::vector right after the allocation, so the pages are
+	///       touched by the thread which runs the program. Binding to NUMA node needs pages
+	///       of its own, so it's ignored for TA_DEFAULT.
+	template<typename T>
+	class TapeAllocator {
+		typedef TapeAllocator<T> self;
+	public:
+		typedef T value_type;
+		typedef std::true_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+
+		/// @brief
+		///
+		///
+		TapeAllocator(void) noexcept : allocation(TA_DEFAULT), numa(false) {}
+
+		/// @brief
+		///
+		///
+		TapeAllocator(TapeAllocation a, bool n) noexcept : allocation(a), numa(n) {}
+
+		/// @brief
+		///
+		///
+		template<typename U>
+		TapeAllocator(TapeAllocator<U> const& x) noexcept : allocation(x.allocation), numa(x.numa) {}
+
+		/// @brief
+		///
+		///
+		T* allocate(std::size_t n) {
+			std::size_t const bytes = n * sizeof(T);
+			void* p = nullptr;
+
+			switch(this->allocation) {
+			case TA_ALIGNED:
+				if(::posix_memalign(&p, self::page_size(), bytes)) {
+					p = nullptr;
+				}
+				break;
+			case TA_HUGETLB:
+				p = self::map(bytes, true);
+				if(p) {
+					break;
+				}
+				// RU: Нет зарезервированных huge pages - используются transparent huge pages
+				// fall through
+			case TA_HUGEPAGES:
+				p = self::map(bytes, false);
+				break;
+			case TA_DEFAULT:
+			default:
+				return std::allocator<T>().allocate(n);
+			}
+
+			if(!p) {
+				throw std::bad_alloc();
+			}
+
+			if(this->numa) {
+				self::bind_local(p, bytes);
+			}
+
+			return static_cast<T*>(p);
+		}
+
+		/// @brief
+		///
+		///
+		void deallocate(T* p, std::size_t n) noexcept {
+			switch(this->allocation) {
+			case TA_ALIGNED:
+				::free(p);
+				break;
+			case TA_HUGETLB:
+			case TA_HUGEPAGES:
+				::munmap(p, self::huge_size(n * sizeof(T)));
+				break;
+			case TA_DEFAULT:
+			default:
+				std::allocator<T>().deallocate(p, n);
+				break;
+			}
+		}
+
+		/// @brief
+		///
+		///
+		bool operator==(self const& x) const noexcept {
+			return this->allocation == x.allocation && this->numa == x.numa;
+		}
+
+		/// @brief
+		///
+		///
+		bool operator!=(self const& x) const noexcept {
+			return !(*this == x);
+		}
+
+		TapeAllocation allocation;
+		bool numa;
+	private:
+		static std::size_t page_size(void) {
+			long const size = ::sysconf(_SC_PAGESIZE);
+
+			return (size > 0) ? static_cast<std::size_t>(size) : 4096;
+		}
+
+		static std::size_t huge_size(std::size_t bytes) {
+			return (bytes + self::HUGE_PAGE_SIZE - 1) & ~(self::HUGE_PAGE_SIZE - 1);
+		}
+
+		/// @brief Anonymous mapping aligned to huge page
+		///
+		///
+		static void* map(std::size_t bytes, bool hugetlb) {
+			std::size_t const size = self::huge_size(bytes);
+			int const prot = PROT_READ | PROT_WRITE;
+			int const flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+			if(hugetlb) {
+#if defined(MAP_HUGETLB)
+				void* const p = ::mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0);
+
+				return (p != MAP_FAILED) ? p : nullptr;
+#else
+				return nullptr;
+#endif
+			}
+
+			// RU: Одна лишняя huge page нужна для выравнивания, лишние края возвращаются системе
+			void* const raw = ::mmap(nullptr, size + self::HUGE_PAGE_SIZE, prot, flags, -1, 0);
+			if(raw == MAP_FAILED) {
+				return nullptr;
+			}
+
+			char* const begin = static_cast<char*>(raw);
+			char* const p = reinterpret_cast<char*>(
+				(reinterpret_cast<std::uintptr_t>(begin) + self::HUGE_PAGE_SIZE - 1) & ~(self::HUGE_PAGE_SIZE - 1));
+			char* const end = begin + size + self::HUGE_PAGE_SIZE;
+
+			if(p != begin) {
+				::munmap(begin, p - begin);
+			}
+			if(p + size != end) {
+				::munmap(p + size, end - (p + size));
+			}
+#if defined(MADV_HUGEPAGE)
+			::madvise(p, size, MADV_HUGEPAGE);
+#endif
+			return p;
+		}
+
+		/// @brief Prefer memory of NUMA node of the current CPU (the run should be pinned)
+		///
+		///
+		static void bind_local(void* p, std::size_t bytes) {
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+			unsigned int cpu = 0;
+			unsigned int node = 0;
+
+			if(!::syscall(SYS_getcpu, &cpu, &node, nullptr) && node < sizeof(unsigned long) * 8) {
+				unsigned long const mask = 1UL << node;
+
+				::syscall(SYS_mbind, p, bytes, self::MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0);
+			}
+#else
+			UNUSED_SUPPRESSOR(p);
+			UNUSED_SUPPRESSOR(bytes);
+#endif
+		}
+
+		static std::size_t const HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+		static int const MPOL_PREFERRED = 1; // RU: Из <numaif.h>, чтобы не зависеть от libnuma
+	};
+
+	/// @brief Complete state of the machine: it's enough to continue the program later
+	///
+	/// @note The tape is written sparse: only runs of non-zero cells are stored.
+	class MachineState {
+		typedef MachineState self;
+	public:
+		typedef boost::uint8_t cell_t;
+		typedef TapeAllocator<self::cell_t> allocator_t;
+		typedef std::vector<self::cell_t, self::allocator_t> cells_t;
+		typedef self::cells_t::size_type index_t;
+		typedef std::vector<boost::uint32_t> loops_t;
+
+		self::cells_t cells;        // Tape
+		self::index_t num;          // Number of current cell
+		boost::uint32_t pos;        // Position of the next instruction
+		self::loops_t loops;        // Positions of open loops (the last one is the innermost)
+		boost::int64_t in_offset;   // Offset of the standard input (-1 - not seekable)
+		boost::uint64_t bytes_in;   // Values read by OP_READ
+		boost::uint64_t bytes_out;  // Values written by OP_WRITE
+		boost::uint64_t executed;   // Executed instructions
+		boost::uint64_t back_edges; // Passed back-edges of loops
+		boost::uint64_t image;      // Hash of the program (see IIteratorMachine::get_hash)
+
+		/// @brief
+		///
+		///
+		explicit MachineState(self::allocator_t const& a = self::allocator_t()) :
+			cells(a),
+			num(0),
+			pos(0),
+			loops(),
+			in_offset(-1),
+			bytes_in(0),
+			bytes_out(0),
+			executed(0),
+			back_edges(0),
+			image(0) {}
+
+		/// @brief Initial state: clean tape of given size
+		///
+		///
+		void reset(self::index_t size) {
+			self::cells_t(size, 0, this->cells.get_allocator()).swap(this->cells);
+			this->num = 0;
+			this->pos = 0;
+			this->loops.clear();
+			this->in_offset = -1;
+			this->bytes_in = 0;
+			this->bytes_out = 0;
+			this->executed = 0;
+			this->back_edges = 0;
+			this->image = 0;
+		}
+
+		/// @brief
+		///
+		/// @note The hash of the program and the size of the cell are written first: the
+		///       state is valid for the same image and the same build only.
+		void save(std::string const& filename) const {
+			utils::BinaryWriter w;
+			std::vector<std::pair<self::index_t, self::index_t>> runs;
+
+			// RU: Соседние ненулевые участки склеиваются, если между ними мало нулей:
+			//     заголовок участка дороже нескольких нулевых байт.
+			for(self::index_t i = 0; i < this->cells.size(); i++) {
+				if(!this->cells[i]) {
+					continue;
+				}
+
+				if(!runs.empty() && i - runs.back().second < self::RUN_GAP) {
+					runs.back().second = i + 1;
+				}
+				else {
+					runs.push_back(std::make_pair(i, i + 1));
+				}
+			}
+
+			w.put_bytes(self::MAGIC, sizeof(self::MAGIC));
+			w.put_u32(self::VERSION);
+			w.put_u64(this->image);
+			w.put_u32(sizeof(self::cell_t));
+			w.put_u64(this->cells.size());
+			w.put_u64(this->num);
+			w.put_u32(this->pos);
+			w.put_u64(static_cast<boost::uint64_t>(this->in_offset));
+			w.put_u64(this->bytes_in);
+			w.put_u64(this->bytes_out);
+			w.put_u64(this->executed);
+			w.put_u64(this->back_edges);
+
+			w.put_u32(static_cast<boost::uint32_t>(this->loops.size()));
+			std::for_each(this->loops.begin(), this->loops.end(), [&w](boost::uint32_t x)->void {
+					w.put_u32(x);
+				});
+
+			w.put_u64(runs.size());
+			std::for_each(runs.begin(), runs.end(), [this, &w](auto const& x)->void {
+					w.put_u64(x.first);
+					w.put_u64(x.second - x.first);
+					w.put_bytes(&this->cells[x.first], x.second - x.first);
+				});
+
+			if(!w.save(filename)) {
+				throw CheckpointGraphicMachineException();
+			}
+		}
+
+		/// @brief
+		///
+		///
+		void load(std::string const& filename) {
+			utils::BinaryReader r;
+			char magic[sizeof(self::MAGIC)];
+
+			if(!r.load(filename) ||
+			   !r.get_bytes(magic, sizeof(magic)) ||
+			   std::memcmp(magic, self::MAGIC, sizeof(magic)) ||
+			   r.get_u32() != self::VERSION) {
+				throw CheckpointGraphicMachineException();
+			}
+
+			boost::uint64_t const image = r.get_u64();
+
+			if(r.get_u32() != sizeof(self::cell_t)) {
+				throw CheckpointGraphicMachineException();
+			}
+
+			this->reset(r.get_u64());
+			this->image = image;
+			this->num = r.get_u64();
+			this->pos = r.get_u32();
+			this->in_offset = static_cast<boost::int64_t>(r.get_u64());
+			this->bytes_in = r.get_u64();
+			this->bytes_out = r.get_u64();
+			this->executed = r.get_u64();
+			this->back_edges = r.get_u64();
+
+			for(boost::uint32_t i = 0, n = r.get_u32(); i < n && r.good(); i++) {
+				this->loops.push_back(r.get_u32());
+			}
+
+			for(boost::uint64_t i = 0, n = r.get_u64(); i < n && r.good(); i++) {
+				boost::uint64_t const first = r.get_u64();
+				boost::uint64_t const size = r.get_u64();
+
+				if(first > this->cells.size() || size > this->cells.size() - first ||
+				   !r.get_bytes(&this->cells[first], size)) {
+					throw CheckpointGraphicMachineException();
+				}
+			}
+
+			if(!r.good() || this->num >= this->cells.size()) {
+				throw CheckpointGraphicMachineException();
+			}
+		}
+	private:
+		static char const MAGIC[4];
+		static boost::uint32_t const VERSION;
+		static self::index_t const RUN_GAP;
+	};
+
+	char const MachineState::MAGIC[4] = {'B', 'L', 'S', 'T'};
+	boost::uint32_t const MachineState::VERSION = 2;
+	MachineState::index_t const MachineState::RUN_GAP = 16;
+
+	/// @brief Policy of the tape of the interpretator: moves of the head aren't checked
+	///
+	///
+	struct UncheckedTape {
+		static inline void next(MachineState& s) {
+			s.num++;
+		}
+
+		static inline void prev(MachineState& s) {
+			s.num--;
+		}
+
+		static inline MachineState::cell_t& cell(MachineState& s) {
+			return s.cells[s.num];
+		}
+	};
+
+	/// @brief Policy of the tape of the interpretator: every access is checked
+	///
+	/// @note The head may leave the tape and come back, as in the compiled engines (moves
+	///       are folded there): only an access out of the tape stops the program.
+	struct CheckedTape {
+		static inline void next(MachineState& s) {
+			s.num++;
+		}
+
+		static inline void prev(MachineState& s) {
+			s.num--;
+		}
+
+		static inline MachineState::cell_t& cell(MachineState& s) {
+			if(s.num >= s.cells.size()) {
+				throw TapeBoundsGraphicMachineException();
+			}
+
+			return s.cells[s.num];
+		}
+	};
+
+	/// @brief Back-edges of one run of the shadow execution (see ShadowVerifier)
+	///
+	/// @note Events are back-edges of the loops which stay loops in the decoded program
+	///       (not cleared, multiplied or removed): every engine passes them in the same order
+	///       with the same tape, whatever else was optimized. Events of the window are
+	///       sampled once per interval with the checksum of the whole tape.
+	class ShadowTrace {
+		typedef ShadowTrace self;
+	public:
+		/// @brief
+		///
+		///
+		struct sample_t {
+			boost::uint64_t event;
+			boost::uint32_t pos;       // Source position of the loop ('[')
+			boost::uint64_t num;       // Cell of its ']'
+			boost::uint64_t tape;      // Checksum of the tape
+			boost::uint64_t bytes_out;
+
+			bool same(sample_t const& x) const {
+				return this->event == x.event && this->pos == x.pos && this->num == x.num &&
+					this->tape == x.tape && this->bytes_out == x.bytes_out;
+			}
+		};
+
+		/// @brief
+		///
+		/// @note The tape is copied at the event 'snapshot' (or at the end of the run if
+		///       there is no such event).
+		ShadowTrace(std::vector<bool> const& raw_loops, boost::uint64_t raw_interval,
+					boost::uint64_t raw_from = 0,
+					boost::uint64_t raw_to = std::numeric_limits<boost::uint64_t>::max(),
+					boost::uint64_t raw_snapshot = std::numeric_limits<boost::uint64_t>::max()) :
+			loops(raw_loops), interval(std::max<boost::uint64_t>(raw_interval, 1)), from(raw_from), to(raw_to),
+			snapshot(raw_snapshot), events(0), skipped(0), samples(), tape(), final_tape(0), final_bytes_out(0) {}
+
+		/// @brief
+		///
+		///
+		virtual ~ShadowTrace(void) noexcept {}
+
+		/// @brief Count the events which the engine didn't pass itself (see ProgramPrefix)
+		///
+		///
+		void skip(boost::uint64_t count) {
+			this->events += count;
+			this->skipped = this->events;
+		}
+
+		/// @brief The back-edge of the loop at the source position (s.num is the cell of its ']')
+		///
+		/// @note The reference engine jumps back on the last iteration too: such edges are not
+		///       events (the cell is zero).
+		void back_edge(MachineState const& s, boost::uint32_t pos) {
+			if(pos >= this->loops.size() || !this->loops[pos] || s.num >= s.cells.size() || !s.cells[s.num]) {
+				return;
+			}
+
+			boost::uint64_t const event = ++this->events;
+
+			if(event > this->from && event <= this->to && !(event % this->interval)) {
+				this->samples.push_back(sample_t{event, pos, s.num, utils::fnv1a(s.cells.data(), s.cells.size()),
+												 s.bytes_out});
+			}
+
+			if(event == this->snapshot) {
+				this->tape.assign(s.cells.begin(), s.cells.end());
+			}
+		}
+
+		/// @brief The end of the run (normal or not)
+		///
+		///
+		void finish(MachineState const& s) {
+			this->final_tape = utils::fnv1a(s.cells.data(), s.cells.size());
+			this->final_bytes_out = s.bytes_out;
+
+			if(this->snapshot > this->events) {
+				this->tape.assign(s.cells.begin(), s.cells.end());
+			}
+		}
+
+		std::vector<bool> loops;                // Loops of events by position of '['
+		boost::uint64_t interval;
+		boost::uint64_t from;                   // Window of sampled events: (from, to]
+		boost::uint64_t to;
+		boost::uint64_t snapshot;
+		boost::uint64_t events;
+		boost::uint64_t skipped;                // Events up to this one were not sampled
+		std::vector<sample_t> samples;
+		std::vector<MachineState::cell_t> tape; // The tape at the snapshot
+		boost::uint64_t final_tape;
+		boost::uint64_t final_bytes_out;
+	};
+
+	/// @brief Recording of one run: the program, its options, the input and the result
+	///        (see --record and --replay)
+	///
+	/// @note Every read is kept with the count of instructions at which it was done: a replay
+	///       is checked read by read (every engine counts instructions in the same way).
+	///       Checksums of the tape are samples of ShadowTrace: they are the same for every engine.
+	class RunRecorder {
+		typedef RunRecorder self;
+	public:
+		/// @brief
+		///
+		///
+		struct read_t {
+			boost::uint64_t executed;
+			boost::int32_t value;     // -1 - the end of the input
+		};
+
+		/// @brief
+		///
+		///
+		RunRecorder(void) :
+			image(0), engine(), output_type(), cell_size(0), tape_size(0), checked(false), max_instructions(0),
+			max_time(0), hang_check(false), prefix_budget(0), jit_threshold(0), interval(0),
+			trace(std::vector<bool>(), 0), status(EXIT_SUCCESS), executed(0), back_edges(0), bytes_in(0),
+			bytes_out(0), final_tape(0), reads(), count(0), last(0) {}
+
+		/// @brief
+		///
+		///
+		virtual ~RunRecorder(void) noexcept {}
+
+		/// @brief One read of the program: the value or -1 (the end of the input)
+		///
+		/// @note Two bytes per read usually: the count of instructions from the previous
+		///       read (the lowest bit - the end of the input) and the value.
+		void read(MachineState const& s, boost::int32_t value) {
+			boost::uint64_t const delta = s.executed - this->last;
+
+			this->reads.put_varint((delta << 1) | ((value < 0) ? 1 : 0));
+			if(value >= 0) {
+				this->reads.put_u8(static_cast<boost::uint8_t>(value));
+			}
+
+			this->last = s.executed;
+			this->count++;
+		}
+
+		/// @brief The end of the run (normal or not)
+		///
+		///
+		void finish(MachineState const& s) {
+			this->executed = s.executed;
+			this->back_edges = s.back_edges;
+			this->bytes_in = s.bytes_in;
+			this->bytes_out = s.bytes_out;
+			this->final_tape = utils::fnv1a(s.cells.data(), s.cells.size());
+		}
+
+		/// @brief
+		///
+		///
+		std::vector<self::read_t> get_reads(void) const {
+			utils::BinaryReader r(this->reads.data());
+			std::vector<self::read_t> result;
+			boost::uint64_t executed = 0;
+
+			result.reserve(static_cast<std::size_t>(std::min<boost::uint64_t>(this->count, this->reads.data().size())));
+			for(boost::uint64_t i = 0; i < this->count && r.good(); i++) {
+				boost::uint64_t const x = r.get_varint();
+
+				executed += x >> 1;
+				result.push_back(self::read_t{executed, (x & 1) ? -1 : static_cast<boost::int32_t>(r.get_u8())});
+			}
+
+			return result;
+		}
+
+		/// @brief Values of the input in the order of reads (up to its end)
+		///
+		///
+		std::string get_input(void) const {
+			std::vector<self::read_t> const r = this->get_reads();
+			std::string result;
+
+			for(std::size_t i = 0; i < r.size() && r[i].value >= 0; i++) {
+				result.push_back(static_cast<char>(r[i].value));
+			}
+
+			return result;
+		}
+
+		/// @brief
+		///
+		///
+		bool save(std::string const& filename) const {
+			utils::BinaryWriter w;
+			std::vector<boost::uint32_t> loops;
+
+			for(std::size_t i = 0; i < this->trace.loops.size(); i++) {
+				if(this->trace.loops[i]) {
+					loops.push_back(static_cast<boost::uint32_t>(i));
+				}
+			}
+
+			w.put_bytes(self::MAGIC, sizeof(self::MAGIC));
+			w.put_u32(self::VERSION);
+			w.put_u64(this->image);
+			self::put_string(w, this->engine);
+			self::put_string(w, this->output_type);
+			w.put_u32(this->cell_size);
+			w.put_u64(this->tape_size);
+			w.put_u8(this->checked);
+			w.put_u64(this->max_instructions);
+			w.put_u64(this->max_time);
+			w.put_u8(this->hang_check);
+			w.put_u64(this->prefix_budget);
+			w.put_u32(this->jit_threshold);
+			w.put_u64(this->interval);
+
+			w.put_u32(static_cast<boost::uint32_t>(this->trace.loops.size()));
+			w.put_u32(static_cast<boost::uint32_t>(loops.size()));
+			std::for_each(loops.begin(), loops.end(), [&w](boost::uint32_t x)->void {
+					w.put_u32(x);
+				});
+
+			w.put_u64(this->count);
+			w.put_u64(this->reads.data().size());
+			w.put_bytes(this->reads.data().data(), this->reads.data().size());
+
+			w.put_u64(this->trace.events);
+			w.put_u64(this->trace.skipped);
+			w.put_u64(this->trace.samples.size());
+			std::for_each(this->trace.samples.begin(), this->trace.samples.end(), [&w](ShadowTrace::sample_t const& x)->void {
+					w.put_u64(x.event);
+					w.put_u32(x.pos);
+					w.put_u64(x.num);
+					w.put_u64(x.tape);
+					w.put_u64(x.bytes_out);
+				});
+
+			w.put_u32(static_cast<boost::uint32_t>(this->status));
+			w.put_u64(this->executed);
+			w.put_u64(this->back_edges);
+			w.put_u64(this->bytes_in);
+			w.put_u64(this->bytes_out);
+			w.put_u64(this->final_tape);
+
+			return w.save(filename);
+		}
+
+		/// @brief
+		///
+		/// @note Returns false if the file is not a recording (or it is damaged).
+		bool load(std::string const& filename) {
+			utils::BinaryReader r;
+			char magic[sizeof(self::MAGIC)];
+
+			if(!r.load(filename) ||
+			   !r.get_bytes(magic, sizeof(magic)) ||
+			   std::memcmp(magic, self::MAGIC, sizeof(magic)) ||
+			   r.get_u32() != self::VERSION) {
+				return false;
+			}
+
+			this->image = r.get_u64();
+			this->engine = self::get_bytes(r, r.get_u32());
+			this->output_type = self::get_bytes(r, r.get_u32());
+			this->cell_size = r.get_u32();
+			this->tape_size = r.get_u64();
+			this->checked = (r.get_u8() != 0);
+			this->max_instructions = r.get_u64();
+			this->max_time = r.get_u64();
+			this->hang_check = (r.get_u8() != 0);
+			this->prefix_budget = r.get_u64();
+			this->jit_threshold = r.get_u32();
+			this->interval = r.get_u64();
+
+			std::vector<bool> loops(r.get_u32(), false);
+
+			for(boost::uint32_t i = 0, n = r.get_u32(); i < n && r.good(); i++) {
+				boost::uint32_t const x = r.get_u32();
+
+				if(x >= loops.size()) {
+					return false;
+				}
+				loops[x] = true;
+			}
+			this->trace = ShadowTrace(loops, this->interval);
+
+			this->count = r.get_u64();
+			this->reads = utils::BinaryWriter();
+
+			std::string const reads = self::get_bytes(r, r.get_u64());
+
+			this->reads.put_bytes(reads.data(), reads.size());
+
+			this->trace.events = r.get_u64();
+			this->trace.skipped = r.get_u64();
+			for(boost::uint64_t i = 0, n = r.get_u64(); i < n && r.good(); i++) {
+				ShadowTrace::sample_t x;
+
+				x.event = r.get_u64();
+				x.pos = r.get_u32();
+				x.num = r.get_u64();
+				x.tape = r.get_u64();
+				x.bytes_out = r.get_u64();
+				this->trace.samples.push_back(x);
+			}
+
+			this->status = static_cast<int>(r.get_u32());
+			this->executed = r.get_u64();
+			this->back_edges = r.get_u64();
+			this->bytes_in = r.get_u64();
+			this->bytes_out = r.get_u64();
+			this->final_tape = r.get_u64();
+
+			return r.good() && r.done() && this->get_reads().size() == this->count;
+		}
+
+		/// @brief Was the run stopped by a limit (instructions, time, the hang check)?
+		///
+		///
+		bool stopped(void) const {
+			return self::is_limit(this->status);
+		}
+
+		/// @brief The instruction limit of the replay: a stopped run stops on the same back-edge
+		///
+		/// @note The limit is checked on back-edges as "executed > limit", the counter grows
+		///       between them: the back-edge of the stop is the first one over executed - 1.
+		boost::uint64_t replay_limit(void) const {
+			return (this->stopped()) ? this->executed - 1 : this->max_instructions;
+		}
+
+		/// @brief Compare the replay with the recording and write the report
+		///
+		/// @note Returns EXIT_SUCCESS or EXIT_DIVERGED. The replay of a run stopped by a limit
+		///       stops by the instruction limit (see replay_limit); the tape of a run which left
+		///       it is not compared.
+		int compare(self const& r, std::string const& name, std::ostream& report) const {
+			std::vector<self::read_t> const a = this->get_reads();
+			std::vector<self::read_t> const b = r.get_reads();
+			bool const limited = this->stopped();
+			bool const partial = (this->status == EXIT_TAPE_BOUNDS && r.status == EXIT_TAPE_BOUNDS);
+			int const status = (limited) ? EXIT_INSTRUCTION_LIMIT : this->status;
+			// RU: Ребро остановки по времени уже посчитано, по числу инструкций - нет (см. check_limits)
+			boost::uint64_t const back_edges = this->back_edges - ((limited && this->status != EXIT_INSTRUCTION_LIMIT) ? 1 : 0);
+			std::size_t const n = std::min(a.size(), b.size());
+			std::size_t k = 0;
+			std::string const title = name + " (recorded by " + this->engine + ", replayed by " + r.engine + ")";
+
+			while(k < n && a[k].value == b[k].value && a[k].executed == b[k].executed) {
+				k++;
+			}
+
+			if(k < n || a.size() != b.size()) {
+				report << "DIVERGED " << title << std::endl;
+				report << "\tread #" << k << ": recorded " << self::describe(a, k) << ", replayed "
+					   << self::describe(b, k) << std::endl;
+				return EXIT_DIVERGED;
+			}
+
+			// RU: События внутри префикса одного из движков не сравниваются (см. ShadowVerifier)
+			std::vector<ShadowTrace::sample_t> const x = self::samples(this->trace, r.trace.skipped);
+			std::vector<ShadowTrace::sample_t> const y = self::samples(r.trace, this->trace.skipped);
+			std::size_t const m = std::min(x.size(), y.size());
+			std::size_t j = 0;
+
+			while(j < m && x[j].same(y[j])) {
+				j++;
+			}
+
+			if(j < m || (!partial && (x.size() != y.size() || this->trace.events != r.trace.events))) {
+				report << "DIVERGED " << title << std::endl;
+				report << "\tchecksum #" << j << ": recorded " << self::describe(x, j) << ", replayed "
+					   << self::describe(y, j) << std::endl;
+				return EXIT_DIVERGED;
+			}
+
+			if(status != r.status || this->bytes_out != r.bytes_out || this->executed != r.executed ||
+			   back_edges != r.back_edges || (!partial && this->final_tape != r.final_tape)) {
+				report << "DIVERGED " << title << std::endl;
+				report << "\tend: recorded " << self::describe(*this) << ", replayed " << self::describe(r) << std::endl;
+				return EXIT_DIVERGED;
+			}
+
+			report << "OK " << title << ": " << a.size() << " reads, " << x.size() << " checksums, "
+				   << r.executed << " instructions" << std::endl;
+			return EXIT_SUCCESS;
+		}
+
+		// Options of the run
+		boost::uint64_t image;            // Hash of the image (see IIteratorMachine::get_hash)
+		std::string engine;
+		std::string output_type;
+		boost::uint32_t cell_size;
+		boost::uint64_t tape_size;
+		bool checked;
+		boost::uint64_t max_instructions;
+		boost::uint64_t max_time;
+		bool hang_check;
+		boost::uint64_t prefix_budget;
+		boost::uint32_t jit_threshold;
+		boost::uint64_t interval;         // Back-edges between checksums (zero - no checksums)
+		ShadowTrace trace;                // Checksums of the tape
+
+		// Result of the run
+		int status;
+		boost::uint64_t executed;
+		boost::uint64_t back_edges;
+		boost::uint64_t bytes_in;
+		boost::uint64_t bytes_out;
+		boost::uint64_t final_tape;
+	private:
+		static void put_string(utils::BinaryWriter& w, std::string const& value) {
+			w.put_u32(static_cast<boost::uint32_t>(value.size()));
+			w.put_bytes(value.data(), value.size());
+		}
+
+		/// @brief
+		///
+		/// @note The size is checked before the allocation: the file may be damaged.
+		static std::string get_bytes(utils::BinaryReader& r, boost::uint64_t size) {
+			if(size > r.left()) {
+				r.get_bytes(nullptr, r.left() + 1); // RU: Сбрасывает good()
+				return std::string();
+			}
+
+			std::string value(static_cast<std::size_t>(size), '\0');
+
+			r.get_bytes(&value[0], value.size());
+
+			return value;
+		}
+
+		static bool is_limit(int status) {
+			return status == EXIT_INSTRUCTION_LIMIT || status == EXIT_TIME_LIMIT || status == EXIT_INFINITE_LOOP;
+		}
+
+		/// @brief Samples of the trace after the event (the end of the prefix of the other run)
+		///
+		///
+		static std::vector<ShadowTrace::sample_t> samples(ShadowTrace const& t, boost::uint64_t skipped) {
+			std::vector<ShadowTrace::sample_t> result;
+
+			std::copy_if(t.samples.begin(), t.samples.end(), std::back_inserter(result),
+						 [&t, skipped](ShadowTrace::sample_t const& x)->bool {
+							 return x.event > std::max(t.skipped, skipped);
+						 });
+
+			return result;
+		}
+
+		static std::string describe(std::vector<self::read_t> const& r, std::size_t k) {
+			std::ostringstream oss;
+
+			if(k >= r.size()) {
+				oss << "no such read";
+			}
+			else if(r[k].value < 0) {
+				oss << "the end of the input at instruction " << r[k].executed;
+			}
+			else {
+				oss << "value " << r[k].value << " at instruction " << r[k].executed;
+			}
+
+			return oss.str();
+		}
+
+		static std::string describe(std::vector<ShadowTrace::sample_t> const& s, std::size_t k) {
+			std::ostringstream oss;
+
+			if(k >= s.size()) {
+				oss << "no such checksum";
+			}
+			else {
+				oss << "event " << s[k].event << " (loop at position " << s[k].pos << "), head " << s[k].num << ", "
+					<< s[k].bytes_out << " bytes, tape checksum " << std::hex << s[k].tape << std::dec;
+			}
+
+			return oss.str();
+		}
+
+		static std::string describe(self const& r) {
+			std::ostringstream oss;
+
+			oss << "status " << r.status << ", " << r.executed << " instructions, " << r.back_edges << " back-edges, "
+				<< r.bytes_out << " bytes, tape checksum " << std::hex << r.final_tape << std::dec;
+
+			return oss.str();
+		}
+
+		utils::BinaryWriter reads;        // Encoded reads (see read)
+		boost::uint64_t count;            // Number of reads
+		boost::uint64_t last;             // Instructions at the previous read
+
+		static char const MAGIC[4];
+		static boost::uint32_t const VERSION;
+	};
+
+	char const RunRecorder::MAGIC[4] = {'B', 'L', 'R', 'C'};
+	boost::uint32_t const RunRecorder::VERSION = 1;
+
+	/// @brief Set by SIGUSR1: write checkpoint on the nearest back-edge
+	///
+	///
+	volatile std::sig_atomic_t checkpoint_requested = 0;
+
+#if !defined(BRAINLOLLER_LIBRARY)
+	void checkpoint_signal_handler(int sig) {
+		UNUSED_SUPPRESSOR(sig);
+
+		checkpoint_requested = 1;
+	}
+#endif // !defined(BRAINLOLLER_LIBRARY)
+
+	/// @brief
+	///
+	/// @note Непосредственно машина интерпретатора. Является интерпретатором языка Брейнроллер,
+	///       однако, не все комманды реализованы. Комманды смены направления движения не
+	///       реализованы.
+	class GraphicMachine : public IMachine {
+		typedef GraphicMachine self;
+	protected:
+		typedef MachineState::cell_t cell_t;
+		typedef MachineState::index_t index_t;
+
+		typedef MachineState state_t;
+		typedef self::state_t& state_ref;
+		typedef self::state_t const& state_cref;
+
+		typedef std::chrono::steady_clock clock_type;
+	public:
+	
+		/// @brief
+		///
+		///
+		GraphicMachine(std::shared_ptr<IPrinter> p,
+					   std::shared_ptr<IIteratorMachine> m,
+					   OutputType o,
+					   MachineLimits const& l,
+					   CheckpointOptions const& c,
+					   TapeOptions const& t) :
+			printer(p),
+			im(m),
+			ot(o),
+			limits(l),
+			checkpoint(c),
+			tape(t),
+			streams(CONSOLE_STREAMS),
+			state(MachineState::allocator_t(t.allocation, t.numa)),
+			max_instructions(0),
+			deadline(),
+			next_checkpoint(),
+			resumed(false),
+			shadow(nullptr),
+			recorder(nullptr) {}
+
+		/// @brief
+		///
+		///
+		virtual ~GraphicMachine(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void init(void) {
+			this->im.get()->init();
+		}
+	
+		/// @brief
+		///
+		///
+		virtual void run(void) {
+			if(this->checkpoint.restore.empty()) {
+				this->resumed = false;
+				this->state.reset(this->tape_size());
+				if(!this->checkpoint.filename.empty()) {
+					this->state.image = this->im.get()->get_hash();
+				}
+				this->prepare(this->state);
+			}
+			else {
+				this->restore_checkpoint(this->state);
+			}
+
+			this->start_limits();
+			try {
+				tracing::Scope scope("execute");
+
+				this->interpretator(this->state);
+			}
+			catch(IMachineException const&) {
+				this->publish_counters();
+				if(this->shadow) {
+					this->shadow->finish(this->state);
+				}
+				if(this->recorder) {
+					this->recorder->finish(this->state);
+				}
+				throw;
+			}
+			this->publish_counters();
+			if(this->shadow) {
+				this->shadow->finish(this->state);
+			}
+			if(this->recorder) {
+				this->recorder->finish(this->state);
+			}
+
+			tracing::Scope scope("flush");
+
+			if(this->streams.console) {
+				*this->streams.out << std::endl;
+			}
+			else {
+				this->streams.out->flush();
+			}
+		}
+
+		/// @brief
+		///
+		///
+		virtual void print(std::ostream& os) {
+			// RU: Операции читаются и переводятся пачками в один буфер, который
+			//     переиспользуется: ни выделений памяти, ни вывода на каждую операцию.
+			tracing::Scope scope("print");
+			Operation ops[self::PRINT_CHUNK];
+			std::string buffer;
+
+			os << "BEGIN PROGRAM >>>>>>>>>>" << std::endl;
+			while(!this->im.get()->is_done()) {
+				boost::uint32_t const count = this->im.get()->read(ops, self::PRINT_CHUNK);
+
+				buffer.clear();
+				this->printer.get()->retranslate(ops, count, buffer);
+				os.write(buffer.data(), buffer.size());
+			}
+			os << std::endl;
+			os << "<<<<<<<<<< END PROGRAM" << std::endl;
+		}
+
+		/// @brief
+		///
+		///
+		virtual void set_streams(MachineStreams const& s) {
+			this->streams = s;
+		}
+
+		/// @brief Report back-edges to the trace (nullptr - stop)
+		///
+		///
+		void set_shadow(ShadowTrace* t) {
+			this->shadow = t;
+		}
+
+		/// @brief Record reads and the result of runs (nullptr - stop)
+		///
+		/// @note Checksums of the recording are taken by its trace (see set_shadow).
+		void set_recorder(RunRecorder* r) {
+			this->recorder = r;
+		}
+
+		/// @brief
+		///
+		/// @note The extent of the tape is found by the tape at the end (one past the last
+		///       non-zero cell or the current one): engines don't track it.
+		virtual tracing::counters_t get_counters(void) const {
+			tracing::counters_t counters = tracing::counters_t();
+			self::state_cref s = this->state;
+			self::index_t extent = s.cells.size();
+
+			while(extent && !s.cells[extent - 1]) {
+				extent--;
+			}
+
+			counters.valid = true;
+			counters.executed = s.executed;
+			counters.back_edges = s.back_edges;
+			counters.bytes_in = s.bytes_in;
+			counters.bytes_out = s.bytes_out;
+			counters.tape_extent = std::max<boost::uint64_t>(extent, (s.num < s.cells.size()) ? s.num + 1 : 0);
+
+			return counters;
+		}
+	protected:
+		/// @brief Hook of the production interpretator: nothing is called before instructions
+		///
+		///
+		struct no_hook {
+			inline void operator()(self::state_ref, boost::uint32_t) const {}
+		};
+
+		/// @brief Output through the virtual output() of the machine
+		///
+		///
+		struct virtual_output {
+			self* machine;
+
+			inline void operator()(self::cell_t value) const {
+				this->machine->output(value);
+			}
+		};
+
+		virtual void interpretator(self::state_ref s) {
+			self::no_hook hook;
+
+			this->execute(s, hook);
+		}
+
+		/// @brief The interpretator with the iterator and the output of the machine (virtual calls)
+		///
+		///
+		template<typename HOOK>
+		void execute(self::state_ref s, HOOK& hook) {
+			self::virtual_output out = {this};
+
+			if(this->tape.checked) {
+				this->execute<CheckedTape>(s, *this->im.get(), out, hook);
+			}
+			else {
+				this->execute<UncheckedTape>(s, *this->im.get(), out, hook);
+			}
+		}
+
+		/// @brief The interpretator itself; hook(state, block_begin) is called before every
+		///        instruction (the position is in the iterator)
+		///
+		/// @note With no_hook the call is inlined into nothing, the debugger (see
+		///       DebugGraphicMachine) is another instantiation of this template. With the final
+		///       iterator class and the output policy there are no indirect calls at all (see
+		///       StaticGraphicMachine).
+		template<typename TAPE, typename ITERATOR, typename OUTPUT, typename HOOK>
+		void execute(self::state_ref s, ITERATOR& it, OUTPUT& out, HOOK& hook) {
+			// RU: Счётчик инструкций увеличивается не на каждой инструкции, а сразу на длину
+			//     линейного участка (basic block) - при переходе через '[' или ']'.
+			//     После восстановления машина стоит на '[' после обратного перехода.
+			boost::uint32_t block_begin = it.get_cur_pos() + ((this->resumed) ? 1 : 0);
+
+			while(!it.is_done()) {
+				hook(s, block_begin);
+
+				Operation op = it.get_next();
+				
+				switch(op) {
+				case OP_INC_CELL:
+					TAPE::cell(s)++;
+					break;
+				case OP_DEC_CELL:
+					TAPE::cell(s)--;
+					break;
+				case OP_NEXT_CELL:
+					TAPE::next(s);
+					break;
+				case OP_PREV_CELL:
+					TAPE::prev(s);
+					break;
+				case OP_READ:
+					this->input(TAPE::cell(s));
+					s.bytes_in++;
+					break;
+				case OP_WRITE:
+					out(TAPE::cell(s));
+					s.bytes_out++;
+					break;
+				case OP_BEGIN_LOOP:
+					s.executed += it.get_cur_pos() - block_begin;
+
+					if(!TAPE::cell(s)) {
+						// Skip the loop body with all nested loops
+						boost::uint32_t depth = 1;
+
+						while(depth && !it.is_done()) {
+							op = it.get_next();
+
+							if(op == OP_BEGIN_LOOP) {
+								depth++;
+							}
+							else if(op == OP_END_LOOP) {
+								depth--;
+							}
+						}
+
+						if(depth) {
+							throw UnexpectedEndOfProgrammGraphicMachineException();
+						}
+					}
+					else {
+						if(it.get_cur_pos()) {
+							s.loops.push_back(it.get_cur_pos() - 1);
+						}
+						else {
+							throw ShitHappendGraphicMachineException();
+						}
+					}
+
+					block_begin = it.get_cur_pos();
+					break;
+				case OP_END_LOOP:
+					if(s.loops.empty()) {
+						throw UnexpectedOperationGraphicMachineException();
+					}
+					else {
+						boost::uint32_t const loop = s.loops.back();
+
+						s.executed += it.get_cur_pos() - block_begin;
+						block_begin = it.get_cur_pos();
+						s.loops.pop_back();
+
+						if(TAPE::cell(s)) {
+							// RU: Переход назад - на '[' цикла, она уже учтена и не считается снова
+							it.set_cur_pos(loop);
+							block_begin = loop + 1;
+							this->check_limits(s);
+						}
+					}
+					break;
+				case OP_ROTATE_CLOCKWISE:
+				case OP_ROTATE_COUNTER_CLOCKWISE:
+					// RU: Поворот уже учтён итератором при обходе изображения
+					break;
+				case OP_UNKNOWN:
+					throw UnknownOperationGraphicMachineException();
+				default:
+					throw UnsupportOperationGraphicMachineException();
+				};
+			}
+
+			s.executed += it.get_cur_pos() - block_begin;
+		}
+
+		/// @brief Give counters of the run to statistics (see --stats)
+		///
+		///
+		void publish_counters(void) const {
+			if(tracing::stats) {
+				tracing::counters = this->get_counters();
+			}
+		}
+
+		/// @brief Prepare the instruction budget, the deadline and the checkpoint timer
+		///
+		/// @note The instruction budget covers the whole computation (with the part before
+		///       the restored checkpoint), the time limit covers the current process only.
+		void start_limits(void) {
+			this->max_instructions = (this->limits.max_instructions) ?
+				this->limits.max_instructions : std::numeric_limits<boost::uint64_t>::max();
+			this->deadline = clock_type::now() + std::chrono::milliseconds(this->limits.max_time);
+			this->next_checkpoint = clock_type::now() + std::chrono::seconds(this->checkpoint.interval);
+		}
+
+		/// @brief
+		///
+		///
+		self::index_t tape_size(void) const {
+			return (this->tape.size) ? this->tape.size : self::TAPE_SIZE;
+		}
+
+		/// @brief Check limits on back-edge of loop
+		///
+		/// @note The clock and the checkpoint request are checked once per
+		///       TIME_CHECK_MASK + 1 back-edges only.
+		inline void check_limits(self::state_ref s) {
+			if(this->shadow) {
+				this->shadow->back_edge(s, this->loop_position());
+			}
+
+			if(s.executed > this->max_instructions) {
+				this->streams.out->flush();
+				throw InstructionLimitGraphicMachineException();
+			}
+
+			if(!(++s.back_edges & self::TIME_CHECK_MASK)) {
+				this->check_time(s);
+			}
+		}
+
+		/// @brief
+		///
+		///
+		void check_time(self::state_ref s) {
+			if(this->limits.hang_check) {
+				this->check_hang(s);
+			}
+
+			if(this->limits.max_time || this->checkpoint.interval) {
+				clock_type::time_point const now = clock_type::now();
+
+				if(this->limits.max_time && now > this->deadline) {
+					this->streams.out->flush();
+					throw TimeLimitGraphicMachineException();
+				}
+
+				if(this->checkpoint.interval && now >= this->next_checkpoint) {
+					this->next_checkpoint = now + std::chrono::seconds(this->checkpoint.interval);
+					checkpoint_requested = 1;
+				}
+			}
+
+			if(checkpoint_requested && !this->checkpoint.filename.empty()) {
+				checkpoint_requested = 0;
+				this->save_checkpoint(s);
+			}
+		}
+
+		/// @brief Write the state; the output is flushed, so it matches the counters
+		///
+		///
+		void save_checkpoint(self::state_ref s) {
+			this->streams.out->flush();
+
+			this->sync_state(s);
+			s.in_offset = static_cast<boost::int64_t>(this->streams.in->tellg());
+			s.save(this->checkpoint.filename);
+		}
+
+		/// @brief Load the state and move the engine and the input to the saved positions
+		///
+		/// @note The state of another image (or of the image changed since) is refused.
+		void restore_checkpoint(self::state_ref s) {
+			s.load(this->checkpoint.restore);
+
+			if(s.image != this->im.get()->get_hash()) {
+				throw CheckpointGraphicMachineException();
+			}
+
+			this->seek(s);
+			this->resumed = true;
+
+			if(s.in_offset > 0) {
+				this->streams.in->seekg(s.in_offset);
+			}
+		}
+
+		/// @brief Start of a new run (not restored from checkpoint)
+		///
+		///
+		virtual void prepare(self::state_ref s) {
+			UNUSED_SUPPRESSOR(s);
+		}
+
+		/// @brief Store the position of the engine into the state (before checkpoint)
+		///
+		///
+		virtual void sync_state(self::state_ref s) {
+			s.pos = this->im.get()->get_cur_pos();
+		}
+
+		/// @brief Source position of the loop of the current back-edge ('[')
+		///
+		/// @note The iterator is already moved back to the start of the loop.
+		virtual boost::uint32_t loop_position(void) const {
+			return this->im.get()->get_cur_pos();
+		}
+
+		/// @brief Move the engine to the position of the state (after restore)
+		///
+		/// @note The state is at '[' after the back-edge, the '[' is counted already.
+		virtual void seek(self::state_ref s) {
+			if(s.pos > this->im.get()->get_size()) {
+				throw CheckpointGraphicMachineException();
+			}
+
+			this->im.get()->set_cur_pos(s.pos);
+		}
+
+		/// @brief Stop the run if the current loop provably never ends (see --hang-check)
+		///
+		/// @note Called with the clock; the reference engine doesn't look for infinite loops.
+		virtual void check_hang(self::state_ref s) {
+			UNUSED_SUPPRESSOR(s);
+		}
+
+		/// @brief Read one value (at the end of the input the cell is not changed)
+		///
+		/// @note Not virtual: no engine reads the input in other way.
+		void input(self::cell_t& value) {
+			if(this->streams.console) {
+				*this->streams.out << "Enter one symbol and press <ENTER>: ";
+				*this->streams.in >> value;
+				if(this->recorder) {
+					this->recorder->read(this->state, (*this->streams.in) ? value : -1);
+				}
+				return;
+			}
+
+			std::istream::int_type const c = this->streams.in->get();
+			bool const end = std::istream::traits_type::eq_int_type(c, std::istream::traits_type::eof());
+
+			if(!end) {
+				value = static_cast<self::cell_t>(std::istream::traits_type::to_char_type(c));
+			}
+			if(this->recorder) {
+				this->recorder->read(this->state, (end) ? -1 : value);
+			}
+		}
+
+		virtual void output(self::cell_t value) {
+			this->output(&value, 1);
+		}
+
+		/// @brief Write many values by one write
+		///
+		///
+		virtual void output(self::cell_t const* values, std::size_t size) {
+			static char const digits[] = "0123456789ABCDEF";
+			std::string buffer;
+
+			for(std::size_t i = 0; i < size; i++) {
+				switch(this->ot) {
+				case OT_CHAR:
+					buffer.push_back(static_cast<char>(values[i]));
+					break;
+				case OT_HEX:
+					buffer.push_back(digits[values[i] >> 4]);
+					buffer.push_back(digits[values[i] & 0x0F]);
+					break;
+				case OT_BOTH:
+					buffer.push_back(static_cast<char>(values[i]));
+					buffer.push_back('[');
+					buffer.push_back(digits[values[i] >> 4]);
+					buffer.push_back(digits[values[i] & 0x0F]);
+					buffer.push_back(']');
+					break;
+				case OT_NULL:
+				default:
+					break;
+				};
+			}
+
+			this->streams.out->write(buffer.data(), buffer.size());
+		}
+
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> im;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
+		MachineStreams streams;
+		self::state_t state;
+		boost::uint64_t max_instructions;
+		clock_type::time_point deadline;
+		clock_type::time_point next_checkpoint;
+		bool resumed;           // The run continues from the checkpoint
+		ShadowTrace* shadow;
+		RunRecorder* recorder;
+
+		static self::index_t const TAPE_SIZE;
+		static boost::uint64_t const TIME_CHECK_MASK;
+		static boost::uint32_t const PRINT_CHUNK = 4096; // Operations per one call of printer
+	};
+
+	GraphicMachine::index_t const GraphicMachine::TAPE_SIZE = 30000;
+	boost::uint64_t const GraphicMachine::TIME_CHECK_MASK = 0x3FF;
+
+	/// @brief Policies of the output of StaticGraphicMachine (see OutputType)
+	///
+	/// @note Values are put into the buffer of the stream of the machine directly, as
+	///       GraphicMachine::output writes them.
+	struct NullOutput {
+		std::ostream* os;
+
+		inline void operator()(MachineState::cell_t value) const {
+			UNUSED_SUPPRESSOR(value);
+		}
+	};
+
+	struct CharOutput {
+		std::ostream* os;
+
+		inline void operator()(MachineState::cell_t value) const {
+			this->os->put(static_cast<char>(value));
+		}
+	};
+
+	struct HexOutput {
+		std::ostream* os;
+
+		inline void operator()(MachineState::cell_t value) const {
+			this->os->put(DIGITS[value >> 4]);
+			this->os->put(DIGITS[value & 0x0F]);
+		}
+
+		static char const DIGITS[17];
+	};
+
+	char const HexOutput::DIGITS[17] = "0123456789ABCDEF";
+
+	struct BothOutput {
+		std::ostream* os;
+
+		inline void operator()(MachineState::cell_t value) const {
+			this->os->put(static_cast<char>(value));
+			this->os->put('[');
+			this->os->put(HexOutput::DIGITS[value >> 4]);
+			this->os->put(HexOutput::DIGITS[value & 0x0F]);
+			this->os->put(']');
+		}
+	};
+
+	/// @brief The reference engine composed at compile time
+	///
+	/// @note The iterator is the concrete (final) class, so its calls are inlined; the output
+	///       and the tape are policies. The hot loop has neither virtual calls nor shared_ptr.
+	///       The instantiation is chosen once, by GraphicMachineCreator (see STATIC_MACHINES).
+	template<typename ITERATOR, typename OUTPUT, typename TAPE>
+	class StaticGraphicMachine : public GraphicMachine {
+		typedef StaticGraphicMachine<ITERATOR, OUTPUT, TAPE> self;
+		typedef GraphicMachine parent;
+	public:
+		/// @brief
+		///
+		/// @note The iterator must be ITERATOR (checked by the creator).
+		StaticGraphicMachine(std::shared_ptr<IPrinter> p,
+							 std::shared_ptr<IIteratorMachine> m,
+							 OutputType o,
+							 MachineLimits const& l,
+							 CheckpointOptions const& c,
+							 TapeOptions const& t) :
+			parent(p, m, o, l, c, t),
+			iterator(static_cast<ITERATOR&>(*m.get())) {}
+
+		/// @brief
+		///
+		///
+		virtual ~StaticGraphicMachine(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		static std::shared_ptr<IMachine> create(std::shared_ptr<IPrinter> p,
+												std::shared_ptr<IIteratorMachine> m,
+												OutputType o,
+												MachineLimits const& l,
+												CheckpointOptions const& c,
+												TapeOptions const& t) {
+			return std::make_shared<self>(p, m, o, l, c, t);
+		}
+	protected:
+		virtual void interpretator(parent::state_ref s) {
+			parent::no_hook hook;
+			OUTPUT out = {this->streams.out};
+
+			this->template execute<TAPE>(s, this->iterator, out, hook);
+		}
+
+		ITERATOR& iterator; // The same object as im
+	};
+
+	/// @brief Instantiation of StaticGraphicMachine for the iterator, the output type and the tape
+	///
+	///
+	struct static_machine_t {
+		std::type_info const& iterator;
+		OutputType ot;
+		bool checked;
+		std::shared_ptr<IMachine> (*create)(std::shared_ptr<IPrinter>,
+											std::shared_ptr<IIteratorMachine>,
+											OutputType,
+											MachineLimits const&,
+											CheckpointOptions const&,
+											TapeOptions const&);
+	};
+
+	// RU: Новый итератор или вид вывода - новые строки таблицы
+	static_machine_t const STATIC_MACHINES[] = {
+		{typeid(GraphicIteratorMachine), OT_NULL, false, &StaticGraphicMachine<GraphicIteratorMachine, NullOutput, UncheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_CHAR, false, &StaticGraphicMachine<GraphicIteratorMachine, CharOutput, UncheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_HEX,  false, &StaticGraphicMachine<GraphicIteratorMachine, HexOutput, UncheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_BOTH, false, &StaticGraphicMachine<GraphicIteratorMachine, BothOutput, UncheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_NULL, true,  &StaticGraphicMachine<GraphicIteratorMachine, NullOutput, CheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_CHAR, true,  &StaticGraphicMachine<GraphicIteratorMachine, CharOutput, CheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_HEX,  true,  &StaticGraphicMachine<GraphicIteratorMachine, HexOutput, CheckedTape>::create},
+		{typeid(GraphicIteratorMachine), OT_BOTH, true,  &StaticGraphicMachine<GraphicIteratorMachine, BothOutput, CheckedTape>::create}
+	};
+
+
+	/// @brief Detector of infinite loops of the decoded program (see --hang-check)
+	///
+	/// @note Only loops without moves and I/O are checked: all their iterations work on
+	///       the same window of cells, so the window is the whole state of the loop. The
+	///       window is hashed on sampled back-edges and compared with the saved one by
+	///       Brent's method. The repeated state is proved by exact simulation on a copy of
+	///       the window: a loop which ends is never stopped.
+	class HangDetector {
+		typedef HangDetector self;
+	public:
+		typedef MachineState::cell_t cell_t;
+		typedef MachineState::index_t index_t;
+
+		/// @brief
+		///
+		///
+		HangDetector(void) : loops(), record(), samples(0), power(1) {}
+
+		/// @brief Find the loops which can be checked
+		///
+		///
+		void build(Program const& program) {
+			Program::code_t const& code = program.code;
+			std::vector<boost::uint32_t> stack;
+
+			this->loops.assign(code.size(), loop_t());
+			for(boost::uint32_t i = 0; i < code.size(); i++) {
+				if(code[i].opcode == IR_END && !stack.empty()) {
+					stack.pop_back();
+				}
+
+				if(code[i].opcode != IR_LOOP) {
+					continue;
+				}
+
+				self::loop_t& loop = this->loops[i];
+				boost::uint32_t const end = code[i].jump - 1;
+
+				loop.parent = (stack.empty()) ? self::NONE : stack.back();
+				loop.lo = loop.hi = code[i].offset;
+				loop.eligible = true;
+				for(boost::uint32_t j = i; j <= end && loop.eligible; j++) {
+					switch(code[j].opcode) {
+					case IR_ADD:
+					case IR_LOOP:
+					case IR_END:
+					case IR_CLEAR:
+					case IR_VADD:
+					case IR_MUL:
+					case IR_SOLVE:
+						BoundsChecker::span(program, code[j], loop.lo, loop.hi);
+						break;
+					default:
+						loop.eligible = false;
+						break;
+					}
+				}
+				loop.eligible = loop.eligible && loop.hi - loop.lo < self::MAX_WINDOW;
+				stack.push_back(i);
+			}
+			this->reset();
+		}
+
+		/// @brief Forget samples (before a new run)
+		///
+		///
+		void reset(void) {
+			this->record.valid = false;
+			this->samples = 0;
+			this->power = 1;
+		}
+
+		/// @brief Sample the state on back-edge of the loop (s.num is the cell of its ']')
+		///
+		/// @return The outermost loop which never ends or NONE
+		boost::uint32_t sample(Program const& program, MachineState const& s, boost::uint32_t loop) {
+			boost::uint32_t const outer = this->outermost(loop);
+
+			if(outer == self::NONE) {
+				return self::NONE;
+			}
+
+			self::loop_t const& window = this->loops[outer];
+			boost::int64_t const base = static_cast<boost::int64_t>(s.num) - program.code[program.code[loop].jump - 1].offset;
+
+			if(base + window.lo < 0 || base + window.hi >= static_cast<boost::int64_t>(s.cells.size())) {
+				return self::NONE;
+			}
+
+			cell_t const* const cells = s.cells.data() + base + window.lo;
+			std::size_t const size = static_cast<std::size_t>(window.hi - window.lo + 1);
+			boost::uint64_t const hash = utils::fnv1a(cells, size, utils::fnv1a(&base, sizeof(base)));
+			self::record_t const current = {true, loop, base, hash, s.bytes_in, s.bytes_out, s.back_edges};
+
+			if(this->record.valid && this->record.same(current)) {
+				boost::uint64_t const budget = std::min(s.back_edges - this->record.back_edges, self::MAX_SIMULATION);
+
+				this->reset();
+
+				return (self::simulate(program, outer, loop, cells, size, window.lo, budget)) ? outer : self::NONE;
+			}
+
+			if(!this->record.valid || ++this->samples == this->power) {
+				this->record = current;
+				this->samples = 0;
+				this->power = std::min<boost::uint64_t>(this->power * 2, self::MAX_POWER);
+			}
+
+			return self::NONE;
+		}
+
+		static boost::uint32_t const NONE;
+	private:
+		/// @brief
+		///
+		///
+		struct loop_t {
+			bool eligible;
+			boost::uint32_t parent;
+			boost::int32_t lo; // Window of cells (offsets of instructions)
+			boost::int32_t hi;
+
+			loop_t(void) : eligible(false), parent(HangDetector::NONE), lo(0), hi(0) {}
+		};
+
+		/// @brief
+		///
+		///
+		struct record_t {
+			bool valid;
+			boost::uint32_t loop;
+			boost::int64_t base;
+			boost::uint64_t hash;
+			boost::uint64_t bytes_in;
+			boost::uint64_t bytes_out;
+			boost::uint64_t back_edges;
+
+			bool same(record_t const& x) const {
+				return this->loop == x.loop && this->base == x.base && this->hash == x.hash &&
+					this->bytes_in == x.bytes_in && this->bytes_out == x.bytes_out;
+			}
+		};
+
+		/// @brief
+		///
+		///
+		boost::uint32_t outermost(boost::uint32_t loop) const {
+			if(loop >= this->loops.size() || !this->loops[loop].eligible) {
+				return self::NONE;
+			}
+
+			while(this->loops[loop].parent != self::NONE && this->loops[this->loops[loop].parent].eligible) {
+				loop = this->loops[loop].parent;
+			}
+			return loop;
+		}
+
+		/// @brief Run the outer loop from the back-edge of the loop on a copy of the window
+		///
+		/// @return true - the back-edge is reached again with the same window
+		static bool simulate(Program const& program, boost::uint32_t outer, boost::uint32_t loop,
+							 cell_t const* cells, std::size_t size, boost::int32_t lo, boost::uint64_t budget) {
+			Instruction const* const code = program.code.data();
+			Instruction const* const end = code + program.code[loop].jump - 1;
+			Instruction const* const last = code + program.code[outer].jump - 1;
+			Instruction const* i = code + end->jump;
+			std::vector<cell_t> window(cells, cells + size);
+			cell_t* const w = window.data() - lo;
+
+			for(;;) {
+				switch(i->opcode) {
+				case IR_ADD:
+					w[i->offset] += static_cast<cell_t>(i->value);
+					break;
+				case IR_LOOP:
+					if(!w[i->offset]) {
+						i = code + i->jump;
+						continue;
+					}
+					break;
+				case IR_END:
+					if(w[i->offset]) {
+						if(i == end && std::equal(window.begin(), window.end(), cells)) {
+							return true;
+						}
+
+						if(!budget--) {
+							return false;
+						}
+
+						i = code + i->jump;
+						continue;
+					}
+
+					if(i == last) {
+						return false;
+					}
+					break;
+				case IR_CLEAR:
+					w[i->offset] = 0;
+					break;
+				case IR_VADD:
+					add_vector(window.data(), size, i->offset - lo, program.vectors[i->value], 1);
+					break;
+				case IR_MUL:
+					{
+						VectorAdd const& v = program.vectors[i->value];
+						cell_t const k = static_cast<cell_t>(w[i->offset] * v.iterations);
+
+						w[i->offset] = 0;
+						add_vector(window.data(), size, v.offset - lo, v, k);
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = program.linear[i->value];
+						cell_t const k = static_cast<cell_t>(l.rest(w[i->offset]));
+
+						if(k) {
+							w[i->offset] = 0;
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								add_vector(window.data(), size, program.vectors[j].offset - lo, program.vectors[j], k);
+							}
+						}
+					}
+					break;
+				default:
+					return false;
+				}
+
+				++i;
+			}
+		}
+
+		static boost::int32_t const MAX_WINDOW;      // Cells of the window
+		static boost::uint64_t const MAX_SIMULATION; // Back-edges of one proof
+		static boost::uint64_t const MAX_POWER;      // Samples between saves of the state
+
+		std::vector<self::loop_t> loops;
+		self::record_t record;
+		boost::uint64_t samples;
+		boost::uint64_t power;
+	};
+
+	boost::uint32_t const HangDetector::NONE = std::numeric_limits<boost::uint32_t>::max();
+	boost::int32_t const HangDetector::MAX_WINDOW = 4096;
+	boost::uint64_t const HangDetector::MAX_SIMULATION = 1 << 24;
+	boost::uint64_t const HangDetector::MAX_POWER = 1 << 16;
+
+	/// @brief Engine of the decoded program (see ProgramCompiler)
+	///
+	/// @note Executes the same program as GraphicMachine with the same limits, checkpoints
+	///       and output, but without the iterator in the hot loop.
+	class CompiledGraphicMachine : public GraphicMachine {
+		typedef CompiledGraphicMachine self;
+		typedef GraphicMachine parent;
+	public:
+		/// @brief
+		///
+		///
+		CompiledGraphicMachine(std::shared_ptr<IPrinter> p,
+							   std::shared_ptr<IIteratorMachine> m,
+							   OutputType o,
+							   MachineLimits const& l,
+							   CheckpointOptions const& c,
+							   TapeOptions const& t,
+							   CompilerOptions const& co) :
+			parent(p, m, o, l, c, t),
+			compiler(co),
+			program(),
+			start(0),
+			start_offset(0),
+			current(nullptr),
+			hang() {}
+
+		/// @brief
+		///
+		///
+		virtual ~CompiledGraphicMachine(void) noexcept {}
+
+		/// @brief The decoded program (after init)
+		///
+		///
+		Program const& get_program(void) const {
+			return this->program;
+		}
+
+		/// @brief Take the program (once: the machine can run it many times)
+		///
+		/// @note The iterator is initialized by the compiler only: a program from the cache
+		///       doesn't need the image at all.
+		virtual void init(void) {
+			if(this->program.code.empty()) {
+				this->load_program();
+
+				if(this->limits.hang_check) {
+					this->hang.build(this->program);
+				}
+			}
+		}
+
+		/// @brief
+		///
+		///
+		virtual void run(void) {
+			this->start = 0;
+			this->start_offset = 0;
+			this->hang.reset();
+
+			parent::run();
+		}
+
+		/// @brief
+		///
+		///
+		virtual void print(std::ostream& os) {
+			parent::init();
+			parent::print(os);
+		}
+
+		/// @brief
+		///
+		///
+		virtual tracing::counters_t get_counters(void) const {
+			tracing::counters_t counters = parent::get_counters();
+
+			counters.optimized = true;
+			counters.eliminated = this->program.eliminated;
+
+			return counters;
+		}
+	protected:
+		/// @brief Take the program from the cache or compile it (and put into the cache)
+		///
+		///
+		void load_program(void) {
+			boost::uint64_t const hash = (this->compiler.cache_dir.empty()) ? 0 : this->im.get()->get_hash();
+			boost::uint64_t const tape_size = this->tape_size();
+			boost::uint64_t key = 0;
+			std::string filename;
+
+			if(hash) {
+				std::ostringstream oss;
+
+				key = utils::fnv1a(&tape_size, sizeof(tape_size), hash);
+				key = utils::fnv1a(&this->compiler.prefix_budget, sizeof(this->compiler.prefix_budget), key);
+				key = utils::fnv1a(&this->tape.checked, sizeof(this->tape.checked), key);
+				if(!this->compiler.superinstructions.empty()) {
+					std::string data;
+
+					utils::read_file(this->compiler.superinstructions, data);
+					key = utils::fnv1a(data.data(), data.size(), key);
+				}
+				oss << this->compiler.cache_dir << "/" << std::hex << std::setfill('0') << std::setw(16) << key << ".blp";
+				filename = oss.str();
+
+				tracing::Scope scope("cache load");
+
+				if(this->program.load(filename, key)) {
+					return;
+				}
+			}
+
+			this->program = ProgramCompiler(this->tape.checked).compile(*this->im.get());
+
+			tracing::Scope scope("optimize");
+
+			DataflowOptimizer((this->tape.checked) ? tape_size : 0).optimize(this->program);
+			VectorOptimizer().optimize(this->program);
+			LinearLoopSolver().optimize(this->program);
+
+			if(this->tape.checked) {
+				BoundsChecker().insert(this->program);
+			}
+
+			if(this->compiler.prefix_budget) {
+				PrefixEvaluator().evaluate(this->program, tape_size, this->compiler.prefix_budget);
+			}
+
+			if(!this->compiler.superinstructions.empty()) {
+				OpcodeProfile profile;
+
+				if(profile.load(this->compiler.superinstructions)) {
+					this->program.superinstructions = profile.select();
+				}
+				else {
+					std::cerr << "Profile can't be read: " << this->compiler.superinstructions << std::endl;
+				}
+			}
+
+			if(hash) {
+				::mkdir(this->compiler.cache_dir.c_str(), 0755);
+				this->program.save(filename, key);
+			}
+		}
+
+		/// @brief Continue from the state after the prefix and write its output by one write
+		///
+		/// @note The prefix is not used if it alone is over the instruction limit.
+		virtual void prepare(parent::state_ref s) {
+			ProgramPrefix const& prefix = this->program.prefix;
+
+			if(!prefix.valid ||
+			   (this->limits.max_instructions && prefix.executed > this->limits.max_instructions)) {
+				return;
+			}
+
+			std::for_each(prefix.cells.begin(), prefix.cells.end(), [&s](auto const& x)->void {
+					s.cells[x.first] = x.second;
+				});
+			s.num = prefix.num;
+			s.executed = prefix.executed;
+			s.back_edges = prefix.back_edges;
+			s.bytes_out = prefix.output.size();
+			this->start = prefix.start;
+
+			if(this->shadow) {
+				this->shadow->skip(prefix.ends);
+			}
+
+			this->output(prefix.output.data(), prefix.output.size());
+		}
+
+		virtual void interpretator(parent::state_ref s) {
+			Instruction const* const code = this->program.code.data();
+			Instruction const* i = code + this->start;
+			parent::cell_t* const cells = s.cells.data();
+			parent::index_t num = s.num - static_cast<parent::index_t>(this->start_offset);
+			VectorAdd const* const vectors = this->program.vectors.data();
+			boost::uint32_t pc = this->start;
+
+			if(this->program.checked && pc && !this->exact(s, pc, num)) {
+				return;
+			}
+			i = code + pc;
+
+			for(;;) {
+				switch(i->opcode) {
+				case IR_ADD:
+					cells[num + i->offset] += static_cast<parent::cell_t>(i->value);
+					break;
+				case IR_MOVE:
+					num += i->offset;
+					break;
+				case IR_READ:
+					this->input(cells[num + i->offset]);
+					s.bytes_in++;
+					break;
+				case IR_WRITE:
+					this->output(cells[num + i->offset]);
+					s.bytes_out++;
+					break;
+				case IR_LOOP:
+					s.executed += i->count;
+
+					if(!cells[num + i->offset]) {
+						i = code + i->jump;
+						continue;
+					}
+					break;
+				case IR_END:
+					s.executed += i->count;
+
+					if(cells[num + i->offset]) {
+						s.num = num + i->offset;
+						this->current = i;
+						i = code + i->jump;
+						this->check_limits(s);
+						continue;
+					}
+					break;
+				case IR_CLEAR:
+					{
+						parent::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = (cell * static_cast<boost::uint32_t>(i->value)) & 0xFF;
+
+						this->check_budget(s, num + i->offset, static_cast<boost::uint32_t>(i->value), nullptr, num, i->count, i->jump, k);
+						s.executed += i->count + k * i->jump;
+						s.back_edges += (k) ? k - 1 : 0; // The last iteration falls through
+						cell = 0;
+					}
+					break;
+				case IR_VADD:
+					add_vector(cells, s.cells.size(), num + i->offset, vectors[i->value], 1);
+					break;
+				case IR_MUL:
+					{
+						VectorAdd const& v = vectors[i->value];
+						parent::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = (cell * v.iterations) & 0xFF;
+
+						this->check_budget(s, num + i->offset, v.iterations, &v, num, i->count, i->jump, k);
+						s.executed += i->count + k * i->jump;
+						s.back_edges += (k) ? k - 1 : 0;
+						cell = 0;
+						if(k) {
+							add_vector(cells, s.cells.size(), num + v.offset, v, static_cast<parent::cell_t>(k));
+						}
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = this->program.linear[i->value];
+						parent::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = this->solve_iterations(s, l, cell);
+
+						if(k) {
+							s.executed += k * l.executed;
+							s.back_edges += k * l.back_edges;
+							cell = 0;
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								add_vector(cells, s.cells.size(), num + vectors[j].offset, vectors[j], static_cast<parent::cell_t>(k));
+							}
+						}
+					}
+					break;
+				case IR_CHECK:
+					if(!self::inside(s, num, i->offset, i->value)) {
+						pc = static_cast<boost::uint32_t>(i - code);
+
+						if(!this->exact(s, pc, num)) {
+							return;
+						}
+						i = code + pc;
+						continue;
+					}
+					break;
+				case IR_FAIL:
+					s.num = num + i->offset;
+
+					if(i->value == OP_UNKNOWN) {
+						throw UnknownOperationGraphicMachineException();
+					}
+					throw UnsupportOperationGraphicMachineException();
+				case IR_HALT:
+				default:
+					s.executed += i->count;
+					s.num = num;
+					return;
+				}
+
+				++i;
+			}
+		}
+
+		/// @brief Is the range of cells from the base cell in the tape? (see IR_CHECK)
+		///
+		///
+		static inline bool inside(parent::state_cref s, parent::index_t num, boost::int32_t first, boost::int32_t last) {
+			return num + first < s.cells.size() && num + last < s.cells.size();
+		}
+
+		/// @brief The cell of an access of the exact mode (see exact)
+		///
+		///
+		static inline parent::cell_t& at(parent::state_ref s, parent::index_t num, boost::int32_t offset) {
+			parent::index_t const cell = num + offset;
+
+			if(cell >= s.cells.size()) {
+				throw TapeBoundsGraphicMachineException();
+			}
+
+			return s.cells[cell];
+		}
+
+		/// @brief Stop inside IR_CLEAR or IR_MUL of k iterations if the budget ends there
+		///
+		/// @note The reference engine checks the budget on the back-edges of the loop: after
+		///       the iteration m < k the counter is executed + count + m * jump.
+		inline void check_budget(parent::state_ref s, parent::index_t cell, boost::uint32_t multiplier,
+								 VectorAdd const* v, parent::index_t base,
+								 boost::uint64_t count, boost::uint64_t jump, boost::uint64_t k) {
+			if(k > 1 && s.executed + count + (k - 1) * jump > this->max_instructions) {
+				this->stop_loop(s, cell, multiplier, v, base, count, jump);
+			}
+		}
+
+		/// @brief Iterations of IR_SOLVE: zero if the loop ends over the budget
+		///
+		/// @note Then the loop goes on by iterations and stops on the same back-edge as the
+		///       reference engine (every back-edge of the loop is within k * executed).
+		inline boost::uint64_t solve_iterations(parent::state_cref s, LinearLoop const& l, parent::cell_t counter) const {
+			boost::uint64_t const k = l.rest(counter);
+
+			return (s.executed + k * l.executed > this->max_instructions) ? 0 : k;
+		}
+
+		/// @brief Do the iterations of the collapsed loop up to the back-edge over the budget
+		///
+		/// @note The counter steps by the inverse of the multiplier (-1 / step is an involution).
+		void stop_loop(parent::state_ref s, parent::index_t cell, boost::uint32_t multiplier,
+					   VectorAdd const* v, parent::index_t base,
+					   boost::uint64_t count, boost::uint64_t jump) {
+			boost::uint64_t const first = s.executed + count;
+			boost::uint64_t const m = (first >= this->max_instructions) ? 1 : (this->max_instructions - first) / jump + 1;
+			boost::int32_t const step = DataflowOptimizer::iterations(static_cast<boost::int32_t>(multiplier));
+
+			s.executed = first + m * jump;
+			s.back_edges += m - 1; // RU: Ребро, на котором остановились, не считается
+			s.cells[cell] = static_cast<parent::cell_t>(s.cells[cell] + m * static_cast<boost::uint64_t>(step));
+			if(v) {
+				add_vector(s.cells.data(), s.cells.size(), base + v->offset, *v, static_cast<parent::cell_t>(m));
+			}
+			s.num = cell;
+
+			this->streams.out->flush();
+			throw InstructionLimitGraphicMachineException();
+		}
+
+		/// @brief Run the program from the instruction with the check of every access up to the
+		///        next IR_CHECK which passes (false - the program is ended)
+		///
+		/// @note It's the way of all engines after a failed IR_CHECK and after a start in the
+		///       middle of a region (the prefix, the checkpoint). pc is the instruction after
+		///       the passed check, engines continue there.
+		bool exact(parent::state_ref s, boost::uint32_t& pc, parent::index_t& num) {
+			Instruction const* const code = this->program.code.data();
+			Instruction const* i = code + pc;
+
+			for(;;) {
+				switch(i->opcode) {
+				case IR_ADD:
+					self::at(s, num, i->offset) += static_cast<parent::cell_t>(i->value);
+					break;
+				case IR_MOVE:
+					num += i->offset;
+					break;
+				case IR_READ:
+					this->input(self::at(s, num, i->offset));
+					s.bytes_in++;
+					break;
+				case IR_WRITE:
+					this->output(self::at(s, num, i->offset));
+					s.bytes_out++;
+					break;
+				case IR_LOOP:
+					s.executed += i->count;
+
+					if(!self::at(s, num, i->offset)) {
+						i = code + i->jump;
+						continue;
+					}
+					break;
+				case IR_END:
+					s.executed += i->count;
+
+					if(self::at(s, num, i->offset)) {
+						s.num = num + i->offset;
+						this->current = i;
+						i = code + i->jump;
+						this->check_limits(s);
+						continue;
+					}
+					break;
+				case IR_CLEAR:
+					{
+						parent::cell_t& cell = self::at(s, num, i->offset);
+						boost::uint64_t const k = (cell * static_cast<boost::uint32_t>(i->value)) & 0xFF;
+
+						this->check_budget(s, num + i->offset, static_cast<boost::uint32_t>(i->value), nullptr, num, i->count, i->jump, k);
+						s.executed += i->count + k * i->jump;
+						s.back_edges += (k) ? k - 1 : 0; // The last iteration falls through
+						cell = 0;
+					}
+					break;
+				case IR_VADD:
+				case IR_MUL:
+					{
+						VectorAdd const& v = this->program.vectors[i->value];
+						boost::uint64_t const k = (i->opcode == IR_MUL) ?
+							(self::at(s, num, i->offset) * v.iterations) & 0xFF : 1;
+
+						// RU: Окно непрерывно: достаточно проверить его края до изменения ленты
+						if(k) {
+							self::at(s, num, v.offset);
+							self::at(s, num, v.offset + static_cast<boost::int32_t>(v.size) - 1);
+						}
+
+						if(i->opcode == IR_MUL) {
+							this->check_budget(s, num + i->offset, v.iterations, &v, num, i->count, i->jump, k);
+							s.executed += i->count + k * i->jump;
+							s.back_edges += (k) ? k - 1 : 0;
+							s.cells[num + i->offset] = 0;
+						}
+
+						if(k) {
+							add_vector(s.cells.data(), s.cells.size(), num + v.offset, v, static_cast<parent::cell_t>(k));
+						}
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = this->program.linear[i->value];
+						boost::uint64_t const k = this->solve_iterations(s, l, self::at(s, num, i->offset));
+
+						if(k) {
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								VectorAdd const& v = this->program.vectors[j];
+
+								self::at(s, num, v.offset);
+								self::at(s, num, v.offset + static_cast<boost::int32_t>(v.size) - 1);
+							}
+
+							s.executed += k * l.executed;
+							s.back_edges += k * l.back_edges;
+							s.cells[num + i->offset] = 0;
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								VectorAdd const& v = this->program.vectors[j];
+
+								add_vector(s.cells.data(), s.cells.size(), num + v.offset, v, static_cast<parent::cell_t>(k));
+							}
+						}
+					}
+					break;
+				case IR_CHECK:
+					if(self::inside(s, num, i->offset, i->value)) {
+						pc = static_cast<boost::uint32_t>(i + 1 - code);
+						return true;
+					}
+					break;
+				case IR_FAIL:
+					if(i->value == OP_UNKNOWN) {
+						throw UnknownOperationGraphicMachineException();
+					}
+					throw UnsupportOperationGraphicMachineException();
+				case IR_HALT:
+				default:
+					s.executed += i->count;
+					s.num = num;
+					return false;
+				}
+
+				++i;
+			}
+		}
+
+		/// @brief The state on back-edge matches the reference engine on the same ']'
+		///
+		///
+		virtual void sync_state(parent::state_ref s) {
+			boost::uint32_t const loop = this->current->jump - 1;
+
+			s.pos = this->program.code[loop].pos;
+			s.loops = this->program.enclosing_loops(loop);
+		}
+
+		/// @brief
+		///
+		///
+		virtual boost::uint32_t loop_position(void) const {
+			return this->program.code[this->current->jump - 1].pos;
+		}
 
-	/// @brief
-	///
-	///
-	enum OutputType {
-		OT_NULL = 0,     // Пустой вывод (глушить вывод)
-		OT_CHAR,         // Символы
-		OT_HEX,          // Шестнадцатеричные числа
-		OT_BOTH          // Оба (символы и шестнадцатеричные числа)
-	};
-	
-	// *************************************************************************
-	// Common and specific exceptions' interfaces and exceptions' classes
-	// *************************************************************************
+		/// @brief
+		///
+		///
+		virtual void seek(parent::state_ref s) {
+			boost::uint32_t const loop = this->program.find_loop(s.pos);
 
-	/// @brief
-	///
-	///
-	class IMachineException : public std::exception {
-		typedef IMachineException self;
-	protected:
-		IMachineException(void) noexcept {}
-	public:
-		virtual ~IMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
+			if(loop >= this->program.code.size() || this->program.enclosing_loops(loop) != s.loops) {
+				throw CheckpointGraphicMachineException();
+			}
+
+			// RU: Продолжаем за IR_LOOP; свёрнутый цикл (IR_CLEAR, IR_MUL) выполняется снова
+			//     целиком, без блока до '[' - он уже учтён
+			if(this->program.code[loop].opcode == IR_LOOP) {
+				this->start = loop + 1;
+			}
+			else {
+				this->start = loop;
+				s.executed -= this->program.code[loop].count;
+			}
+			this->start_offset = this->program.code[loop].offset;
 		}
-	private:
-		static std::string const msg;
+
+		/// @brief Stop the loop of the current back-edge if it provably never ends
+		///
+		///
+		virtual void check_hang(parent::state_ref s) {
+			boost::uint32_t const loop = this->hang.sample(this->program, s, this->current->jump - 1);
+
+			if(loop == HangDetector::NONE) {
+				return;
+			}
+
+			this->streams.out->flush();
+
+			if(this->streams.console) {
+				this->im.get()->init();
+
+				GridPosition const p = this->im.get()->get_position(this->program.code[loop].pos);
+
+				std::cerr << "Loop at position " << this->program.code[loop].pos
+						  << " (" << p.x << ", " << p.y << ") never ends" << std::endl;
+			}
+			throw InfiniteLoopGraphicMachineException();
+		}
+
+		CompilerOptions compiler;
+		Program program;
+		boost::uint32_t start;
+		boost::int32_t start_offset;
+		Instruction const* current;
+		HangDetector hang;
 	};
 
-	/// @brief
+	/// @brief Engine of the decoded program with direct threaded dispatch and superinstructions
 	///
-	///
-	class ShitHappendGraphicMachineException : public IMachineException {
-		typedef ShitHappendGraphicMachineException self;
+	/// @note Uses "labels as values" of GCC/Clang; other compilers get the switch of
+	///       CompiledGraphicMachine. With the profile option the engine is instrumented: it
+	///       counts executions of instructions (without superinstructions) and writes
+	///       OpcodeProfile at the end of the run.
+	class ThreadedGraphicMachine : public CompiledGraphicMachine {
+		typedef ThreadedGraphicMachine self;
+		typedef CompiledGraphicMachine parent;
+
+		struct threaded_t {
+			void const* handler;
+			threaded_t const* target;
+			boost::int32_t offset[3];
+			boost::int32_t value[3];
+			boost::uint32_t count;
+			boost::uint32_t last;    // Index of the last fused instruction of the program
+		};
 	public:
-		ShitHappendGraphicMachineException(void) {}
-		virtual ~ShitHappendGraphicMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
+		/// @brief
+		///
+		///
+		ThreadedGraphicMachine(std::shared_ptr<IPrinter> p,
+							   std::shared_ptr<IIteratorMachine> m,
+							   OutputType o,
+							   MachineLimits const& l,
+							   CheckpointOptions const& c,
+							   TapeOptions const& t,
+							   CompilerOptions const& co) :
+			parent(p, m, o, l, c, t, co),
+			counts() {}
+
+		/// @brief
+		///
+		///
+		virtual ~ThreadedGraphicMachine(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual void run(void) {
+			if(this->compiler.profile.empty()) {
+				parent::run();
+				return;
+			}
+
+			try {
+				parent::run();
+			}
+			catch(IMachineException const&) {
+				this->save_profile();
+				throw;
+			}
+
+			this->save_profile();
+		}
+	protected:
+		virtual void interpretator(GraphicMachine::state_ref s) {
+#if defined(__GNUC__)
+			if(this->compiler.profile.empty()) {
+				this->execute<false>(s);
+			}
+			else {
+				this->counts.assign(this->program.code.size(), 0);
+				this->execute<true>(s);
+			}
+#else // defined(__GNUC__)
+			parent::interpretator(s);
+#endif // defined(__GNUC__)
+		}
+
+		/// @brief
+		///
+		///
+		void save_profile(void) {
+			OpcodeProfile profile;
+
+			if(this->counts.size() == this->program.code.size()) {
+				profile.collect(this->program, this->counts);
+			}
+
+			if(!profile.save(this->compiler.profile)) {
+				std::cerr << "Profile can't be written: " << this->compiler.profile << std::endl;
+			}
+		}
+
+#if defined(__GNUC__)
+#define THREADED_DISPATCH()									\
+		do {												\
+			if(PROFILE) {									\
+				this->counts[t->last]++;					\
+			}												\
+			goto *t->handler;								\
+		} while(0)
+
+#define THREADED_BACK_EDGE(k)								\
+		do {												\
+			s.num = num + t->offset[k];						\
+			this->current = code + t->last;					\
+			t = t->target;									\
+			this->check_limits(s);							\
+			THREADED_DISPATCH();							\
+		} while(0)
+
+		/// @brief Translate the program into threaded code and run it
+		///
+		/// @note Jump targets and the start instruction are never fused into the middle of
+		///       a superinstruction.
+		template<bool PROFILE>
+		void execute(GraphicMachine::state_ref s) {
+			static void* const handlers[] = {
+				&&L_ADD, &&L_MOVE, &&L_READ, &&L_WRITE, &&L_LOOP, &&L_END, &&L_FAIL, &&L_HALT, &&L_CLEAR, &&L_CHECK,
+				&&L_VADD, &&L_MUL, &&L_SOLVE
+			};
+			static void* const super_handlers[SI_COUNT] = {
+				&&L_ADD_ADD, &&L_ADD_MOVE, &&L_ADD_WRITE, &&L_ADD_END,
+				&&L_MOVE_LOOP, &&L_MOVE_END, &&L_ADD_ADD_ADD, &&L_ADD_ADD_END
+			};
+
+			Instruction const* const code = this->program.code.data();
+			std::vector<bool> targets = this->program.jump_targets();
+			std::vector<boost::uint32_t> map(this->program.code.size() + 1, 0);
+			std::vector<threaded_t> threaded;
+
+			{
+				tracing::Scope scope("translate");
+
+				targets[this->start] = true;
+				// RU: После проверки диапазона продолжает точный режим (см. exact)
+				for(boost::uint32_t i = 0; i < this->program.code.size(); i++) {
+					if(code[i].opcode == IR_CHECK) {
+						targets[i + 1] = true;
+					}
+				}
+
+				for(boost::uint32_t i = 0; i < this->program.code.size(); ) {
+					threaded_t t = threaded_t();
+					boost::uint32_t size = 1;
+
+					t.handler = handlers[code[i].opcode];
+					for(boost::uint32_t k = 0; !PROFILE && k < this->program.superinstructions.size(); k++) {
+						SuperinstructionPattern const& pattern = SUPERINSTRUCTIONS[this->program.superinstructions[k]];
+
+						if(OpcodeProfile::match(this->program, targets, i, pattern)) {
+							t.handler = super_handlers[this->program.superinstructions[k]];
+							size = pattern.size;
+							break;
+						}
+					}
+
+					for(boost::uint32_t j = 0; j < size; j++) {
+						t.offset[j] = code[i + j].offset;
+						t.value[j] = code[i + j].value;
+					}
+					if(code[i].opcode == IR_CLEAR || code[i].opcode == IR_MUL) {
+						t.value[1] = static_cast<boost::int32_t>(code[i].jump); // Instructions of one iteration
+					}
+					t.last = i + size - 1;
+					t.count = code[t.last].count;
+
+					map[i] = static_cast<boost::uint32_t>(threaded.size());
+					threaded.push_back(t);
+					i += size;
+				}
+
+				std::for_each(threaded.begin(), threaded.end(), [code, &threaded, &map](threaded_t& x)->void {
+						if(code[x.last].opcode == IR_LOOP || code[x.last].opcode == IR_END) {
+							x.target = &threaded[map[code[x.last].jump]];
+						}
+					});
+			}
+
+			threaded_t const* t = &threaded[map[this->start]];
+			GraphicMachine::cell_t* const cells = s.cells.data();
+			GraphicMachine::index_t num = s.num - static_cast<GraphicMachine::index_t>(this->start_offset);
+			VectorAdd const* const vectors = this->program.vectors.data();
+			boost::uint32_t pc = this->start;
+
+			if(this->program.checked && pc) {
+				if(!this->exact(s, pc, num)) {
+					return;
+				}
+				t = &threaded[map[pc]];
+			}
+
+			THREADED_DISPATCH();
+
+		L_ADD:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			++t;
+			THREADED_DISPATCH();
+		L_MOVE:
+			num += t->offset[0];
+			++t;
+			THREADED_DISPATCH();
+		L_READ:
+			this->input(cells[num + t->offset[0]]);
+			s.bytes_in++;
+			++t;
+			THREADED_DISPATCH();
+		L_WRITE:
+			this->output(cells[num + t->offset[0]]);
+			s.bytes_out++;
+			++t;
+			THREADED_DISPATCH();
+		L_LOOP:
+			s.executed += t->count;
+			t = (cells[num + t->offset[0]]) ? t + 1 : t->target;
+			THREADED_DISPATCH();
+		L_END:
+			s.executed += t->count;
+			if(cells[num + t->offset[0]]) {
+				THREADED_BACK_EDGE(0);
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_FAIL:
+			s.num = num + t->offset[0];
+			if(t->value[0] == OP_UNKNOWN) {
+				throw UnknownOperationGraphicMachineException();
+			}
+			throw UnsupportOperationGraphicMachineException();
+		L_HALT:
+			s.executed += t->count;
+			s.num = num;
+			return;
+		L_CLEAR:
+			{
+				GraphicMachine::cell_t& cell = cells[num + t->offset[0]];
+				boost::uint64_t const k = (cell * static_cast<boost::uint32_t>(t->value[0])) & 0xFF;
+
+				this->check_budget(s, num + t->offset[0], static_cast<boost::uint32_t>(t->value[0]), nullptr, num, t->count, static_cast<boost::uint32_t>(t->value[1]), k);
+				s.executed += t->count + k * static_cast<boost::uint32_t>(t->value[1]);
+				s.back_edges += (k) ? k - 1 : 0; // The last iteration falls through
+				cell = 0;
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_CHECK:
+			if(!parent::inside(s, num, t->offset[0], t->value[0])) {
+				pc = t->last;
+				if(!this->exact(s, pc, num)) {
+					return;
+				}
+				t = &threaded[map[pc]];
+				THREADED_DISPATCH();
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_VADD:
+			add_vector(cells, s.cells.size(), num + t->offset[0], vectors[t->value[0]], 1);
+			++t;
+			THREADED_DISPATCH();
+		L_MUL:
+			{
+				VectorAdd const& v = vectors[t->value[0]];
+				GraphicMachine::cell_t& cell = cells[num + t->offset[0]];
+				boost::uint64_t const k = (cell * v.iterations) & 0xFF;
+
+				this->check_budget(s, num + t->offset[0], v.iterations, &v, num, t->count, static_cast<boost::uint32_t>(t->value[1]), k);
+				s.executed += t->count + k * static_cast<boost::uint32_t>(t->value[1]);
+				s.back_edges += (k) ? k - 1 : 0;
+				cell = 0;
+				if(k) {
+					add_vector(cells, s.cells.size(), num + v.offset, v, static_cast<GraphicMachine::cell_t>(k));
+				}
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_SOLVE:
+			{
+				LinearLoop const& l = this->program.linear[t->value[0]];
+				GraphicMachine::cell_t& cell = cells[num + t->offset[0]];
+				boost::uint64_t const k = this->solve_iterations(s, l, cell);
+
+				if(k) {
+					s.executed += k * l.executed;
+					s.back_edges += k * l.back_edges;
+					cell = 0;
+					for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+						add_vector(cells, s.cells.size(), num + vectors[j].offset, vectors[j], static_cast<GraphicMachine::cell_t>(k));
+					}
+				}
+			}
+			++t;
+			THREADED_DISPATCH();
+
+		L_ADD_ADD:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			cells[num + t->offset[1]] += static_cast<GraphicMachine::cell_t>(t->value[1]);
+			++t;
+			THREADED_DISPATCH();
+		L_ADD_MOVE:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			num += t->offset[1];
+			++t;
+			THREADED_DISPATCH();
+		L_ADD_WRITE:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			this->output(cells[num + t->offset[1]]);
+			s.bytes_out++;
+			++t;
+			THREADED_DISPATCH();
+		L_ADD_END:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			s.executed += t->count;
+			if(cells[num + t->offset[1]]) {
+				THREADED_BACK_EDGE(1);
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_MOVE_LOOP:
+			num += t->offset[0];
+			s.executed += t->count;
+			t = (cells[num + t->offset[1]]) ? t + 1 : t->target;
+			THREADED_DISPATCH();
+		L_MOVE_END:
+			num += t->offset[0];
+			s.executed += t->count;
+			if(cells[num + t->offset[1]]) {
+				THREADED_BACK_EDGE(1);
+			}
+			++t;
+			THREADED_DISPATCH();
+		L_ADD_ADD_ADD:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			cells[num + t->offset[1]] += static_cast<GraphicMachine::cell_t>(t->value[1]);
+			cells[num + t->offset[2]] += static_cast<GraphicMachine::cell_t>(t->value[2]);
+			++t;
+			THREADED_DISPATCH();
+		L_ADD_ADD_END:
+			cells[num + t->offset[0]] += static_cast<GraphicMachine::cell_t>(t->value[0]);
+			cells[num + t->offset[1]] += static_cast<GraphicMachine::cell_t>(t->value[1]);
+			s.executed += t->count;
+			if(cells[num + t->offset[2]]) {
+				THREADED_BACK_EDGE(2);
+			}
+			++t;
+			THREADED_DISPATCH();
 		}
+
+#undef THREADED_BACK_EDGE
+#undef THREADED_DISPATCH
+#endif // defined(__GNUC__)
 	private:
-		static std::string const msg;
+		std::vector<boost::uint64_t> counts;
 	};
 
-	/// @brief
-	///
+
+	/// @brief Registers of TieredGraphicMachine shared with native code
 	///
-	class UnsupportOperationGraphicMachineException : public IMachineException {
-		typedef UnsupportOperationGraphicMachineException self;
-	public:
-		UnsupportOperationGraphicMachineException(void) {}
-		virtual ~UnsupportOperationGraphicMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
-		}
-	private:
-		static std::string const msg;
+	/// @note The counters are copied from the state before the call and back after it.
+	struct NativeContext {
+		MachineState::cell_t* cell;       // Base cell (cells + num)
+		boost::uint64_t executed;
+		boost::uint64_t back_edges;
+		boost::uint64_t max_instructions;
+		MachineState* state;
+		void* machine;
+		MachineState::cell_t* begin;      // The tape (for IR_CHECK)
+		MachineState::cell_t* end;
 	};
 
-	/// @brief
+	/// @brief Native code of a loop: entry(context, 0) runs its IR_LOOP, entry(context, 1)
+	///        continues after the back-edge; the result is the instruction to continue from
 	///
 	///
-	class UnknownOperationGraphicMachineException : public IMachineException {
-		typedef UnknownOperationGraphicMachineException self;
-	public:
-		UnknownOperationGraphicMachineException(void) {}
-		virtual ~UnknownOperationGraphicMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
-		}
-	private:
-		static std::string const msg;
-	};
+	typedef boost::uint32_t (*native_entry_t)(NativeContext*, boost::uint32_t);
 
-	/// @brief
+	/// @brief Functions called by native code
 	///
+	/// @note back_edge(context, index of IR_END) is called when the instruction budget is over
+	///       or the clock should be checked; non-zero result of every helper - the exception
+	///       is pending.
+	struct NativeHelpers {
+		boost::uint32_t (*back_edge)(NativeContext*, boost::uint32_t);
+		boost::uint32_t (*read)(NativeContext*, MachineState::cell_t*);
+		boost::uint32_t (*write)(NativeContext*, boost::uint32_t);
+	};
+
+	/// @brief Compiler of a loop of the program (with all nested loops) into x86-64 code
 	///
-	class UnexpectedOperationGraphicMachineException : public IMachineException {
-		typedef UnexpectedOperationGraphicMachineException self;
+	/// @note System V ABI: rbx is the base cell, r12 is NativeContext, the counters stay in
+	///       the context. Every way out of the loop (the end of the loop, IR_FAIL, a pending
+	///       exception) stores rbx into the context and returns the index of the instruction
+	///       to continue from (EXCEPTION - rethrow the exception of the machine).
+	class NativeLoopCompiler {
+		typedef NativeLoopCompiler self;
+
+		/// @brief Code with jumps to labels (rel32), resolved at the end
+		///
+		///
+		class Assembler {
+		public:
+			explicit Assembler(boost::uint32_t labels) : code(), labels(labels, -1), fixups() {}
+
+			inline void bytes(std::initializer_list<boost::uint8_t> x) {
+				this->code.insert(this->code.end(), x.begin(), x.end());
+			}
+
+			inline void u32(boost::uint32_t x) {
+				for(int k = 0; k < 4; k++) {
+					this->code.push_back(static_cast<boost::uint8_t>(x >> (8 * k)));
+				}
+			}
+
+			inline void u64(boost::uint64_t x) {
+				this->u32(static_cast<boost::uint32_t>(x));
+				this->u32(static_cast<boost::uint32_t>(x >> 32));
+			}
+
+			inline boost::uint32_t label(void) {
+				this->labels.push_back(-1);
+				return static_cast<boost::uint32_t>(this->labels.size() - 1);
+			}
+
+			inline void bind(boost::uint32_t label) {
+				this->labels[label] = static_cast<boost::int64_t>(this->code.size());
+			}
+
+			/// @brief Jump (opcode bytes) to the label
+			///
+			///
+			inline void jump(std::initializer_list<boost::uint8_t> opcode, boost::uint32_t label) {
+				this->bytes(opcode);
+				this->fixups.push_back(std::make_pair(this->code.size(), label));
+				this->u32(0);
+			}
+
+			void resolve(std::vector<boost::uint8_t>& out) {
+				std::for_each(this->fixups.begin(), this->fixups.end(), [this](auto const& x)->void {
+						boost::int64_t const rel = this->labels[x.second] - static_cast<boost::int64_t>(x.first + 4);
+
+						for(int k = 0; k < 4; k++) {
+							this->code[x.first + k] = static_cast<boost::uint8_t>(static_cast<boost::uint64_t>(rel) >> (8 * k));
+						}
+					});
+				out.swap(this->code);
+			}
+		private:
+			std::vector<boost::uint8_t> code;
+			std::vector<boost::int64_t> labels;
+			std::vector<std::pair<std::size_t, boost::uint32_t>> fixups;
+		};
 	public:
-		UnexpectedOperationGraphicMachineException(void) {}
-		virtual ~UnexpectedOperationGraphicMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
+		static boost::uint32_t const EXCEPTION = 0xFFFFFFFF;
+
+		/// @brief
+		///
+		///
+		NativeLoopCompiler(void) noexcept {}
+
+		/// @brief
+		///
+		///
+		virtual ~NativeLoopCompiler(void) noexcept {}
+
+		/// @brief Compile the loop which starts at the instruction (false - can't be compiled)
+		///
+		///
+		virtual bool compile(Program const& p, boost::uint32_t loop, NativeHelpers const& helpers,
+							 boost::uint32_t time_check_mask, std::vector<boost::uint8_t>& out) const {
+			boost::uint32_t const end = p.code[loop].jump - 1;
+			self::Assembler a(end + 2 - loop);
+			boost::uint32_t const exception = a.label();
+			boost::uint32_t const epilogue = a.label();
+
+			if(std::any_of(p.code.begin() + loop, p.code.begin() + end + 1, [](Instruction const& x)->bool {
+						return x.count > static_cast<boost::uint32_t>(std::numeric_limits<boost::int32_t>::max()) ||
+							((x.opcode == IR_CLEAR || x.opcode == IR_MUL) &&
+							 x.jump > static_cast<boost::uint32_t>(std::numeric_limits<boost::int32_t>::max()));
+					})) {
+				return false;
+			}
+
+			a.bytes({0x53, 0x41, 0x54, 0x41, 0x55});               // push rbx; push r12; push r13
+			a.bytes({0x49, 0x89, 0xFC});                           // mov r12, rdi
+			a.bytes({0x49, 0x8B, 0x9C, 0x24}); a.u32(self::CELL);  // mov rbx, [r12 + cell]
+			a.bytes({0x85, 0xF6});                                 // test esi, esi
+			a.jump({0x0F, 0x85}, 1);                               // jnz <body>
+
+			for(boost::uint32_t i = loop; i <= end; i++) {
+				Instruction const& x = p.code[i];
+				boost::uint32_t const disp = static_cast<boost::uint32_t>(x.offset);
+
+				a.bind(i - loop);
+
+				switch(x.opcode) {
+				case IR_ADD:
+					a.bytes({0x80, 0x83}); a.u32(disp);            // add byte [rbx + offset], value
+					a.bytes({static_cast<boost::uint8_t>(x.value)});
+					break;
+				case IR_MOVE:
+					a.bytes({0x48, 0x81, 0xC3}); a.u32(disp);      // add rbx, offset
+					break;
+				case IR_READ:
+					a.bytes({0x49, 0x89, 0x9C, 0x24}); a.u32(self::CELL); // mov [r12 + cell], rbx
+					a.bytes({0x4C, 0x89, 0xE7});                   // mov rdi, r12
+					a.bytes({0x48, 0x8D, 0xB3}); a.u32(disp);      // lea rsi, [rbx + offset]
+					self::call(a, reinterpret_cast<std::uintptr_t>(helpers.read));
+					a.bytes({0x85, 0xC0});                         // test eax, eax
+					a.jump({0x0F, 0x85}, exception);               // jnz <exception>
+					break;
+				case IR_WRITE:
+					a.bytes({0x49, 0x89, 0x9C, 0x24}); a.u32(self::CELL); // mov [r12 + cell], rbx
+					a.bytes({0x4C, 0x89, 0xE7});                   // mov rdi, r12
+					a.bytes({0x0F, 0xB6, 0xB3}); a.u32(disp);      // movzx esi, byte [rbx + offset]
+					self::call(a, reinterpret_cast<std::uintptr_t>(helpers.write));
+					a.bytes({0x85, 0xC0});                         // test eax, eax
+					a.jump({0x0F, 0x85}, exception);               // jnz <exception>
+					break;
+				case IR_LOOP:
+					self::count(a, x.count);
+					a.bytes({0x80, 0xBB}); a.u32(disp); a.bytes({0x00}); // cmp byte [rbx + offset], 0
+					a.jump({0x0F, 0x84}, x.jump - loop);                 // je <after the loop>
+					break;
+				case IR_END:
+					{
+						boost::uint32_t const slow = a.label();
+
+						self::count(a, x.count);
+						a.bytes({0x80, 0xBB}); a.u32(disp); a.bytes({0x00}); // cmp byte [rbx + offset], 0
+						a.jump({0x0F, 0x84}, i + 1 - loop);                  // je <next>
+						// RU: Как в check_limits: ребро, на котором остановились, не считается
+						a.bytes({0x49, 0x8B, 0x84, 0x24}); a.u32(self::EXECUTED);   // mov rax, [r12 + executed]
+						a.bytes({0x49, 0x3B, 0x84, 0x24}); a.u32(self::MAX);        // cmp rax, [r12 + max_instructions]
+						a.jump({0x0F, 0x87}, slow);                                  // ja <slow>
+						a.bytes({0x49, 0xFF, 0x84, 0x24}); a.u32(self::BACK_EDGES); // inc qword [r12 + back_edges]
+						a.bytes({0x41, 0xF7, 0x84, 0x24}); a.u32(self::BACK_EDGES); // test dword [r12 + back_edges], mask
+						a.u32(time_check_mask);
+						a.jump({0x0F, 0x84}, slow);                                  // jz <slow>
+						a.jump({0xE9}, x.jump - loop);                               // jmp <body>
+
+						// RU: Проверка лимитов, часов и контрольной точки - в машине
+						a.bind(slow);
+						a.bytes({0x49, 0x89, 0x9C, 0x24}); a.u32(self::CELL);       // mov [r12 + cell], rbx
+						a.bytes({0x4C, 0x89, 0xE7});                                 // mov rdi, r12
+						a.bytes({0xBE}); a.u32(i);                                   // mov esi, index
+						self::call(a, reinterpret_cast<std::uintptr_t>(helpers.back_edge));
+						a.bytes({0x85, 0xC0});                                       // test eax, eax
+						a.jump({0x0F, 0x85}, exception);                             // jnz <exception>
+						a.jump({0xE9}, x.jump - loop);                               // jmp <body>
+					}
+					break;
+				case IR_CLEAR:
+					a.bytes({0x0F, 0xB6, 0x83}); a.u32(disp);                // movzx eax, byte [rbx + offset]
+					a.bytes({0x69, 0xC0}); a.u32(static_cast<boost::uint32_t>(x.value)); // imul eax, eax, value
+					a.bytes({0x0F, 0xB6, 0xC0});                             // movzx eax, al (iterations)
+					self::budget(a, i, x, epilogue);
+					a.bytes({0x48, 0x83, 0xE8, 0x01});                       // sub rax, 1
+					a.bytes({0x48, 0x83, 0xD0, 0x00});                       // adc rax, 0 (zero stays zero)
+					a.bytes({0x49, 0x01, 0x84, 0x24}); a.u32(self::BACK_EDGES); // add [r12 + back_edges], rax
+					a.bytes({0xC6, 0x83}); a.u32(disp); a.bytes({0x00});     // mov byte [rbx + offset], 0
+					break;
+				case IR_VADD:
+					// RU: Константы окна - в самом коде: одна инструкция на ненулевую ячейку
+					self::lanes(a, p.vectors[x.value], false);
+					break;
+				case IR_MUL:
+					{
+						VectorAdd const& v = p.vectors[x.value];
+
+						a.bytes({0x0F, 0xB6, 0x83}); a.u32(disp);                // movzx eax, byte [rbx + offset]
+						a.bytes({0x69, 0xC0}); a.u32(v.iterations);              // imul eax, eax, iterations
+						a.bytes({0x0F, 0xB6, 0xC0});                             // movzx eax, al (iterations)
+						self::budget(a, i, x, epilogue);
+						self::lanes(a, v, true);
+						a.bytes({0x48, 0x83, 0xE8, 0x01});                       // sub rax, 1
+						a.bytes({0x48, 0x83, 0xD0, 0x00});                       // adc rax, 0 (zero stays zero)
+						a.bytes({0x49, 0x01, 0x84, 0x24}); a.u32(self::BACK_EDGES); // add [r12 + back_edges], rax
+						a.bytes({0xC6, 0x83}); a.u32(disp); a.bytes({0x00});     // mov byte [rbx + offset], 0
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = p.linear[x.value];
+
+						a.bytes({0x0F, 0xB6, 0x83}); a.u32(disp);                // movzx eax, byte [rbx + offset]
+						if(l.shift) {
+							a.bytes({0xA8, static_cast<boost::uint8_t>((1u << l.shift) - 1)}); // test al, mask
+							a.jump({0x0F, 0x85}, i + 1 - loop);                  // jnz <next> (undefined)
+							a.bytes({0xC1, 0xE8, static_cast<boost::uint8_t>(l.shift)}); // shr eax, shift
+						}
+						a.bytes({0x69, 0xC0}); a.u32(l.iterations);              // imul eax, eax, iterations
+						a.bytes({0x25}); a.u32(0xFFu >> l.shift);                // and eax, mask (iterations)
+						a.bytes({0x48, 0xB9}); a.u64(l.executed);                // mov rcx, executed
+						a.bytes({0x48, 0x0F, 0xAF, 0xC8});                       // imul rcx, rax
+						a.bytes({0x49, 0x03, 0x8C, 0x24}); a.u32(self::EXECUTED); // add rcx, [r12 + executed]
+						a.bytes({0x49, 0x3B, 0x8C, 0x24}); a.u32(self::MAX);     // cmp rcx, [r12 + max_instructions]
+						a.jump({0x0F, 0x87}, i + 1 - loop);                      // ja <next> (see solve_iterations)
+						a.bytes({0x49, 0x89, 0x8C, 0x24}); a.u32(self::EXECUTED); // mov [r12 + executed], rcx
+						for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+							self::lanes(a, p.vectors[j], true);
+						}
+						a.bytes({0x48, 0xB9}); a.u64(l.back_edges);              // mov rcx, back_edges
+						a.bytes({0x48, 0x0F, 0xAF, 0xC8});                       // imul rcx, rax
+						a.bytes({0x49, 0x01, 0x8C, 0x24}); a.u32(self::BACK_EDGES); // add [r12 + back_edges], rcx
+						a.bytes({0xC6, 0x83}); a.u32(disp); a.bytes({0x00});     // mov byte [rbx + offset], 0
+					}
+					break;
+				case IR_CHECK:
+					{
+						boost::uint32_t const fail = a.label();
+
+						a.bytes({0x48, 0x8D, 0x83}); a.u32(disp);                   // lea rax, [rbx + offset]
+						a.bytes({0x49, 0x3B, 0x84, 0x24}); a.u32(self::BEGIN);      // cmp rax, [r12 + begin]
+						a.jump({0x0F, 0x82}, fail);                                  // jb <fail>
+						a.bytes({0x48, 0x8D, 0x83}); a.u32(static_cast<boost::uint32_t>(x.value)); // lea rax, [rbx + value]
+						a.bytes({0x49, 0x3B, 0x84, 0x24}); a.u32(self::END);        // cmp rax, [r12 + end]
+						a.jump({0x0F, 0x82}, i + 1 - loop);                          // jb <next>
+
+						// RU: Проваленную проверку повторит интерпретатор (точный режим)
+						a.bind(fail);
+						self::exit(a, i, epilogue);
+					}
+					break;
+				case IR_FAIL:
+				default:
+					self::exit(a, i, epilogue);
+					break;
+				}
+			}
+
+			a.bind(end + 1 - loop);
+			self::exit(a, end + 1, epilogue);
+
+			a.bind(exception);
+			a.bytes({0xB8}); a.u32(self::EXCEPTION);               // mov eax, EXCEPTION
+
+			a.bind(epilogue);
+			a.bytes({0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3});         // pop r13; pop r12; pop rbx; ret
+
+			a.resolve(out);
+			return true;
+		}
+	protected:
+		/// @brief Add the lanes of the vector (times eax - the multiply loop)
+		///
+		///
+		static void lanes(self::Assembler& a, VectorAdd const& v, bool multiply) {
+			for(boost::uint32_t k = 0; k < v.size; k++) {
+				boost::uint32_t const disp = static_cast<boost::uint32_t>(v.offset + static_cast<boost::int32_t>(k));
+
+				if(!v.lanes[k]) {
+					continue;
+				}
+
+				if(multiply) {
+					a.bytes({0x69, 0xC8}); a.u32(v.lanes[k]);    // imul ecx, eax, lane
+					a.bytes({0x00, 0x8B}); a.u32(disp);          // add byte [rbx + offset], cl
+				}
+				else {
+					a.bytes({0x80, 0x83}); a.u32(disp);          // add byte [rbx + offset], lane
+					a.bytes({v.lanes[k]});
+				}
+			}
+		}
+
+		static void count(self::Assembler& a, boost::uint32_t count) {
+			if(count) {
+				a.bytes({0x49, 0x81, 0x84, 0x24}); a.u32(self::EXECUTED); // add qword [r12 + executed], count
+				a.u32(count);
+			}
+		}
+
+		/// @brief Count IR_CLEAR or IR_MUL of eax iterations (rcx is clobbered)
+		///
+		/// @note The loop which ends over the instruction budget is left to the interpreter
+		///       before any change: it stops on the same back-edge as the reference engine.
+		static void budget(self::Assembler& a, boost::uint32_t i, Instruction const& x, boost::uint32_t epilogue) {
+			boost::uint32_t const inside = a.label();
+
+			a.bytes({0x48, 0x69, 0xC8}); a.u32(x.jump);              // imul rcx, rax, jump
+			a.bytes({0x48, 0x81, 0xC1}); a.u32(x.count);             // add rcx, count
+			a.bytes({0x49, 0x03, 0x8C, 0x24}); a.u32(self::EXECUTED); // add rcx, [r12 + executed]
+			a.bytes({0x49, 0x3B, 0x8C, 0x24}); a.u32(self::MAX);     // cmp rcx, [r12 + max_instructions]
+			a.jump({0x0F, 0x86}, inside);                            // jbe <inside>
+			self::exit(a, i, epilogue);
+			a.bind(inside);
+			a.bytes({0x49, 0x89, 0x8C, 0x24}); a.u32(self::EXECUTED); // mov [r12 + executed], rcx
+		}
+
+		static void call(self::Assembler& a, std::uintptr_t function) {
+			a.bytes({0x48, 0xB8}); a.u64(function);                // mov rax, function
+			a.bytes({0xFF, 0xD0});                                 // call rax
 		}
-	private:
-		static std::string const msg;
+
+		static void exit(self::Assembler& a, boost::uint32_t next, boost::uint32_t epilogue) {
+			a.bytes({0x49, 0x89, 0x9C, 0x24}); a.u32(self::CELL);  // mov [r12 + cell], rbx
+			a.bytes({0xB8}); a.u32(next);                          // mov eax, next
+			a.jump({0xE9}, epilogue);                              // jmp <epilogue>
+		}
+
+		static boost::uint32_t const CELL = offsetof(NativeContext, cell);
+		static boost::uint32_t const EXECUTED = offsetof(NativeContext, executed);
+		static boost::uint32_t const BACK_EDGES = offsetof(NativeContext, back_edges);
+		static boost::uint32_t const BEGIN = offsetof(NativeContext, begin);
+		static boost::uint32_t const END = offsetof(NativeContext, end);
+		static boost::uint32_t const MAX = offsetof(NativeContext, max_instructions);
 	};
 
-	/// @brief
+	/// @brief Executable copy of native code (written, then mapped read-only)
 	///
 	///
-	class UnexpectedEndOfProgrammGraphicMachineException : public IMachineException {
-		typedef UnexpectedEndOfProgrammGraphicMachineException self;
+	class NativeCode {
+		typedef NativeCode self;
 	public:
-		UnexpectedEndOfProgrammGraphicMachineException(void) {}
-		virtual ~UnexpectedEndOfProgrammGraphicMachineException(void) noexcept {}
-		virtual const char* what(void) const noexcept {
-			return self::msg.c_str();
+		/// @brief
+		///
+		///
+		explicit NativeCode(std::vector<boost::uint8_t> const& code) noexcept : memory(nullptr), size(code.size()) {
+			void* const m = ::mmap(nullptr, this->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if(m == MAP_FAILED) {
+				return;
+			}
+
+			std::memcpy(m, code.data(), this->size);
+			if(::mprotect(m, this->size, PROT_READ | PROT_EXEC)) {
+				::munmap(m, this->size);
+				return;
+			}
+
+			this->memory = m;
+		}
+
+		/// @brief
+		///
+		///
+		~NativeCode(void) noexcept {
+			if(this->memory) {
+				::munmap(this->memory, this->size);
+			}
+		}
+
+		NativeCode(self const&) = delete;
+		self& operator=(self const&) = delete;
+
+		inline bool valid(void) const {
+			return this->memory != nullptr;
+		}
+
+		inline void const* data(void) const {
+			return this->memory;
+		}
+
+		inline std::size_t get_size(void) const {
+			return this->size;
+		}
+
+		inline native_entry_t entry(void) const {
+			return reinterpret_cast<native_entry_t>(this->memory);
 		}
 	private:
-		static std::string const msg;
+		void* memory;
+		std::size_t size;
 	};
-	
-	std::string const IMachineException::msg = std::string("Error! It's a base IMachineException! Your code is shit");
-	std::string const ShitHappendGraphicMachineException::msg = std::string("Unknown exception!");
-	std::string const UnsupportOperationGraphicMachineException::msg = std::string("Unsupport operation!");
-	std::string const UnknownOperationGraphicMachineException::msg = std::string("Unknown operation!");
-	std::string const UnexpectedOperationGraphicMachineException::msg = std::string("Unexpected operation!");
-	std::string const UnexpectedEndOfProgrammGraphicMachineException::msg = std::string("Unexpected end of program!");
 
-	// *************************************************************************
-	// Main interfaces
-	// *************************************************************************
-	
-	/// @brief
+	/// @brief Tiered engine: the interpreter of the decoded program counts back-edges, a hot
+	///        loop (with all nested loops) is compiled to native code
 	///
-	///
-	class IPrinter {
+	/// @note The interpreter runs a copy of the program where IR_LOOP of a compiled loop is
+	///       patched into IR_NATIVE; the loop that got hot continues in native code from its
+	///       back-edge. Native code is x86-64 only: on other targets, or when executable
+	///       memory is not allowed, everything stays in the interpreter.
+	class TieredGraphicMachine : public CompiledGraphicMachine {
+		typedef TieredGraphicMachine self;
+		typedef CompiledGraphicMachine parent;
 	public:
 		/// @brief
 		///
 		///
-		virtual ~IPrinter(void) noexcept {}
+		TieredGraphicMachine(std::shared_ptr<IPrinter> p,
+							 std::shared_ptr<IIteratorMachine> m,
+							 OutputType o,
+							 MachineLimits const& l,
+							 CheckpointOptions const& c,
+							 TapeOptions const& t,
+							 CompilerOptions const& co) :
+			parent(p, m, o, l, c, t, co),
+			tiered(),
+			heat(),
+			natives(),
+			error() {}
 
 		/// @brief
 		///
 		///
-		virtual std::string print(Operation op) const = 0;
+		virtual ~TieredGraphicMachine(void) noexcept {}
+	protected:
+		virtual void interpretator(GraphicMachine::state_ref s) {
+			this->tiered = this->program.code;
+			this->heat.assign(this->tiered.size(), 0);
+			this->natives.clear();
+
+			Instruction const* const code = this->tiered.data();
+			Instruction const* i = code + this->start;
+			GraphicMachine::cell_t* const cells = s.cells.data();
+			GraphicMachine::index_t num = s.num - static_cast<GraphicMachine::index_t>(this->start_offset);
+			VectorAdd const* const vectors = this->program.vectors.data();
+			boost::uint32_t pc = this->start;
+
+			// RU: Точный режим идёт по исходной программе: индексы у копии те же
+			if(this->program.checked && pc && !this->exact(s, pc, num)) {
+				return;
+			}
+			i = code + pc;
+
+			for(;;) {
+				switch(i->opcode) {
+				case IR_ADD:
+					cells[num + i->offset] += static_cast<GraphicMachine::cell_t>(i->value);
+					break;
+				case IR_MOVE:
+					num += i->offset;
+					break;
+				case IR_READ:
+					this->input(cells[num + i->offset]);
+					s.bytes_in++;
+					break;
+				case IR_WRITE:
+					this->output(cells[num + i->offset]);
+					s.bytes_out++;
+					break;
+				case IR_LOOP:
+					s.executed += i->count;
+
+					if(!cells[num + i->offset]) {
+						i = code + i->jump;
+						continue;
+					}
+					break;
+				case IR_END:
+					s.executed += i->count;
+
+					if(cells[num + i->offset]) {
+						boost::uint32_t const loop = i->jump - 1;
+
+						s.num = num + i->offset;
+						this->current = i;
+						i = code + i->jump;
+						this->check_limits(s);
+
+						if(++this->heat[loop] == this->compiler.jit_threshold && this->tier_up(loop)) {
+							i = code + this->enter(s, num, static_cast<boost::uint32_t>(this->natives.size() - 1), 1);
+						}
+						continue;
+					}
+					break;
+				case IR_CLEAR:
+					{
+						GraphicMachine::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = (cell * static_cast<boost::uint32_t>(i->value)) & 0xFF;
+
+						this->check_budget(s, num + i->offset, static_cast<boost::uint32_t>(i->value), nullptr, num, i->count, i->jump, k);
+						s.executed += i->count + k * i->jump;
+						s.back_edges += (k) ? k - 1 : 0; // The last iteration falls through
+						cell = 0;
+					}
+					break;
+				case IR_VADD:
+					add_vector(cells, s.cells.size(), num + i->offset, vectors[i->value], 1);
+					break;
+				case IR_MUL:
+					{
+						VectorAdd const& v = vectors[i->value];
+						GraphicMachine::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = (cell * v.iterations) & 0xFF;
+
+						this->check_budget(s, num + i->offset, v.iterations, &v, num, i->count, i->jump, k);
+						s.executed += i->count + k * i->jump;
+						s.back_edges += (k) ? k - 1 : 0;
+						cell = 0;
+						if(k) {
+							add_vector(cells, s.cells.size(), num + v.offset, v, static_cast<GraphicMachine::cell_t>(k));
+						}
+					}
+					break;
+				case IR_SOLVE:
+					{
+						LinearLoop const& l = this->program.linear[i->value];
+						GraphicMachine::cell_t& cell = cells[num + i->offset];
+						boost::uint64_t const k = this->solve_iterations(s, l, cell);
+
+						if(k) {
+							s.executed += k * l.executed;
+							s.back_edges += k * l.back_edges;
+							cell = 0;
+							for(boost::uint32_t j = l.first; j < l.first + l.vectors; j++) {
+								add_vector(cells, s.cells.size(), num + vectors[j].offset, vectors[j], static_cast<GraphicMachine::cell_t>(k));
+							}
+						}
+					}
+					break;
+				case IR_CHECK:
+					if(!parent::inside(s, num, i->offset, i->value)) {
+						pc = static_cast<boost::uint32_t>(i - code);
+
+						if(!this->exact(s, pc, num)) {
+							return;
+						}
+						i = code + pc;
+						continue;
+					}
+					break;
+				case IR_NATIVE:
+					i = code + this->enter(s, num, static_cast<boost::uint32_t>(i->value), 0);
+					continue;
+				case IR_FAIL:
+					s.num = num + i->offset;
+
+					if(i->value == OP_UNKNOWN) {
+						throw UnknownOperationGraphicMachineException();
+					}
+					throw UnsupportOperationGraphicMachineException();
+				case IR_HALT:
+				default:
+					s.executed += i->count;
+					s.num = num;
+					return;
+				}
+
+				++i;
+			}
+		}
+
+		/// @brief Compile the loop and patch its IR_LOOP (false - the loop stays interpreted)
+		///
+		///
+		bool tier_up(boost::uint32_t loop) {
+#if defined(__x86_64__)
+			tracing::Scope scope("jit");
+			NativeHelpers const helpers = {&self::native_back_edge, &self::native_read, &self::native_write};
+			std::vector<boost::uint8_t> bytes;
+
+			if(!NativeLoopCompiler().compile(this->program, loop, helpers,
+											 static_cast<boost::uint32_t>((this->shadow) ? 0 : GraphicMachine::TIME_CHECK_MASK),
+											 bytes)) {
+				return false;
+			}
+
+			std::unique_ptr<NativeCode> native(new NativeCode(bytes));
+			std::ostringstream name;
+
+			if(!native->valid()) {
+				return false;
+			}
+
+			name << "brainloller::loop@" << this->program.code[loop].pos;
+			tracing::PerfMap::add(native->data(), native->get_size(), name.str());
+
+			this->tiered[loop].opcode = IR_NATIVE;
+			this->tiered[loop].value = static_cast<boost::int32_t>(this->natives.size());
+			this->natives.push_back(std::move(native));
+
+			return true;
+#else // defined(__x86_64__)
+			UNUSED_SUPPRESSOR(loop);
+
+			return false;
+#endif // defined(__x86_64__)
+		}
+
+		/// @brief Run native code of the loop (see native_entry_t), the pending exception is thrown
+		///
+		///
+		boost::uint32_t enter(GraphicMachine::state_ref s, GraphicMachine::index_t& num,
+							  boost::uint32_t native, boost::uint32_t entry) {
+			NativeContext context = {s.cells.data() + num, s.executed, s.back_edges, this->max_instructions, &s, this,
+									 s.cells.data(), s.cells.data() + s.cells.size()};
+			boost::uint32_t const next = this->natives[native]->entry()(&context, entry);
+
+			num = static_cast<GraphicMachine::index_t>(context.cell - s.cells.data());
+			s.executed = context.executed;
+			s.back_edges = context.back_edges;
+
+			if(next == NativeLoopCompiler::EXCEPTION) {
+				std::exception_ptr error = this->error;
+
+				this->error = nullptr;
+				std::rethrow_exception(error);
+			}
+
+			return next;
+		}
+
+		/// @brief Limits, clock and checkpoints on back-edge of native code (see check_limits)
+		///
+		/// @note Exceptions can't pass through native code: it's stored and thrown by enter().
+		static boost::uint32_t native_back_edge(NativeContext* context, boost::uint32_t index) {
+			self* const machine = static_cast<self*>(context->machine);
+			GraphicMachine::state_ref s = *context->state;
+
+			s.num = static_cast<GraphicMachine::index_t>(context->cell - s.cells.data()) + machine->tiered[index].offset;
+			s.executed = context->executed;
+			s.back_edges = context->back_edges;
+			machine->current = &machine->tiered[index];
+
+			try {
+				if(machine->shadow) {
+					machine->shadow->back_edge(s, machine->loop_position());
+				}
+
+				if(s.executed > machine->max_instructions) {
+					machine->streams.out->flush();
+					throw InstructionLimitGraphicMachineException();
+				}
+
+				if(!(s.back_edges & GraphicMachine::TIME_CHECK_MASK)) {
+					machine->check_time(s);
+				}
+			}
+			catch(...) {
+				machine->error = std::current_exception();
+				return 1;
+			}
+
+			return 0;
+		}
+
+		/// @brief
+		///
+		/// @note The input and the output can throw (the callbacks of the library, see
+		///       CallbackOutputBuffer): as on back-edge, the exception is stored for enter().
+		static boost::uint32_t native_read(NativeContext* context, MachineState::cell_t* cell) {
+			self* const machine = static_cast<self*>(context->machine);
+
+			try {
+				context->state->executed = context->executed; // RU: Для записи чтений (см. RunRecorder)
+				machine->input(*cell);
+				context->state->bytes_in++;
+			}
+			catch(...) {
+				machine->error = std::current_exception();
+				return 1;
+			}
+
+			return 0;
+		}
+
+		static boost::uint32_t native_write(NativeContext* context, boost::uint32_t value) {
+			self* const machine = static_cast<self*>(context->machine);
+
+			try {
+				machine->output(static_cast<MachineState::cell_t>(value));
+				context->state->bytes_out++;
+			}
+			catch(...) {
+				machine->error = std::current_exception();
+				return 1;
+			}
+
+			return 0;
+		}
+
+		Program::code_t tiered;                           // The program with patched loops
+		std::vector<boost::uint32_t> heat;                // Back-edges by IR_LOOP
+		std::vector<std::unique_ptr<NativeCode>> natives;
+		std::exception_ptr error;                         // Pending exception of native code
 	};
 
-	/// @brief
-	///
+
+	/// @brief Interactive debugger (engine "debug")
 	///
-	class IIteratorMachine {
+	/// @note It's the reference interpretator instantiated with the hook of the debugger:
+	///       the production engines have no checks of the debugger at all. Commands are
+	///       read from DebuggerOptions::input (the standard input belongs to the program),
+	///       messages go to std::cerr. The debugger stops before the first instruction.
+	class DebugGraphicMachine : public GraphicMachine {
+		typedef DebugGraphicMachine self;
+		typedef GraphicMachine parent;
+
+		typedef std::vector<std::pair<parent::index_t, parent::cell_t>> watchpoints_t;
+
+		struct hook_t {
+			self* machine;
+
+			inline void operator()(parent::state_ref s, boost::uint32_t block_begin) const {
+				this->machine->before(s, block_begin);
+			}
+		};
 	public:
+		/// @brief
 		///
 		///
-		///
-		IIteratorMachine(void) noexcept {}
+		DebugGraphicMachine(std::shared_ptr<IPrinter> p,
+							std::shared_ptr<IIteratorMachine> m,
+							OutputType o,
+							MachineLimits const& l,
+							CheckpointOptions const& c,
+							TapeOptions const& t,
+							DebuggerOptions const& d) :
+			parent(p, m, o, l, c, t),
+			debugger(d),
+			input(),
+			ops(),
+			breakpoints(),
+			watchpoints(),
+			steps(1),
+			target(self::NO_TARGET) {}
 
+		/// @brief
 		///
 		///
-		///
-		virtual ~IIteratorMachine() noexcept {}
-	
+		virtual ~DebugGraphicMachine(void) noexcept {}
+
+		/// @brief
 		///
 		///
+		virtual void init(void) {
+			parent::init();
+
+			// RU: Копия декодированной программы - для поиска пары '[' и показа команд
+			boost::uint32_t const size = this->im.get()->get_size();
+
+			this->ops.resize(size);
+			this->im.get()->read(this->ops.data(), size);
+			this->im.get()->set_cur_pos(0);
+			this->breakpoints.assign(size, false);
+		}
+	protected:
+		virtual void interpretator(parent::state_ref s) {
+			hook_t hook = {this};
+
+			this->input.open(this->debugger.input.c_str());
+			if(!this->input) {
+				throw DebuggerGraphicMachineException();
+			}
+
+			this->execute(s, hook);
+
+			this->streams.out->flush();
+			std::cerr << std::endl << "Program finished: " << s.executed << " instructions" << std::endl;
+		}
+
+		/// @brief Check the reasons to stop before the instruction
 		///
-		virtual void init(void) = 0;
-	
 		///
+		inline void before(parent::state_ref s, boost::uint32_t block_begin) {
+			boost::uint32_t const pos = this->im.get()->get_cur_pos();
+			bool stop = (pos == this->target) || this->breakpoints[pos];
+
+			if(this->steps && !--this->steps) {
+				stop = true;
+			}
+
+			std::for_each(this->watchpoints.begin(), this->watchpoints.end(), [&s, &stop](auto& x)->void {
+					if(s.cells[x.first] != x.second) {
+						std::cerr << "Watchpoint: cell " << x.first << ": "
+								  << static_cast<boost::uint32_t>(x.second) << " -> "
+								  << static_cast<boost::uint32_t>(s.cells[x.first]) << std::endl;
+						x.second = s.cells[x.first];
+						stop = true;
+					}
+				});
+
+			if(stop) {
+				this->steps = 0;
+				this->target = self::NO_TARGET;
+				this->prompt(s, pos, s.executed + (pos - block_begin));
+			}
+		}
+
+		/// @brief Read and execute commands until the program should go on
 		///
 		///
-		virtual boost::uint32_t get_size(void) const = 0;
-	
+		void prompt(parent::state_ref s, boost::uint32_t pos, boost::uint64_t executed) {
+			std::string line;
+
+			this->streams.out->flush();
+			this->where(s, pos, executed);
+
+			for(;;) {
+				std::cerr << "(debug) " << std::flush;
+
+				if(!std::getline(this->input, line)) {
+					// RU: Команды кончились - программа выполняется до конца без остановок
+					std::cerr << std::endl;
+					this->breakpoints.assign(this->breakpoints.size(), false);
+					this->watchpoints.clear();
+					return;
+				}
+
+				std::istringstream iss(line);
+				std::string cmd;
+
+				iss >> cmd;
+				if(cmd.empty()) {
+					continue;
+				}
+				else if(cmd == "c" || cmd == "continue") {
+					return;
+				}
+				else if(cmd == "s" || cmd == "step") {
+					boost::uint32_t n = 1;
+
+					iss >> n;
+					this->steps = std::max<boost::uint32_t>(n, 1);
+					return;
+				}
+				else if(cmd == "n" || cmd == "next") {
+					if(this->ops[pos] == OP_BEGIN_LOOP) {
+						this->target = this->loop_end(pos) + 1;
+					}
+					else {
+						this->steps = 1;
+					}
+					return;
+				}
+				else if(cmd == "b" || cmd == "break" || cmd == "d" || cmd == "delete") {
+					GridPosition p = {0, 0};
+					boost::uint32_t found = 0;
+
+					if(!(iss >> p.x >> p.y)) {
+						std::cerr << "Usage: " << cmd << " X Y" << std::endl;
+						continue;
+					}
+
+					for(boost::uint32_t i = 0; i < this->ops.size(); i++) {
+						GridPosition const q = this->im.get()->get_position(i);
+
+						if(q.x == p.x && q.y == p.y) {
+							this->breakpoints[i] = (cmd[0] == 'b');
+							found++;
+						}
+					}
+					std::cerr << ((found) ? "Done" : "No instruction at this cell") << std::endl;
+				}
+				else if(cmd == "w" || cmd == "watch" || cmd == "unwatch") {
+					parent::index_t index = 0;
+
+					if(!(iss >> index) || index >= s.cells.size()) {
+						std::cerr << "Usage: " << cmd << " CELL (less than " << s.cells.size() << ")" << std::endl;
+						continue;
+					}
+
+					this->watchpoints.erase(std::remove_if(this->watchpoints.begin(), this->watchpoints.end(),
+														   [index](auto const& x)->bool {
+															   return x.first == index;
+														   }), this->watchpoints.end());
+					if(cmd != "unwatch") {
+						this->watchpoints.push_back(std::make_pair(index, s.cells[index]));
+					}
+				}
+				else if(cmd == "t" || cmd == "tape") {
+					parent::index_t first = (s.num > 8) ? s.num - 8 : 0;
+					parent::index_t count = 16;
+
+					iss >> first >> count;
+					this->tape(s, first, count);
+				}
+				else if(cmd == "i" || cmd == "info") {
+					this->where(s, pos, executed);
+				}
+				else if(cmd == "q" || cmd == "quit") {
+					*this->streams.out << std::endl;
+					::exit(EXIT_SUCCESS);
+				}
+				else {
+					std::cerr << "Commands:" << std::endl;
+					std::cerr << "\tc, continue\t" << "- run to the next breakpoint or watchpoint" << std::endl;
+					std::cerr << "\ts, step [N]\t" << "- run N instructions" << std::endl;
+					std::cerr << "\tn, next\t\t" << "- step over the loop (or one instruction)" << std::endl;
+					std::cerr << "\tb, break X Y\t" << "- set breakpoint on the cell of the image" << std::endl;
+					std::cerr << "\td, delete X Y\t" << "- remove breakpoint" << std::endl;
+					std::cerr << "\tw, watch CELL\t" << "- stop when value of the cell of the tape is changed" << std::endl;
+					std::cerr << "\tunwatch CELL\t" << "- remove watchpoint" << std::endl;
+					std::cerr << "\tt, tape [FIRST [COUNT]]\t" << "- show cells of the tape" << std::endl;
+					std::cerr << "\ti, info\t\t" << "- show current position" << std::endl;
+					std::cerr << "\tq, quit\t\t" << "- stop the program" << std::endl;
+				}
+			}
+		}
+
+		/// @brief
 		///
 		///
+		void where(parent::state_cref s, boost::uint32_t pos, boost::uint64_t executed) const {
+			GridPosition const p = this->im.get()->get_position(pos);
+
+			std::cerr << "Position " << pos << " (" << p.x << ", " << p.y << ") '"
+					  << self::OP_NAMES[this->ops[pos]] << "'"
+					  << ", cell " << s.num << " = "
+					  << static_cast<boost::uint32_t>((s.num < s.cells.size()) ? s.cells[s.num] : 0)
+					  << ", depth " << s.loops.size()
+					  << ", executed " << executed << std::endl;
+		}
+
+		/// @brief
 		///
-		virtual boost::uint32_t get_cur_pos(void) const = 0;
-	
 		///
+		void tape(parent::state_cref s, parent::index_t first, parent::index_t count) const {
+			parent::index_t const last = std::min<parent::index_t>(s.cells.size(), first + count);
+
+			for(parent::index_t i = first; i < last; i++) {
+				if(!((i - first) % 16)) {
+					std::cerr << ((i != first) ? "\n" : "") << std::setw(8) << i << ":";
+				}
+				std::cerr << ((i == s.num) ? "*" : " ")
+						  << std::hex << std::setw(2) << std::setfill('0')
+						  << static_cast<boost::uint32_t>(s.cells[i])
+						  << std::dec << std::setfill(' ');
+			}
+			std::cerr << std::endl;
+		}
+
+		/// @brief Position of ']' of the loop
 		///
 		///
-		virtual void set_cur_pos(boost::uint32_t pos) = 0;
-	
+		boost::uint32_t loop_end(boost::uint32_t pos) const {
+			boost::uint32_t depth = 0;
+
+			for(boost::uint32_t i = pos; i < this->ops.size(); i++) {
+				if(this->ops[i] == OP_BEGIN_LOOP) {
+					depth++;
+				}
+				else if(this->ops[i] == OP_END_LOOP && !--depth) {
+					return i;
+				}
+			}
+
+			return self::NO_TARGET - 1;
+		}
+	private:
+		DebuggerOptions debugger;
+		std::ifstream input;
+		std::vector<Operation> ops;
+		std::vector<bool> breakpoints;
+		self::watchpoints_t watchpoints;
+		boost::uint32_t steps;  // Instructions before the stop (zero - don't stop)
+		boost::uint32_t target; // Position to stop at (after the loop)
+
+		static boost::uint32_t const NO_TARGET;
+		static char const OP_NAMES[OP_COUNT + 1];
+	};
+
+	boost::uint32_t const DebugGraphicMachine::NO_TARGET = std::numeric_limits<boost::uint32_t>::max();
+	char const DebugGraphicMachine::OP_NAMES[OP_COUNT + 1] = "?+-><,.[]RL";
+
+	/// @brief
+	///
+	///
+	class GraphicMachineCreator : public IMachineCreator {
+	public:
+		/// @brief
 		///
 		///
+		explicit GraphicMachineCreator(std::shared_ptr<IPrinter> p,
+									   std::shared_ptr<IIteratorMachine> im,
+									   OutputType o,
+									   MachineLimits const& l,
+									   CheckpointOptions const& c,
+									   TapeOptions const& t)
+			: IMachineCreator(),
+			  printer(p),
+			  iterator_machine(im),
+			  ot(o),
+			  limits(l),
+			  checkpoint(c),
+			  tape(t) {
+		}
+
+		/// @brief
 		///
-		virtual Operation get_next(void) = 0;
-	
 		///
+		virtual ~GraphicMachineCreator(void) noexcept {}
+		
+		/// @brief
 		///
 		///
-		virtual bool is_done(void) const = 0;
+		/// @note The composed engine (see STATIC_MACHINES) if there is one for the iterator, the
+		///       output type and the tape, the generic one otherwise.
+		virtual std::shared_ptr<IMachine> create(void) const {
+			IIteratorMachine const& im = *iterator_machine.get();
+			static_machine_t const* end = STATIC_MACHINES + sizeof(STATIC_MACHINES) / sizeof(static_machine_t);
+			static_machine_t const* i = std::find_if(STATIC_MACHINES, end, [this, &im](static_machine_t const& x)->bool {
+					return x.iterator == typeid(im) && x.ot == this->ot && x.checked == this->tape.checked;
+				});
+
+			if(i != end) {
+				return i->create(printer, iterator_machine, ot, limits, checkpoint, tape);
+			}
+
+			return std::make_shared<GraphicMachine>(printer, iterator_machine, ot, limits, checkpoint, tape);
+		}
+	private:
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
 	};
 
 	/// @brief
 	///
 	///
-	class IMachine {
+	class CompiledGraphicMachineCreator : public IMachineCreator {
 	public:
-	
 		/// @brief
 		///
 		///
-		virtual ~IMachine() noexcept {}
+		explicit CompiledGraphicMachineCreator(std::shared_ptr<IPrinter> p,
+											   std::shared_ptr<IIteratorMachine> im,
+											   OutputType o,
+											   MachineLimits const& l,
+											   CheckpointOptions const& c,
+											   TapeOptions const& t,
+											   CompilerOptions const& co)
+			: IMachineCreator(),
+			  printer(p),
+			  iterator_machine(im),
+			  ot(o),
+			  limits(l),
+			  checkpoint(c),
+			  tape(t),
+			  compiler(co) {
+		}
 
 		/// @brief
 		///
 		///
-		virtual void init(void) = 0;
-	
-		/// @brief
-		///
-		///
-		virtual void run(void) = 0;
-	
+		virtual ~CompiledGraphicMachineCreator(void) noexcept {}
+		
 		/// @brief
 		///
 		///
-		virtual void print(void) = 0;
-	};
-	
-	/// @brief
-	///
-	///
-	class IMachineCreator {
-	public:
-		IMachineCreator(void) noexcept {}
-		virtual ~IMachineCreator(void) noexcept {}
-		virtual std::shared_ptr<IMachine> create(void) const = 0;
+		virtual std::shared_ptr<IMachine> create(void) const {
+			return std::make_shared<CompiledGraphicMachine>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+	private:
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
+		CompilerOptions compiler;
 	};
-		
-	// *************************************************************************
-	// Main classes
-	// *************************************************************************
-	
+
 	/// @brief
 	///
 	///
-	class NullPrinter : public IPrinter {
-		typedef NullPrinter self;
+	class ThreadedGraphicMachineCreator : public IMachineCreator {
 	public:
 		/// @brief
 		///
 		///
-		NullPrinter(void) {
+		explicit ThreadedGraphicMachineCreator(std::shared_ptr<IPrinter> p,
+											   std::shared_ptr<IIteratorMachine> im,
+											   OutputType o,
+											   MachineLimits const& l,
+											   CheckpointOptions const& c,
+											   TapeOptions const& t,
+											   CompilerOptions const& co)
+			: IMachineCreator(),
+			  printer(p),
+			  iterator_machine(im),
+			  ot(o),
+			  limits(l),
+			  checkpoint(c),
+			  tape(t),
+			  compiler(co) {
 		}
 
-		/// @brief Destructor of class
-		///
+		/// @brief
 		///
-		virtual ~NullPrinter(void) noexcept {}
-
 		///
+		virtual ~ThreadedGraphicMachineCreator(void) noexcept {}
+		
+		/// @brief
 		///
 		///
-		virtual std::string print(Operation op) const {
-			UNUSED_SUPPRESSOR(op);
-			
-			return std::string();
+		virtual std::shared_ptr<IMachine> create(void) const {
+			return std::make_shared<ThreadedGraphicMachine>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
 		}
+	private:
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
+		CompilerOptions compiler;
 	};
 
 	/// @brief
 	///
 	///
-	class SimplePrinter : public IPrinter {
-		typedef SimplePrinter self;
+	class TieredGraphicMachineCreator : public IMachineCreator {
 	public:
 		/// @brief
 		///
 		///
-		SimplePrinter(void) {
+		explicit TieredGraphicMachineCreator(std::shared_ptr<IPrinter> p,
+											 std::shared_ptr<IIteratorMachine> im,
+											 OutputType o,
+											 MachineLimits const& l,
+											 CheckpointOptions const& c,
+											 TapeOptions const& t,
+											 CompilerOptions const& co)
+			: IMachineCreator(),
+			  printer(p),
+			  iterator_machine(im),
+			  ot(o),
+			  limits(l),
+			  checkpoint(c),
+			  tape(t),
+			  compiler(co) {
 		}
 
-		/// @brief Destructor of class
-		///
+		/// @brief
 		///
-		virtual ~SimplePrinter(void) noexcept {}
-
 		///
+		virtual ~TieredGraphicMachineCreator(void) noexcept {}
+		
+		/// @brief
 		///
 		///
-		virtual std::string print(Operation op) const {
-			return boost::lexical_cast<std::string>(
-				static_cast<boost::int32_t>(op));
+		virtual std::shared_ptr<IMachine> create(void) const {
+			return std::make_shared<TieredGraphicMachine>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
 		}
+	private:
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
+		CompilerOptions compiler;
 	};
 
 	/// @brief
 	///
 	///
-	class SimpleSpacePrinter : public SimplePrinter {
-		typedef SimpleSpacePrinter self;
-		typedef SimplePrinter parent;
+	class DebugGraphicMachineCreator : public IMachineCreator {
 	public:
 		/// @brief
 		///
 		///
-		SimpleSpacePrinter(void) {
+		explicit DebugGraphicMachineCreator(std::shared_ptr<IPrinter> p,
+											std::shared_ptr<IIteratorMachine> im,
+											OutputType o,
+											MachineLimits const& l,
+											CheckpointOptions const& c,
+											TapeOptions const& t,
+											DebuggerOptions const& d)
+			: IMachineCreator(),
+			  printer(p),
+			  iterator_machine(im),
+			  ot(o),
+			  limits(l),
+			  checkpoint(c),
+			  tape(t),
+			  debugger(d) {
 		}
 
-		/// @brief Destructor of class
-		///
+		/// @brief
 		///
-		virtual ~SimpleSpacePrinter(void) noexcept {}
-
 		///
+		virtual ~DebugGraphicMachineCreator(void) noexcept {}
+		
+		/// @brief
 		///
 		///
-		virtual std::string print(Operation op) const {
-			return parent::print(op) + " ";
+		virtual std::shared_ptr<IMachine> create(void) const {
+			return std::make_shared<DebugGraphicMachine>(printer, iterator_machine, ot, limits, checkpoint, tape, debugger);
 		}
+	private:
+		std::shared_ptr<IPrinter> printer;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		OutputType ot;
+		MachineLimits limits;
+		CheckpointOptions checkpoint;
+		TapeOptions tape;
+		DebuggerOptions debugger;
 	};
 
-	/// @brief
+	/// @brief Shadow execution: the engine is run after the reference one on the same input,
+	///        outputs and checksums of the tape on back-edges are compared (see ShadowTrace)
 	///
-	///
-	class ClassicalBrainfuckPrinter : public IPrinter {
-		typedef ClassicalBrainfuckPrinter self;
+	/// @note Runs are sequential: the traces are compared after both runs. The window of
+	///       events before the first differing sample is run again with every event sampled
+	///       (and once more for the tapes), so the report names the exact loop iteration.
+	///       A run stopped by the clock (the time limit, the hang check) makes the result
+	///       inconclusive, the samples before it are still compared. The instruction limit stops
+	///       every engine on the same back-edge. The tape at the stop by '--checked' is not
+	///       compared: the engines check the head ahead of the accesses.
+	class ShadowVerifier {
+		typedef ShadowVerifier self;
 	public:
 		/// @brief
 		///
-		///
-		ClassicalBrainfuckPrinter(void) {
-			this->command[OP_UNKNOWN] = self::OP_UNKNOWN_STR;
-			this->command[OP_INC_CELL] = self::OP_INC_CELL_STR;
-			this->command[OP_DEC_CELL] = self::OP_DEC_CELL_STR;
-			this->command[OP_NEXT_CELL] = self::OP_NEXT_CELL_STR;
-			this->command[OP_PREV_CELL] = self::OP_PREV_CELL_STR;
-			this->command[OP_READ] = self::OP_READ_STR;
-			this->command[OP_WRITE] = self::OP_WRITE_STR;
-			this->command[OP_BEGIN_LOOP] = self::OP_BEGIN_LOOP_STR;
-			this->command[OP_END_LOOP] = self::OP_END_LOOP_STR;
-			this->command[OP_ROTATE_CLOCKWISE] = self::OP_ROTATE_CLOCKWISE_STR;
-			this->command[OP_ROTATE_COUNTER_CLOCKWISE] = self::OP_ROTATE_COUNTER_CLOCKWISE_STR;
-		}
+		/// @note Machines of both creators must be GraphicMachine, the engine one must be
+		///       CompiledGraphicMachine (or its descendant).
+		ShadowVerifier(std::shared_ptr<IMachineCreator> r,
+					   std::shared_ptr<IMachineCreator> e,
+					   std::shared_ptr<IIteratorMachine> im,
+					   boost::uint64_t i) :
+			reference(r), engine(e), iterator_machine(im), interval(i) {}
 
-		/// @brief Destructor of class
+		/// @brief
 		///
 		///
-		virtual ~ClassicalBrainfuckPrinter(void) noexcept {}
+		virtual ~ShadowVerifier(void) noexcept {}
 
+		/// @brief Run both engines on the input and write the report
 		///
-		///
-		///
-		virtual std::string print(Operation op) const {
-			return this->command.at(op);
-		}
-	private:
-		static std::string const OP_UNKNOWN_STR;
-		static std::string const OP_INC_CELL_STR;
-		static std::string const OP_DEC_CELL_STR;
-		static std::string const OP_NEXT_CELL_STR;
-		static std::string const OP_PREV_CELL_STR;
-		static std::string const OP_READ_STR;
-		static std::string const OP_WRITE_STR;
-		static std::string const OP_BEGIN_LOOP_STR;
-		static std::string const OP_END_LOOP_STR;
-		static std::string const OP_ROTATE_CLOCKWISE_STR;
-		static std::string const OP_ROTATE_COUNTER_CLOCKWISE_STR;
-		
-		std::map<Operation, std::string> command;
-	};
+		/// @note Returns EXIT_SUCCESS, EXIT_DIVERGED or EXIT_FAILURE (the program is wrong).
+		int verify(std::string const& name, std::string const& input, std::ostream& report) const {
+			std::shared_ptr<GraphicMachine> const r = std::dynamic_pointer_cast<GraphicMachine>(this->reference.get()->create());
+			std::shared_ptr<CompiledGraphicMachine> const e =
+				std::dynamic_pointer_cast<CompiledGraphicMachine>(this->engine.get()->create());
+			try {
+				e.get()->init();
+			}
+			catch(IMachineException const& ex) {
+				report << "FAILED " << name << ": " << ex.what() << std::endl;
+				return EXIT_FAILURE;
+			}
 
-	std::string const ClassicalBrainfuckPrinter::OP_UNKNOWN_STR = "";
-	std::string const ClassicalBrainfuckPrinter::OP_INC_CELL_STR = "+";
-	std::string const ClassicalBrainfuckPrinter::OP_DEC_CELL_STR = "-";
-	std::string const ClassicalBrainfuckPrinter::OP_NEXT_CELL_STR = ">";
-	std::string const ClassicalBrainfuckPrinter::OP_PREV_CELL_STR = "<";
-	std::string const ClassicalBrainfuckPrinter::OP_READ_STR = ",";
-	std::string const ClassicalBrainfuckPrinter::OP_WRITE_STR = ".";
-	std::string const ClassicalBrainfuckPrinter::OP_BEGIN_LOOP_STR = "[";
-	std::string const ClassicalBrainfuckPrinter::OP_END_LOOP_STR = "]";
-	std::string const ClassicalBrainfuckPrinter::OP_ROTATE_CLOCKWISE_STR = "";
-	std::string const ClassicalBrainfuckPrinter::OP_ROTATE_COUNTER_CLOCKWISE_STR = "";
+			// RU: События - обратные переходы только тех циклов, которые остались циклами в IR
+			Program const& p = e.get()->get_program();
+			std::vector<bool> const loops = p.stable_loops();
 
-	/// @brief
-	///
-	/// 
-	class GraphicIteratorMachine : public IIteratorMachine {
-		typedef GraphicIteratorMachine self;
-	
-		typedef std::map<boost::uint32_t, Operation> translator_map;
-	public:
+			ShadowTrace rt(loops, this->interval);
+			ShadowTrace et(loops, this->interval);
+			run_t const rr = self::run(*r.get(), rt, input);
+			run_t const er = self::run(*e.get(), et, input);
+			bool const limited = (self::is_limit(rr.status) || self::is_limit(er.status));
+			bool const partial = (limited || (rr.status == EXIT_TAPE_BOUNDS && er.status == EXIT_TAPE_BOUNDS));
+			std::size_t const k = self::compare(rt, et);
+			std::size_t const n = std::min(rt.samples.size(), et.samples.size());
+			boost::uint64_t const from = (k) ? rt.samples[k - 1].event : et.skipped;
+
+			if(k < n || (!limited && (rr.status != er.status || rr.output != er.output)) ||
+			   (!partial && (rt.samples.size() != et.samples.size() || rt.events != et.events ||
+							 rt.final_tape != et.final_tape))) {
+				report << "DIVERGED " << name << std::endl;
+				this->locate(*r.get(), *e.get(), loops, input, from, report);
+				return EXIT_DIVERGED;
+			}
+
+			if(limited) {
+				report << "LIMIT " << name << ": " << ((self::is_limit(rr.status)) ? rr.error : er.error) << std::endl;
+				return EXIT_SUCCESS;
+			}
+
+			// RU: Оба движка одинаково остановились на ошибке программы (например, вне ленты)
+			if(rr.status == EXIT_TAPE_BOUNDS || rr.status == EXIT_FAILURE) {
+				report << "FAILED " << name << ": " << rr.error << std::endl;
+				return EXIT_FAILURE;
+			}
+
+			report << "OK " << name << ": " << rt.events << " back-edges, " << rr.output.size() << " bytes"
+				   << ((rr.error.empty()) ? "" : ", ") << rr.error << std::endl;
+			return EXIT_SUCCESS;
+		}
+	private:
 		/// @brief
 		///
 		///
-		GraphicIteratorMachine(std::string const& filename, boost::uint32_t raw_cell_size) :
-			filename(filename),
-			graphic_cell_size(raw_cell_size),
-			cur_pos(0),
-			n(0) {
-			
-			this->gp = cv::imread(this->filename, 1);
-			this->gp_size = this->gp.size();
-			this->n = this->gp_size.width / this->graphic_cell_size;
+		struct run_t {
+			int status;         // Exit status of the run (see EXIT_*)
+			std::string output;
+			std::string error;
+		};
 
-			this->trans[self::CODE_INC_CELL]                 = OP_INC_CELL;
-			this->trans[self::CODE_DEC_CELL]                 = OP_DEC_CELL;
-			this->trans[self::CODE_NEXT_CELL]                = OP_NEXT_CELL;
-			this->trans[self::CODE_PREV_CELL]                = OP_PREV_CELL;
-			this->trans[self::CODE_READ]                     = OP_READ;
-			this->trans[self::CODE_WRITE]                    = OP_WRITE;
-			this->trans[self::CODE_BEGIN_LOOP]               = OP_BEGIN_LOOP;
-			this->trans[self::CODE_END_LOOP]                 = OP_END_LOOP;
-			this->trans[self::CODE_ROTATE_CLOCKWISE]         = OP_ROTATE_CLOCKWISE;
-			this->trans[self::CODE_ROTATE_COUNTER_CLOCKWISE] = OP_ROTATE_COUNTER_CLOCKWISE;
+		/// @brief Find the first differing event after 'from' and report the state at it
+		///
+		///
+		void locate(GraphicMachine& r, CompiledGraphicMachine& e, std::vector<bool> const& loops,
+					std::string const& input, boost::uint64_t from, std::ostream& report) const {
+			boost::uint64_t const to = (this->interval > std::numeric_limits<boost::uint64_t>::max() - from) ?
+				std::numeric_limits<boost::uint64_t>::max() : from + this->interval;
+			ShadowTrace rt(loops, 1, from, to);
+			ShadowTrace et(loops, 1, from, to);
+
+			self::run(r, rt, input);
+			self::run(e, et, input);
+
+			std::size_t const k = self::compare(rt, et);
+
+			// RU: Если события в окне совпали, расхождение в конце запуска - снимок там же
+			bool const at_event = (k < std::max(rt.samples.size(), et.samples.size()));
+			boost::uint64_t const event = (!at_event) ? std::numeric_limits<boost::uint64_t>::max() :
+				(k < rt.samples.size()) ? rt.samples[k].event : et.samples[k].event;
+			ShadowTrace rs(loops, 1, event - 1, event, event);
+			ShadowTrace es(loops, 1, event - 1, event, event);
+			run_t const rr = self::run(r, rs, input);
+			run_t const er = self::run(e, es, input);
+			Program const& p = e.get_program();
+
+			if(at_event) {
+				ShadowTrace::sample_t const& x = (k < rt.samples.size()) ? rt.samples[k] : et.samples[k];
+				GridPosition const g = this->position(x.pos);
+
+				report << "\tevent: " << event << ", back-edge of the loop at position " << x.pos
+					   << " (" << g.x << ", " << g.y << ")" << std::endl;
+				self::state(report, "reference", rt.samples, k, rs.tape);
+				self::state(report, "engine", et.samples, k, es.tape);
+			}
+			else {
+				report << "\tevent: end of the run after " << rs.events << " back-edges" << std::endl;
+				report << "\treference: status " << rr.status << ", " << rr.output.size() << " bytes"
+					   << ((rr.error.empty()) ? "" : ", ") << rr.error << std::endl;
+				report << "\tengine: status " << er.status << ", " << er.output.size() << " bytes"
+					   << ((er.error.empty()) ? "" : ", ") << er.error << std::endl;
+			}
+
+			std::size_t const o = self::mismatch(rr.output, er.output);
+
+			if(o < std::max(rr.output.size(), er.output.size())) {
+				report << "\toutput: first difference at byte " << o << std::endl;
+			}
+
+			std::size_t const c = self::mismatch(rs.tape, es.tape);
+
+			if(c < std::max(rs.tape.size(), es.tape.size())) {
+				report << "\tcell: first difference at cell " << c << ": reference "
+					   << ((c < rs.tape.size()) ? static_cast<unsigned>(rs.tape[c]) : 0U) << ", engine "
+					   << ((c < es.tape.size()) ? static_cast<unsigned>(es.tape[c]) : 0U) << std::endl;
+			}
+
+			if(at_event) {
+				ShadowTrace::sample_t const& x = (k < et.samples.size()) ? et.samples[k] : rt.samples[k];
+				boost::uint32_t const index = self::node(p, x, c);
+				Instruction const& i = p.code[index];
+
+				report << "\tIR: #" << index << " " << self::opcode_name(i.opcode) << " offset " << i.offset
+					   << ", value " << i.value << ", jump " << i.jump << ", position " << i.pos << std::endl;
+			}
 		}
 
-		/// @brief
+		/// @brief Index of the first differing sample (the shorter size if one is a prefix)
+		///
+		/// @note Samples of the reference inside the prefix of the engine are dropped: the
+		///       state after the prefix is compared by the next sample.
+		static std::size_t compare(ShadowTrace& r, ShadowTrace const& e) {
+			boost::uint64_t const skipped = e.skipped;
+
+			r.samples.erase(std::remove_if(r.samples.begin(), r.samples.end(),
+										   [skipped](ShadowTrace::sample_t const& x)->bool {
+											   return x.event <= skipped;
+										   }),
+							r.samples.end());
+
+			std::size_t const n = std::min(r.samples.size(), e.samples.size());
+			std::size_t k = 0;
+
+			while(k < n && r.samples[k].same(e.samples[k])) {
+				k++;
+			}
+
+			return k;
+		}
+
+		/// @brief Line of the state of one engine at the sample
 		///
 		///
-		GraphicIteratorMachine(std::string const& filename) : GraphicIteratorMachine(filename, 20) {}
+		static void state(std::ostream& report, char const* name, std::vector<ShadowTrace::sample_t> const& samples,
+						  std::size_t k, std::vector<MachineState::cell_t> const& tape) {
+			report << "\t" << name << ": ";
+			if(k < samples.size()) {
+				report << "head " << samples[k].num << ", " << samples[k].bytes_out << " bytes, tape checksum "
+					   << std::hex << samples[k].tape << std::dec << std::endl;
+			}
+			else {
+				report << "no such event, the run ended (" << tape.size() << " cells)" << std::endl;
+			}
+		}
 
-		/// @brief
+		/// @brief The last instruction of the loop of the event which changes the cell
+		///
+		/// @note Instructions are walked back from IR_END while the head is known (inner
+		///       loops without moves only). Nothing found - IR_END itself.
+		static boost::uint32_t node(Program const& p, ShadowTrace::sample_t const& x, std::size_t cell) {
+			boost::uint32_t const loop = p.find_loop(x.pos);
+
+			if(loop >= p.code.size() || p.code[loop].opcode != IR_LOOP) {
+				return 0;
+			}
+
+			boost::uint32_t const end = p.code[loop].jump - 1;
+			boost::int64_t const rel = static_cast<boost::int64_t>(cell) - static_cast<boost::int64_t>(x.num) +
+				p.code[end].offset;
+			boost::int64_t shift = 0; // Head of the instruction from the head of IR_END
+			boost::uint32_t depth = 0;
+
+			for(boost::uint32_t i = end; i-- > loop + 1; ) {
+				Instruction const& y = p.code[i];
+				boost::int32_t first = std::numeric_limits<boost::int32_t>::max();
+				boost::int32_t last = std::numeric_limits<boost::int32_t>::min();
+
+				switch(y.opcode) {
+				case IR_END:
+					depth++;
+					break;
+				case IR_LOOP:
+					depth--;
+					break;
+				case IR_MOVE:
+					if(depth) {
+						return end;
+					}
+					shift -= y.offset;
+					break;
+				case IR_ADD:
+				case IR_READ:
+				case IR_CLEAR:
+				case IR_VADD:
+				case IR_MUL:
+				case IR_SOLVE:
+					BoundsChecker::span(p, y, first, last);
+					if(rel - shift >= first && rel - shift <= last) {
+						return i;
+					}
+					break;
+				default:
+					break;
+				}
+			}
+
+			return end;
+		}
+
+		/// @brief Run the machine to the end, exceptions are the status
 		///
 		///
-		virtual ~GraphicIteratorMachine(void) noexcept {}
-	
-		/// @brief
+		static run_t run(GraphicMachine& m, ShadowTrace& trace, std::string const& input) {
+			std::istringstream in(input);
+			std::ostringstream out;
+			MachineStreams const streams = {&in, &out, false};
+			run_t res = {EXIT_SUCCESS, std::string(), std::string()};
+
+			m.set_streams(streams);
+			m.set_shadow(&trace);
+
+			try {
+				m.init();
+				m.run();
+			}
+			catch(InstructionLimitGraphicMachineException const& ex) {
+				res.status = EXIT_INSTRUCTION_LIMIT;
+				res.error = ex.what();
+			}
+			catch(TimeLimitGraphicMachineException const& ex) {
+				res.status = EXIT_TIME_LIMIT;
+				res.error = ex.what();
+			}
+			catch(InfiniteLoopGraphicMachineException const& ex) {
+				res.status = EXIT_INFINITE_LOOP;
+				res.error = ex.what();
+			}
+			catch(TapeBoundsGraphicMachineException const& ex) {
+				res.status = EXIT_TAPE_BOUNDS;
+				res.error = ex.what();
+			}
+			catch(IMachineException const& ex) {
+				res.status = EXIT_FAILURE;
+				res.error = ex.what();
+			}
+
+			m.set_shadow(nullptr);
+			m.set_streams(CONSOLE_STREAMS);
+			res.output = out.str();
+
+			return res;
+		}
+
+		/// @brief Stops by the clock: the engines run at different speeds
 		///
 		///
-		virtual void init(void) {
-			this->cur_pos = 0;
+		static bool is_limit(int status) {
+			return status == EXIT_TIME_LIMIT || status == EXIT_INFINITE_LOOP;
 		}
-	
-		/// @brief
+
+		/// @brief Index of the first differing element (the shorter size if one is a prefix)
 		///
 		///
-		virtual boost::uint32_t get_size(void) const {
-			return this->n;
+		template<typename T>
+		static std::size_t mismatch(T const& a, T const& b) {
+			std::size_t const n = std::min(a.size(), b.size());
+			std::size_t i = 0;
+
+			while(i < n && a[i] == b[i]) {
+				i++;
+			}
+
+			return (i == n && a.size() == b.size()) ? std::max(a.size(), b.size()) : i;
 		}
 
 		/// @brief
 		///
 		///
-		virtual boost::uint32_t get_cur_pos(void) const {
-			return this->cur_pos;
+		GridPosition position(boost::uint32_t pos) const {
+			this->iterator_machine.get()->init();
+			return this->iterator_machine.get()->get_position(pos);
 		}
-	
+
 		/// @brief
 		///
 		///
-		virtual void set_cur_pos(boost::uint32_t pos) {
-			this->cur_pos = pos;
+		static char const* opcode_name(Opcode op) {
+			static char const* const names[] = {
+				"ADD", "MOVE", "READ", "WRITE", "LOOP", "END", "FAIL", "HALT", "CLEAR", "CHECK", "VADD", "MUL", "SOLVE", "NATIVE"
+			};
+
+			return names[op];
 		}
-	
+
+		std::shared_ptr<IMachineCreator> reference;
+		std::shared_ptr<IMachineCreator> engine;
+		std::shared_ptr<IIteratorMachine> iterator_machine;
+		boost::uint64_t interval;
+	};
+
+	// *************************************************************************
+	// The library (see brainloller.h)
+	// *************************************************************************
+
+	/// @brief Output of the program for the callback of the library user
+	///
+	/// @note The refused output stops the run: the exception passes through the stream
+	///       (badbit is in the mask of exceptions of the stream).
+	class CallbackOutputBuffer : public std::streambuf {
+		typedef CallbackOutputBuffer self;
+	public:
 		/// @brief
 		///
 		///
-		virtual Operation get_next(void) {
-			boost::uint32_t delta = this->cur_pos * this->graphic_cell_size;
-			cv::Vec3b code = this->gp.at<cv::Vec3b>(1, delta);
-
-			Operation op = this->code_to_op(this->pack(code));
-			
-			this->cur_pos++;
-		
-			return op;
+		CallbackOutputBuffer(brainloller_write_t raw_write, void* raw_user) : write(raw_write), user(raw_user) {
+			this->setp(this->buffer, this->buffer + sizeof(this->buffer));
 		}
 
 		/// @brief
 		///
 		///
-		virtual bool is_done(void) const {
-			return this->cur_pos >= this->n;
-		}
+		virtual ~CallbackOutputBuffer(void) {}
 	protected:
-		virtual Operation code_to_op(boost::uint32_t code) const {
-			translator_map::const_iterator i_end = this->trans.end();
-			translator_map::const_iterator i = i_end;
+		virtual int_type overflow(int_type c) {
+			this->publish();
 
-			// RU: Пояснение. Тут не используется метод at или [] по причине генерации исключения,
-			//     если такой элемент не будет найден. Генерация исключения - довольно медленный
-			//     процесс. Чтобы гарантировать более-менее одинаковое время поиска операции
-			//     используется алгоритм. Возможно, вариант с исключением более приемлем в некоторых
-			//     случаях, т.к. данные исключения могут возникать при нормальной работе крайне редко.
-			//     Однако тут всё равно используется алгоритм.
-			i = std::find_if(this->trans.begin(), this->trans.end(), [code](auto x)->bool{
-					return (x.first == code);
-				});
-		
-			return (i != i_end) ? i->second : OP_UNKNOWN;
+			if(!traits_type::eq_int_type(c, traits_type::eof())) {
+				*this->pptr() = traits_type::to_char_type(c);
+				this->pbump(1);
+			}
+
+			return traits_type::not_eof(c);
 		}
-	
-		virtual boost::uint32_t pack(cv::Vec3b const value) const {
-			boost::uint32_t res = 0x00000000;
 
-			res =  (value[self::CH_NUM_RED]   << 0);
-			res += (value[self::CH_NUM_GREEN] << 8);
-			res += (value[self::CH_NUM_BLUE]  << 16);
-			
-			return res;
+		virtual int sync(void) {
+			this->publish();
+
+			return 0;
 		}
 	private:
-		std::string const filename;
-		boost::uint32_t graphic_cell_size;
-		boost::uint32_t cur_pos;
-		boost::uint32_t n;
-		cv::Mat gp;
-		cv::Size gp_size;
-		self::translator_map trans;
-	
-		static boost::uint32_t const RED;
-		static boost::uint32_t const GREEN;
-		static boost::uint32_t const BLUE;
-	
-		static boost::uint8_t const CH_NUM_RED;
-		static boost::uint8_t const CH_NUM_GREEN;
-		static boost::uint8_t const CH_NUM_BLUE;
-
-		static boost::uint32_t const CODE_INC_CELL;
-		static boost::uint32_t const CODE_DEC_CELL;
-		static boost::uint32_t const CODE_NEXT_CELL;
-		static boost::uint32_t const CODE_PREV_CELL;
-		static boost::uint32_t const CODE_READ;
-		static boost::uint32_t const CODE_WRITE;
-		static boost::uint32_t const CODE_BEGIN_LOOP;
-		static boost::uint32_t const CODE_END_LOOP;
-		static boost::uint32_t const CODE_ROTATE_CLOCKWISE;
-		static boost::uint32_t const CODE_ROTATE_COUNTER_CLOCKWISE;
-	};
+		/// @brief
+		///
+		///
+		void publish(void) {
+			std::size_t const size = static_cast<std::size_t>(this->pptr() - this->pbase());
 
-	boost::uint32_t const GraphicIteratorMachine::RED   = 0x000000FF;
-	boost::uint32_t const GraphicIteratorMachine::GREEN = 0x0000FF00;
-	boost::uint32_t const GraphicIteratorMachine::BLUE  = 0x00FF0000;
+			this->setp(this->buffer, this->buffer + sizeof(this->buffer));
 
-	boost::uint8_t const GraphicIteratorMachine::CH_NUM_RED   = 2;
-	boost::uint8_t const GraphicIteratorMachine::CH_NUM_GREEN = 1;
-	boost::uint8_t const GraphicIteratorMachine::CH_NUM_BLUE  = 0;
+			if(size && this->write &&
+			   this->write(this->user, reinterpret_cast<unsigned char const*>(this->buffer), size)) {
+				throw OutputGraphicMachineException();
+			}
+		}
 
-	boost::uint32_t const GraphicIteratorMachine::CODE_INC_CELL                 = 0x00FF00;
-	boost::uint32_t const GraphicIteratorMachine::CODE_DEC_CELL                 = 0x008000;
-	boost::uint32_t const GraphicIteratorMachine::CODE_NEXT_CELL                = 0xFF0000;
-	boost::uint32_t const GraphicIteratorMachine::CODE_PREV_CELL                = 0x800000;
-	boost::uint32_t const GraphicIteratorMachine::CODE_READ                     = 0x000080;
-	boost::uint32_t const GraphicIteratorMachine::CODE_WRITE                    = 0x0000FF;
-	boost::uint32_t const GraphicIteratorMachine::CODE_BEGIN_LOOP               = 0xFFFF00;
-	boost::uint32_t const GraphicIteratorMachine::CODE_END_LOOP                 = 0x808000;
-	boost::uint32_t const GraphicIteratorMachine::CODE_ROTATE_CLOCKWISE         = 0x008080;
-	boost::uint32_t const GraphicIteratorMachine::CODE_ROTATE_COUNTER_CLOCKWISE = 0x00FFFF;
+		brainloller_write_t write;
+		void* user;
+		char buffer[4096];
+	};
 
-	/// @brief
+	/// @brief Input of the program from the callback of the library user
 	///
-	/// @note Непосредственно машина интерпретатора. Является интерпретатором языка Брейнроллер,
-	///       однако, не все комманды реализованы. Комманды смены направления движения не
-	///       реализованы.
-	class GraphicMachine : public IMachine {
-		typedef GraphicMachine self;
-	protected:
-		typedef boost::uint8_t cell_t;
-		
-		typedef std::vector<self::cell_t> cells_t;
-		typedef self::cells_t& cells_ref;
-		typedef self::cells_t const& cells_cref;
-		
-		typedef self::cells_t::size_type index_t;
-		typedef self::index_t& index_ref;
-		typedef self::index_t const& index_cref;
-		
-		typedef std::stack<boost::uint32_t> ret_stack_t;
-		typedef self::ret_stack_t& ret_stack_ref;
-		typedef self::ret_stack_t const& ret_stack_cref;
+	///
+	class CallbackInputBuffer : public std::streambuf {
+		typedef CallbackInputBuffer self;
 	public:
-	
 		/// @brief
 		///
 		///
-		GraphicMachine(std::shared_ptr<IPrinter> p,
-					   std::shared_ptr<IIteratorMachine> m,
-					   OutputType o) :
-			printer(p),
-			im(m),
-			ot(o) {}
+		CallbackInputBuffer(brainloller_read_t raw_read, void* raw_user) : read(raw_read), user(raw_user) {
+			this->setg(this->buffer, this->buffer, this->buffer);
+		}
 
 		/// @brief
 		///
 		///
-		virtual ~GraphicMachine(void) noexcept {}
+		virtual ~CallbackInputBuffer(void) {}
+	protected:
+		virtual int_type underflow(void) {
+			if(this->gptr() < this->egptr()) {
+				return traits_type::to_int_type(*this->gptr());
+			}
 
-		/// @brief
-		///
-		///
-		virtual void init(void) {
-			this->im.get()->init();
+			std::size_t const n = (this->read) ?
+				std::min(this->read(this->user, reinterpret_cast<unsigned char*>(this->buffer), sizeof(this->buffer)),
+						 sizeof(this->buffer)) : 0;
+
+			if(!n) {
+				return traits_type::eof();
+			}
+
+			this->setg(this->buffer, this->buffer, this->buffer + n);
+
+			return traits_type::to_int_type(*this->gptr());
 		}
-	
-		/// @brief
-		///
-		///
-		virtual void run(void) throw(IMachineException) {
-			self::index_t num = 0;
-			self::cells_t cells(30000);
-			self::ret_stack_t st;
+	private:
+		brainloller_read_t read;
+		void* user;
+		char buffer[4096];
+	};
+
+	/// @brief Input and output of brainloller_run_buffers
+	///
+	///
+	struct memory_io_t {
+		unsigned char const* input;
+		std::size_t input_size;
+		unsigned char* output;
+		std::size_t output_size;
+		std::size_t written;
 
-			std::fill(cells.begin(), cells.end(), 0);
+		static std::size_t read(void* user, unsigned char* data, std::size_t size) {
+			memory_io_t* const io = static_cast<memory_io_t*>(user);
+			std::size_t const n = std::min(size, io->input_size);
 
-			this->interpretator(num, cells, st);
+			std::memcpy(data, io->input, n);
+			io->input += n;
+			io->input_size -= n;
 
-			std::cout << std::endl;
+			return n;
 		}
 
-		/// @brief
-		///
-		///
-		virtual void print(void) {
-			std::cout << "BEGIN PROGRAM >>>>>>>>>>" << std::endl;
-			while(!this->im.get()->is_done()) {
-				Operation op = this->im.get()->get_next();
-				std::cout << this->printer.get()->print(op);
+		static int write(void* user, unsigned char const* data, std::size_t size) {
+			memory_io_t* const io = static_cast<memory_io_t*>(user);
+			std::size_t const n = std::min(size, io->output_size - io->written);
+
+			std::memcpy(io->output + io->written, data, n);
+			io->written += n;
+
+			return (n < size) ? 1 : 0;
+		}
+	};
+
+	/// @brief Cells of the largest tape of the library (the tape is allocated by every run)
+	///
+	///
+	boost::uint64_t const LIBRARY_MAX_TAPE_SIZE = 1ULL << 32;
+
+	/// @brief Machine of the image with options of the library (empty - wrong options)
+	///
+	/// @note The program is compiled here (init), so errors of the image are found at once.
+	std::shared_ptr<IMachine> create_library_machine(cv::Mat const& image, brainloller_options const* options) {
+		brainloller_options o;
+		OutputType ot;
+
+		brainloller_default_options(&o);
+		if(options) {
+			o = *options;
+		}
+
+		std::string const engine((o.engine) ? o.engine : "");
+		std::string const output_type((o.output_type) ? o.output_type : "");
+
+		if(image.empty() || !o.cell_size || o.tape_size > LIBRARY_MAX_TAPE_SIZE) {
+			return std::shared_ptr<IMachine>();
+		}
+
+		if(!output_type.compare(OUTPUT_TYPE_NULL)) {
+			ot = OT_NULL;
+		}
+		else if(!output_type.compare(OUTPUT_TYPE_CHAR)) {
+			ot = OT_CHAR;
+		}
+		else if(!output_type.compare(OUTPUT_TYPE_HEX)) {
+			ot = OT_HEX;
+		}
+		else if(!output_type.compare(OUTPUT_TYPE_BOTH)) {
+			ot = OT_BOTH;
+		}
+		else {
+			return std::shared_ptr<IMachine>();
+		}
+
+		std::shared_ptr<IPrinter> const printer = std::make_shared<NullPrinter>();
+		std::shared_ptr<IIteratorMachine> const iterator_machine = std::make_shared<GraphicIteratorMachine>(image, o.cell_size);
+		std::shared_ptr<IMachineCreator> creator;
+
+		MachineLimits const limits = {o.max_instructions, o.max_time, o.hang_check != 0};
+		CheckpointOptions const checkpoint = {std::string(), std::string(), 0};
+		TapeOptions const tape = {o.tape_size, TA_DEFAULT, false, o.checked != 0};
+		CompilerOptions const compiler = {(o.cache_dir) ? o.cache_dir : "", o.prefix_budget, std::string(), std::string(),
+										  o.jit_threshold};
+
+		if(!engine.compare(ENGINE_TYPE_REFERENCE)) {
+			creator = std::make_shared<GraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape);
+		}
+		else if(!engine.compare(ENGINE_TYPE_COMPILED)) {
+			creator = std::make_shared<CompiledGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else if(!engine.compare(ENGINE_TYPE_THREADED)) {
+			creator = std::make_shared<ThreadedGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else if(!engine.compare(ENGINE_TYPE_TIERED)) {
+			creator = std::make_shared<TieredGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else {
+			return std::shared_ptr<IMachine>();
+		}
+
+		std::shared_ptr<IMachine> m = creator.get()->create();
+
+		try {
+			m.get()->init();
+		}
+		catch(IMachineException const&) {
+			return std::shared_ptr<IMachine>();
+		}
+
+		return m;
+	}
+} // namespace
+
+// *****************************************************************************
+// The library (see brainloller.h)
+// *****************************************************************************
+
+/// @brief
+///
+///
+struct brainloller_machine {
+	std::shared_ptr<IMachine> machine;
+	std::string error;
+};
+
+extern "C" {
+	/// @brief
+	///
+	///
+	void brainloller_default_options(brainloller_options* options) {
+		options->engine = ENGINE_TYPE_COMPILED.c_str();
+		options->output_type = OUTPUT_TYPE_CHAR.c_str();
+		options->cell_size = 20;
+		options->tape_size = 30000;
+		options->max_instructions = 0;
+		options->max_time = 0;
+		options->hang_check = 1;
+		options->prefix_budget = 10000000;
+		options->jit_threshold = 1024;
+		options->cache_dir = nullptr;
+		options->checked = 0;
+	}
+
+	/// @brief
+	///
+	///
+	brainloller_machine* brainloller_compile_image(void const* data, std::size_t size, brainloller_options const* options) {
+		try {
+			std::vector<uchar> const bytes(static_cast<uchar const*>(data), static_cast<uchar const*>(data) + size);
+			std::shared_ptr<IMachine> const m = create_library_machine(cv::imdecode(bytes, 1), options);
+
+			return (m) ? new brainloller_machine{m, std::string()} : nullptr;
+		}
+		catch(std::exception const&) {
+			return nullptr;
+		}
+		catch(...) {
+			return nullptr;
+		}
+	}
+
+	/// @brief
+	///
+	/// @note Channels are swapped: OpenCV (and the decoder) keep pixels as BGR.
+	brainloller_machine* brainloller_compile_rgb(void const* pixels, boost::uint32_t width, boost::uint32_t height,
+												 std::size_t stride, brainloller_options const* options) {
+		try {
+			cv::Mat image(static_cast<int>(height), static_cast<int>(width), CV_8UC3, cv::Scalar(0, 0, 0));
+
+			for(boost::uint32_t y = 0; y < height; y++) {
+				uchar const* const row = static_cast<uchar const*>(pixels) + y * stride;
+
+				for(boost::uint32_t x = 0; x < width; x++) {
+					cv::Vec3b& p = image.at<cv::Vec3b>(static_cast<int>(y), static_cast<int>(x));
+
+					p[0] = row[x * 3 + 2];
+					p[1] = row[x * 3 + 1];
+					p[2] = row[x * 3 + 0];
+				}
 			}
-			std::cout << std::endl;
-			std::cout << "<<<<<<<<<< END PROGRAM" << std::endl;
+
+			std::shared_ptr<IMachine> const m = create_library_machine(image, options);
+
+			return (m) ? new brainloller_machine{m, std::string()} : nullptr;
 		}
-	protected:
-		virtual void interpretator(self::index_ref num, self::cells_ref cells, self::ret_stack_ref st) {
-			while(!this->im.get()->is_done()) {
-				Operation op = this->im.get()->get_next();
-				
-				switch(op) {
-				case OP_INC_CELL:
-					cells[num]++;
-					break;
-				case OP_DEC_CELL:
-					cells[num]--;
-					break;
-				case OP_NEXT_CELL:
-					num++;
-					break;
-				case OP_PREV_CELL:
-					num--;
-					break;
-				case OP_READ:
-					std::cout << "Enter one symbol and press <ENTER>: ";
-					std::cin >> cells[num];
-					break;
-				case OP_WRITE:
-					this->output(cells[num]);
+		catch(std::exception const&) {
+			return nullptr;
+		}
+		catch(...) {
+			return nullptr;
+		}
+	}
 
-					break;
-				case OP_BEGIN_LOOP:
-					if(!cells[num]) {
-						do {
-							op = this->im.get()->get_next();
-						}
-						while(op != OP_END_LOOP && !this->im.get()->is_done());
+	/// @brief
+	///
+	/// @note The rest of the output is given to write even if the run failed.
+	int brainloller_run(brainloller_machine* machine, brainloller_read_t read, brainloller_write_t write, void* user,
+						brainloller_stats* stats) {
+		if(!machine) {
+			return BRAINLOLLER_ERROR;
+		}
 
-						if(op != OP_END_LOOP && this->im.get()->is_done()) {
-							throw UnexpectedEndOfProgrammGraphicMachineException();
-						}
-					}
-					else {
-						if(this->im.get()->get_cur_pos()) {
-							st.push(this->im.get()->get_cur_pos() - 1);
-						}
-						else {
-							throw ShitHappendGraphicMachineException();
-						}
-					}
-					break;
-				case OP_END_LOOP:
-					if(st.empty()) {
-						throw UnexpectedOperationGraphicMachineException();
-					}
-					else {
-						this->im.get()->set_cur_pos(st.top());
-						st.pop();
-					}
-					break;
-				case OP_UNKNOWN:
-					throw UnknownOperationGraphicMachineException();
-				case OP_ROTATE_CLOCKWISE:
-				case OP_ROTATE_COUNTER_CLOCKWISE:
-				default:
-					throw UnsupportOperationGraphicMachineException();
-				};
+		CallbackInputBuffer ib(read, user);
+		CallbackOutputBuffer ob(write, user);
+		std::istream in(&ib);
+		std::ostream out(&ob);
+		MachineStreams const streams = {&in, &out, false};
+		int status = BRAINLOLLER_OK;
+
+		out.exceptions(std::ios::badbit);
+		machine->error.clear();
+
+		try {
+			machine->machine.get()->set_streams(streams);
+			machine->machine.get()->init();
+			machine->machine.get()->run();
+		}
+		catch(InstructionLimitGraphicMachineException const& ex) {
+			status = BRAINLOLLER_INSTRUCTION_LIMIT;
+			machine->error = ex.what();
+		}
+		catch(TimeLimitGraphicMachineException const& ex) {
+			status = BRAINLOLLER_TIME_LIMIT;
+			machine->error = ex.what();
+		}
+		catch(InfiniteLoopGraphicMachineException const& ex) {
+			status = BRAINLOLLER_INFINITE_LOOP;
+			machine->error = ex.what();
+		}
+		catch(TapeBoundsGraphicMachineException const& ex) {
+			status = BRAINLOLLER_TAPE_BOUNDS;
+			machine->error = ex.what();
+		}
+		catch(OutputGraphicMachineException const& ex) {
+			status = BRAINLOLLER_OUTPUT_REFUSED;
+			machine->error = ex.what();
+		}
+		catch(IMachineException const& ex) {
+			status = BRAINLOLLER_ERROR;
+			machine->error = ex.what();
+		}
+		catch(std::exception const& ex) {
+			status = BRAINLOLLER_ERROR;
+			machine->error = ex.what();
+		}
+		catch(...) {
+			status = BRAINLOLLER_ERROR;
+			machine->error = "Unknown exception!";
+		}
+
+		if(status != BRAINLOLLER_OUTPUT_REFUSED) {
+			try {
+				out.flush();
+			}
+			catch(OutputGraphicMachineException const& ex) {
+				status = BRAINLOLLER_OUTPUT_REFUSED;
+				machine->error = ex.what();
+			}
+			catch(...) {
+				status = BRAINLOLLER_ERROR;
+				machine->error = "Output can't be written!";
 			}
 		}
 
-		virtual void output(self::cell_t value) {
-			switch(this->ot) {
-			case OT_CHAR:
-				std::cout << value;
-				break;
-			case OT_HEX:
-				std::cout << std::uppercase
-						  << std::hex
-						  << std::setfill('0')
-						  << std::setw(2)
-						  << static_cast<boost::uint32_t>(value)
-						  << std::nouppercase
-						  << std::dec
-						  << std::setw(0);
-				break;
-			case OT_BOTH:
-				std::cout << value
-						  << "["
-						  << std::uppercase
-						  << std::hex
-						  << std::setfill('0')
-						  << std::setw(2)
-						  << static_cast<boost::uint32_t>(value)
-						  << "]"
-						  << std::nouppercase
-						  << std::dec
-						  << std::setw(0);
-				break;
-			case OT_NULL:
-			default:
-				break;
-			};
+		machine->machine.get()->set_streams(CONSOLE_STREAMS);
+
+		if(stats) {
+			tracing::counters_t const counters = machine->machine.get()->get_counters();
+
+			stats->executed = counters.executed;
+			stats->back_edges = counters.back_edges;
+			stats->bytes_in = counters.bytes_in;
+			stats->bytes_out = counters.bytes_out;
+			stats->tape_extent = counters.tape_extent;
 		}
-	private:
-		std::shared_ptr<IPrinter> printer;
-		std::shared_ptr<IIteratorMachine> im;
-		OutputType ot;
-	};
+
+		return status;
+	}
 
 	/// @brief
 	///
 	///
-	class GraphicMachineCreator : public IMachineCreator {
-	public:
-		/// @brief
-		///
-		///
-		explicit GraphicMachineCreator(std::shared_ptr<IPrinter> p,
-									   std::shared_ptr<IIteratorMachine> im,
-									   OutputType o)
-			: IMachineCreator(),
-			  printer(p),
-			  iterator_machine(im),
-			  ot(o) {
-		}
+	int brainloller_run_buffers(brainloller_machine* machine, void const* input, std::size_t input_size,
+								void* output, std::size_t output_size, std::size_t* written, brainloller_stats* stats) {
+		memory_io_t io = {static_cast<unsigned char const*>(input), input_size,
+						  static_cast<unsigned char*>(output), output_size, 0};
+		int const status = brainloller_run(machine, &memory_io_t::read, &memory_io_t::write, &io, stats);
 
-		/// @brief
-		///
-		///
-		virtual ~GraphicMachineCreator(void) noexcept {}
-		
-		/// @brief
-		///
-		///
-		virtual std::shared_ptr<IMachine> create(void) const {
-			return std::make_shared<GraphicMachine>(printer, iterator_machine, ot);
+		if(written) {
+			*written = io.written;
 		}
-	private:
-		std::shared_ptr<IPrinter> printer;
-		std::shared_ptr<IIteratorMachine> iterator_machine;
-		OutputType ot;
-	};
-} // namespace
 
+		return status;
+	}
+
+	/// @brief
+	///
+	///
+	char const* brainloller_error(brainloller_machine const* machine) {
+		return (machine) ? machine->error.c_str() : "";
+	}
+
+	/// @brief
+	///
+	///
+	void brainloller_free(brainloller_machine* machine) {
+		delete machine;
+	}
+}
+
+#if !defined(BRAINLOLLER_LIBRARY)
 /// @brief
 ///
 ///
@@ -1124,7 +9926,7 @@ int main(int argc, char** argv) {
 		// Read options and set them value
 		[&argc, &argv]()->void{
 			int optc = 0;
-			while((optc = getopt_long(argc, argv, ":shvlf:p:o:i:", longopts, 0)) != -1) {
+			while((optc = getopt_long(argc, argv, ":shvlf:p:o:i:e:", longopts, 0)) != -1) {
 				switch(optc) {
 				case 's':
 					config.flag_show_variable = 1;
@@ -1158,6 +9960,116 @@ int main(int argc, char** argv) {
 						config.language = optarg;
 					}
 					break;
+				case 'e':
+					if(optarg!= nullptr) {
+						config.engine = optarg;
+					}
+					break;
+				case OPT_MAX_INSTRUCTIONS:
+					if(optarg!= nullptr) {
+						config.set_max_instructions(optarg);
+					}
+					break;
+				case OPT_MAX_TIME:
+					if(optarg!= nullptr) {
+						config.set_max_time(optarg);
+					}
+					break;
+				case OPT_CHECKPOINT:
+					if(optarg!= nullptr) {
+						config.checkpoint = optarg;
+					}
+					break;
+				case OPT_CHECKPOINT_INTERVAL:
+					if(optarg!= nullptr) {
+						config.set_checkpoint_interval(optarg);
+					}
+					break;
+				case OPT_RESTORE:
+					if(optarg!= nullptr) {
+						config.restore = optarg;
+					}
+					break;
+				case OPT_CACHE_DIR:
+					if(optarg!= nullptr) {
+						config.cache_dir = optarg;
+					}
+					break;
+				case OPT_PREFIX_BUDGET:
+					if(optarg!= nullptr) {
+						config.set_prefix_budget(optarg);
+					}
+					break;
+				case OPT_PROFILE:
+					if(optarg!= nullptr) {
+						config.profile = optarg;
+					}
+					break;
+				case OPT_SUPERINSTRUCTIONS:
+					if(optarg!= nullptr) {
+						config.superinstructions = optarg;
+					}
+					break;
+				case OPT_JIT_THRESHOLD:
+					if(optarg!= nullptr) {
+						config.set_jit_threshold(optarg);
+					}
+					break;
+				case OPT_VERIFY_INTERVAL:
+					if(optarg!= nullptr) {
+						config.set_verify_interval(optarg);
+					}
+					break;
+				case OPT_RECORD:
+					if(optarg!= nullptr) {
+						config.record = optarg;
+					}
+					break;
+				case OPT_REPLAY:
+					if(optarg!= nullptr) {
+						config.replay = optarg;
+					}
+					break;
+				case OPT_RECORD_INTERVAL:
+					if(optarg!= nullptr) {
+						config.set_record_interval(optarg);
+					}
+					break;
+				case OPT_CELL_SIZE:
+					if(optarg!= nullptr) {
+						config.set_cell_size(optarg);
+					}
+					break;
+				case OPT_ENCODE:
+					if(optarg!= nullptr) {
+						config.encode = optarg;
+					}
+					break;
+				case OPT_PRINT_FILE:
+					if(optarg!= nullptr) {
+						config.print_file = optarg;
+					}
+					break;
+				case OPT_TAPE_SIZE:
+					if(optarg!= nullptr) {
+						config.set_tape_size(optarg);
+					}
+					break;
+				case OPT_TAPE_ALLOCATOR:
+					if(optarg!= nullptr) {
+						config.tape_allocator = optarg;
+					}
+					break;
+				case OPT_DEBUG_INPUT:
+					if(optarg!= nullptr) {
+						config.debug_input = optarg;
+					}
+					break;
+				case OPT_TRACE:
+					if(optarg!= nullptr) {
+						config.trace = optarg;
+					}
+					break;
 				case 0:
 					break;
 				case ':':
@@ -1194,6 +10106,37 @@ int main(int argc, char** argv) {
 			std::cout << "\tprinter_type = " << config.printer_type << std::endl;
 			std::cout << "\toutput_type = " << config.output_type << std::endl;
 			std::cout << "\tlanguage = " << config.language << std::endl;
+			std::cout << "\tengine = " << config.engine << std::endl;
+			std::cout << "\tmax_instructions = " << config.max_instructions << std::endl;
+			std::cout << "\tmax_time = " << config.max_time << std::endl;
+			std::cout << "\tcheckpoint = " << config.checkpoint << std::endl;
+			std::cout << "\tcheckpoint_interval = " << config.checkpoint_interval << std::endl;
+			std::cout << "\trestore = " << config.restore << std::endl;
+			std::cout << "\tcache_dir = " << config.cache_dir << std::endl;
+			std::cout << "\tprefix_budget = " << config.prefix_budget << std::endl;
+			std::cout << "\tprofile = " << config.profile << std::endl;
+			std::cout << "\tsuperinstructions = " << config.superinstructions << std::endl;
+			std::cout << "\tjit_threshold = " << config.jit_threshold << std::endl;
+			std::cout << "\tcell_size = " << config.cell_size << std::endl;
+			std::cout << "\tencode = " << config.encode << std::endl;
+			std::cout << "\tprint_file = " << config.print_file << std::endl;
+			std::cout << "\ttape_size = " << config.tape_size << std::endl;
+			std::cout << "\ttape_allocator = " << config.tape_allocator << std::endl;
+			std::cout << "\tflag_numa = " << config.flag_numa << std::endl;
+			std::cout << "\tdebug_input = " << config.debug_input << std::endl;
+			std::cout << "\ttrace = " << config.trace << std::endl;
+			std::cout << "\tflag_perf_map = " << config.flag_perf_map << std::endl;
+			std::cout << "\tflag_stats = " << config.flag_stats << std::endl;
+			std::cout << "\tflag_perf_counters = " << config.flag_perf_counters << std::endl;
+			std::cout << "\tflag_hang_check = " << config.flag_hang_check << std::endl;
+			std::cout << "\tflag_async_io = " << config.flag_async_io << std::endl;
+			std::cout << "\tflag_watch = " << config.flag_watch << std::endl;
+			std::cout << "\tflag_checked = " << config.flag_checked << std::endl;
+			std::cout << "\tflag_verify = " << config.flag_verify << std::endl;
+			std::cout << "\tverify_interval = " << config.verify_interval << std::endl;
+			std::cout << "\trecord = " << config.record << std::endl;
+			std::cout << "\treplay = " << config.replay << std::endl;
+			std::cout << "\trecord_interval = " << config.record_interval << std::endl;
 			std::cout << "\toperands = " << ((config.operands.empty()) ? "(absense)" : "") << std::endl;
 
 			[]()->void {
@@ -1233,6 +10176,24 @@ int main(int argc, char** argv) {
 			usage();
 			::exit(EXIT_FAILURE);
 		}
+
+		if(!config.trace.empty()) {
+			tracing::enabled = true;
+			std::atexit(save_trace);
+		}
+
+		if(config.flag_stats || config.flag_perf_counters) {
+			tracing::stats = true;
+			tracing::hardware = (config.flag_perf_counters != 0);
+			std::atexit(save_stats);
+		}
+
+		if(config.flag_async_io) {
+			asyncio::start();
+			std::atexit(asyncio::stop);
+		}
+
+		tracing::PerfMap::enabled = (config.flag_perf_map != 0);
 	}();
 
 	// Work
@@ -1243,6 +10204,56 @@ int main(int argc, char** argv) {
 		std::shared_ptr<IPrinter> printer; 
 		std::shared_ptr<IIteratorMachine> iterator_machine;
 		OutputType ot;
+		TapeAllocation ta;
+		std::shared_ptr<RunRecorder> recording;
+
+		// RU: Воспроизведение идёт с опциями записанного запуска, кроме движка и профилирования.
+		//     Ограничение времени не воспроизводимо: запуск, остановленный любым ограничением,
+		//     останавливается по числу инструкций на том же обратном переходе (все движки
+		//     считают инструкции одинаково, см. RunRecorder::replay_limit).
+		if(!config.replay.empty()) {
+			recording = std::make_shared<RunRecorder>();
+			if(!recording.get()->load(config.replay)) {
+				std::cerr << "Recording can't be read: break!" << std::endl;
+				::exit(EXIT_FAILURE);
+			}
+
+			config.output_type = recording.get()->output_type;
+			config.cell_size = recording.get()->cell_size;
+			config.tape_size = recording.get()->tape_size;
+			config.flag_checked = recording.get()->checked;
+			config.max_instructions = recording.get()->replay_limit();
+			config.max_time = 0;
+			config.flag_hang_check = (!recording.get()->stopped() && recording.get()->hang_check);
+			config.prefix_budget = recording.get()->prefix_budget;
+			config.jit_threshold = recording.get()->jit_threshold;
+			config.record_interval = recording.get()->interval;
+		}
+
+		if((!config.record.empty() || recording) &&
+		   (config.flag_watch || config.flag_verify || !config.restore.empty())) {
+			std::cerr << "Runs with '--watch', '--verify' or '--restore' can't be recorded or replayed: break!" << std::endl;
+			usage();
+			::exit(EXIT_FAILURE);
+		}
+
+		if(!config.cell_size) {
+			std::cerr << "Cell size is zero: break!" << std::endl;
+			usage();
+			::exit(EXIT_FAILURE);
+		}
+
+		if(!config.encode.empty()) {
+			try {
+				BrainlollerEncoder(config.cell_size).encode(filename, config.encode);
+			}
+			catch(IMachineException const& ex) {
+				std::cerr << "Exception! " << ex.what() << std::endl;
+				::exit(EXIT_FAILURE);
+			}
+
+			return;
+		}
 
 		if(!config.language.compare(LANGUAGE_BRAINFUCK)) {
 			std::cerr << "This language is not supporting in current version! Sorry!: break!" << std::endl;
@@ -1250,7 +10261,7 @@ int main(int argc, char** argv) {
 			::exit(EXIT_FAILURE);
 		}
 		else if(!config.language.compare(LANGUAGE_BRAINLOLLER)) {
-			iterator_machine = std::make_shared<GraphicIteratorMachine>(filename);
+			iterator_machine = std::make_shared<GraphicIteratorMachine>(filename, config.cell_size);
 		}
 		else {
 			std::cerr << "Uncorrect language name: break!" << std::endl;
@@ -1294,28 +10305,306 @@ int main(int argc, char** argv) {
 			::exit(EXIT_FAILURE);
 		}
 		
-		creator = std::make_shared<GraphicMachineCreator>(printer, iterator_machine, ot);
+		if(!config.tape_allocator.compare(TAPE_ALLOCATOR_DEFAULT)) {
+			ta = TA_DEFAULT;
+		}
+		else if(!config.tape_allocator.compare(TAPE_ALLOCATOR_ALIGNED)) {
+			ta = TA_ALIGNED;
+		}
+		else if(!config.tape_allocator.compare(TAPE_ALLOCATOR_HUGEPAGES)) {
+			ta = TA_HUGEPAGES;
+		}
+		else if(!config.tape_allocator.compare(TAPE_ALLOCATOR_HUGETLB)) {
+			ta = TA_HUGETLB;
+		}
+		else {
+			std::cerr << "Uncorrect tape allocator: break!" << std::endl;
+			usage();
+			::exit(EXIT_FAILURE);
+		}
+
+		MachineLimits const limits = {config.max_instructions, config.max_time, config.flag_hang_check != 0};
+		CheckpointOptions const checkpoint = {config.checkpoint, config.restore, config.checkpoint_interval};
+		TapeOptions const tape = {config.tape_size, ta, config.flag_numa != 0, config.flag_checked != 0};
+		DebuggerOptions const debugger = {config.debug_input};
+		CompilerOptions const compiler = {config.cache_dir, config.prefix_budget, config.profile, config.superinstructions,
+										  config.jit_threshold};
+
+		if(!checkpoint.filename.empty()) {
+			std::signal(SIGUSR1, checkpoint_signal_handler);
+		}
+
+		// RU: Проверка движка: каждый файл (или каждый файл каталога) запускается дважды -
+		//     эталонным движком и проверяемым - на одном и том же входе
+		if(config.flag_verify) {
+			MachineLimits const shadow_limits = {config.max_instructions, config.max_time, false};
+			CheckpointOptions const no_checkpoint = {std::string(), std::string(), 0};
+			// RU: Лента всегда проверяется: программа, ушедшая с ленты, - строка FAILED, а не падение
+			TapeOptions const shadow_tape = {config.tape_size, ta, config.flag_numa != 0, true};
+			std::string const input((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+			std::vector<std::string> const files = utils::list_files(filename);
+			int status = EXIT_SUCCESS;
+
+			if(config.engine.compare(ENGINE_TYPE_COMPILED) && config.engine.compare(ENGINE_TYPE_THREADED) &&
+			   config.engine.compare(ENGINE_TYPE_TIERED)) {
+				std::cerr << "Only compiled, threaded and tiered engines can be verified: break!" << std::endl;
+				usage();
+				::exit(EXIT_FAILURE);
+			}
+
+			std::for_each(files.begin(), files.end(), [&](std::string const& f)->void {
+					std::shared_ptr<IIteratorMachine> const im = std::make_shared<GraphicIteratorMachine>(f, config.cell_size);
+					std::shared_ptr<IMachineCreator> const reference =
+						std::make_shared<GraphicMachineCreator>(printer, im, OT_CHAR, shadow_limits, no_checkpoint, shadow_tape);
+					std::shared_ptr<IMachineCreator> engine;
+
+					if(!config.engine.compare(ENGINE_TYPE_COMPILED)) {
+						engine = std::make_shared<CompiledGraphicMachineCreator>(printer, im, OT_CHAR, shadow_limits, no_checkpoint, shadow_tape, compiler);
+					}
+					else if(!config.engine.compare(ENGINE_TYPE_THREADED)) {
+						engine = std::make_shared<ThreadedGraphicMachineCreator>(printer, im, OT_CHAR, shadow_limits, no_checkpoint, shadow_tape, compiler);
+					}
+					else {
+						engine = std::make_shared<TieredGraphicMachineCreator>(printer, im, OT_CHAR, shadow_limits, no_checkpoint, shadow_tape, compiler);
+					}
+
+					switch(ShadowVerifier(reference, engine, im, config.verify_interval).verify(f, input, std::cout)) {
+					case EXIT_DIVERGED:
+						status = EXIT_DIVERGED;
+						break;
+					case EXIT_FAILURE:
+						if(status == EXIT_SUCCESS) {
+							status = EXIT_FAILURE;
+						}
+						break;
+					default:
+						break;
+					}
+				});
+
+			::exit(status);
+		}
+
+		if(!config.engine.compare(ENGINE_TYPE_REFERENCE)) {
+			creator = std::make_shared<GraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape);
+		}
+		else if(!config.engine.compare(ENGINE_TYPE_COMPILED)) {
+			creator = std::make_shared<CompiledGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else if(!config.engine.compare(ENGINE_TYPE_THREADED)) {
+			creator = std::make_shared<ThreadedGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else if(!config.engine.compare(ENGINE_TYPE_DEBUG)) {
+			creator = std::make_shared<DebugGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, debugger);
+		}
+		else if(!config.engine.compare(ENGINE_TYPE_TIERED)) {
+			creator = std::make_shared<TieredGraphicMachineCreator>(printer, iterator_machine, ot, limits, checkpoint, tape, compiler);
+		}
+		else {
+			std::cerr << "Uncorrect engine type: break!" << std::endl;
+			usage();
+			::exit(EXIT_FAILURE);
+		}
 		
 		std::shared_ptr<IMachine> m = creator.get()->create();
-		
-		try {
-			if(config.flag_print) {
-				m.get()->init();
-				m.get()->print();
+		std::shared_ptr<utils::FileWatcher> watcher;
+		std::shared_ptr<RunRecorder> recorder;
+		std::istringstream replay_input;
+
+		// RU: Запись подключается к чтению машины: её буферизованный ввод не меняется, к
+		//     каждому прочитанному значению добавляются только пара байт в памяти
+		if(!config.record.empty() || recording) {
+			std::shared_ptr<GraphicMachine> const g = std::dynamic_pointer_cast<GraphicMachine>(m);
+
+			recorder = std::make_shared<RunRecorder>();
+			recorder.get()->image = iterator_machine.get()->get_hash();
+			recorder.get()->engine = config.engine;
+			recorder.get()->output_type = config.output_type;
+			recorder.get()->cell_size = config.cell_size;
+			recorder.get()->tape_size = config.tape_size;
+			recorder.get()->checked = (config.flag_checked != 0);
+			recorder.get()->max_instructions = config.max_instructions;
+			recorder.get()->max_time = config.max_time;
+			recorder.get()->hang_check = (config.flag_hang_check != 0);
+			recorder.get()->prefix_budget = config.prefix_budget;
+			recorder.get()->jit_threshold = config.jit_threshold;
+			recorder.get()->interval = config.record_interval;
+
+			if(recording && recording.get()->image != recorder.get()->image) {
+				std::cerr << "Recording is of another program: break!" << std::endl;
+				::exit(EXIT_FAILURE);
+			}
+
+			// RU: События контрольных сумм - циклы, оставшиеся циклами в IR (см. ShadowTrace):
+			//     для эталонного движка программа компилируется только ради них
+			if(config.record_interval) {
+				std::vector<bool> loops;
+
+				if(recording) {
+					loops = recording.get()->trace.loops;
+				}
+				else {
+					std::shared_ptr<CompiledGraphicMachine> c = std::dynamic_pointer_cast<CompiledGraphicMachine>(m);
+
+					try {
+						if(!c) {
+							c = std::dynamic_pointer_cast<CompiledGraphicMachine>(
+								CompiledGraphicMachineCreator(printer, iterator_machine, ot, limits, checkpoint, tape, compiler).create());
+						}
+						c.get()->init();
+					}
+					catch(IMachineException const& ex) {
+						std::cerr << "Exception! " << ex.what() << std::endl;
+						::exit(EXIT_FAILURE);
+					}
+
+					loops = c.get()->get_program().stable_loops();
+				}
+
+				recorder.get()->trace = ShadowTrace(loops, config.record_interval);
+				g.get()->set_shadow(&recorder.get()->trace);
+			}
+
+			g.get()->set_recorder(recorder.get());
+
+			if(recording) {
+				MachineStreams const streams = {&replay_input, &std::cout, false};
+
+				replay_input.str(recording.get()->get_input());
+				g.get()->set_streams(streams);
+			}
+		}
+
+		// RU: Запись сохраняется, а воспроизведение сравнивается в конце запуска
+		auto const finished = [&](int status)->void {
+			if(!recorder) {
+				return;
+			}
+
+			recorder.get()->status = status;
+
+			if(!config.record.empty() && !recorder.get()->save(config.record)) {
+				std::cerr << "Recording can't be written: break!" << std::endl;
+				::exit(EXIT_FAILURE);
 			}
 
-			if(config.flag_run) {
-				m.get()->init();
-				m.get()->run();
+			if(recording && recording.get()->compare(*recorder.get(), config.replay, std::cerr) != EXIT_SUCCESS) {
+				::exit(EXIT_DIVERGED);
 			}
+		};
+
+		if(config.flag_watch) {
+			watcher = std::make_shared<utils::FileWatcher>(filename);
 		}
-		catch(IMachineException const& ex) {
-			std::cerr << "Exception! " << ex.what() << std::endl;
+
+		// RU: В режиме наблюдения ограничения только останавливают текущий запуск
+		for(;;) {
+			try {
+				if(config.flag_print) {
+					m.get()->init();
+
+					if(config.print_file.empty()) {
+						m.get()->print(std::cout);
+					}
+					else {
+						std::ofstream f(config.print_file.c_str(), std::ios::binary);
+
+						m.get()->print(f);
+						if(!f) {
+							std::cerr << "Print file can't be written: break!" << std::endl;
+							::exit(EXIT_FAILURE);
+						}
+					}
+				}
+
+				if(config.flag_run) {
+					m.get()->init();
+					m.get()->run();
+					finished(EXIT_SUCCESS);
+				}
+			}
+			catch(InstructionLimitGraphicMachineException const& ex) {
+				std::cout << std::endl;
+				std::cerr << "Stopped! " << ex.what() << std::endl;
+				finished(EXIT_INSTRUCTION_LIMIT);
+				if(!watcher) {
+					::exit(EXIT_INSTRUCTION_LIMIT);
+				}
+			}
+			catch(TimeLimitGraphicMachineException const& ex) {
+				std::cout << std::endl;
+				std::cerr << "Stopped! " << ex.what() << std::endl;
+				finished(EXIT_TIME_LIMIT);
+				if(!watcher) {
+					::exit(EXIT_TIME_LIMIT);
+				}
+			}
+			catch(InfiniteLoopGraphicMachineException const& ex) {
+				std::cout << std::endl;
+				std::cerr << "Stopped! " << ex.what() << std::endl;
+				finished(EXIT_INFINITE_LOOP);
+				if(!watcher) {
+					::exit(EXIT_INFINITE_LOOP);
+				}
+			}
+			catch(TapeBoundsGraphicMachineException const& ex) {
+				std::cout << std::endl;
+				std::cerr << "Stopped! " << ex.what() << std::endl;
+				finished(EXIT_TAPE_BOUNDS);
+				if(!watcher) {
+					::exit(EXIT_TAPE_BOUNDS);
+				}
+			}
+			catch(IMachineException const& ex) {
+				// RU: Например, контрольная точка не прочитана или снята с другого изображения
+				std::cerr << "Exception! " << ex.what() << std::endl;
+				finished(EXIT_FAILURE);
+				if(!watcher) {
+					::exit(EXIT_FAILURE);
+				}
+			}
+
+			if(!watcher) {
+				break;
+			}
+
+			std::cout.flush();
+			std::cerr << "Watching " << filename << "..." << std::endl;
+
+			// RU: Программа перекомпилируется, только если изменились её операции; иначе
+			//     машина (и скомпилированная программа с парами скобок) используется снова
+			for(;;) {
+				watcher.get()->wait();
+
+				try {
+					bool const changed = iterator_machine.get()->reload();
+					std::shared_ptr<GraphicIteratorMachine> const gim =
+						std::dynamic_pointer_cast<GraphicIteratorMachine>(iterator_machine);
+
+					if(gim) {
+						std::pair<boost::uint32_t, boost::uint32_t> const bands = gim.get()->get_decoded();
+
+						std::cerr << "Reloaded: " << bands.first << " of " << bands.second << " bands decoded, "
+								  << gim.get()->get_reused() << " of " << gim.get()->get_size() << " steps reused"
+								  << (changed ? "" : ", program is the same") << std::endl;
+					}
+
+					if(changed) {
+						m = creator.get()->create();
+					}
+
+					break;
+				}
+				catch(IMachineException const& ex) {
+					std::cerr << "Exception! " << ex.what() << std::endl;
+				}
+			}
 		}
 	}();
 	
 	return EXIT_SUCCESS;
 }
+#endif // !defined(BRAINLOLLER_LIBRARY)
 
 #undef UNUSED_SUPPRESSOR
 